@@ -1,47 +1,124 @@
 #pragma once
 #include "bst.h"
+#include "index_file.h"
 using namespace std;
 
 /**
  * AVL (self-balancing) Binary Search Tree
  */
-template<typename K, typename V>
-class AVLTree : public BST<K, V> {
+template<typename K, typename V, typename Compare = less<K>, typename Storage = SharedNodeStorage, typename Augment = NoAugmentation>
+class AVLTree : public BST<K, V, Compare, Storage, Augment> {
 private:
-    using BSTNode = typename BST<K, V>::BSTNode;
+    using BSTNode = typename BST<K, V, Compare, Storage, Augment>::BSTNode;
+    using NodePtr = typename BST<K, V, Compare, Storage, Augment>::NodePtr;
+    using ParentPtr = typename BST<K, V, Compare, Storage, Augment>::ParentPtr;
+    using SubtreeTask = typename BST<K, V, Compare, Storage, Augment>::SubtreeTask;
     
     // Students must implement these rotation methods
-    shared_ptr<BSTNode> rotateLeft(shared_ptr<BSTNode> node);
-    shared_ptr<BSTNode> rotateRight(shared_ptr<BSTNode> node);
-    shared_ptr<BSTNode> rotateLeftRight(shared_ptr<BSTNode> node);
-    shared_ptr<BSTNode> rotateRightLeft(shared_ptr<BSTNode> node);
+    NodePtr rotateLeft(NodePtr node);
+    NodePtr rotateRight(NodePtr node);
+    NodePtr rotateLeftRight(NodePtr node);
+    NodePtr rotateRightLeft(NodePtr node);
     
     // AVL-specific helper methods
-    int getBalanceFactor(shared_ptr<BSTNode> node) const;
-    shared_ptr<BSTNode> rebalance(shared_ptr<BSTNode> node);
-    shared_ptr<BSTNode> insertAVL(shared_ptr<BSTNode> node, const K& key, const V& value);
-    shared_ptr<BSTNode> removeAVL(shared_ptr<BSTNode> node, const K& key);
+    int getBalanceFactor(NodePtr node) const;
+    NodePtr rebalance(NodePtr node);
+    // Single-descent mutations: an equal key is reported through the
+    // inserted/removed flag instead of being probed with find() first.
+    template<typename MakeNode, typename OnExisting>
+    NodePtr insertAVL(NodePtr node, const K& key, MakeNode& makeNode, OnExisting& onExisting, bool& inserted);
+    NodePtr removeAVL(NodePtr node, const K& key, bool& removed);
+    NodePtr removeMinAVL(NodePtr node, NodePtr& minNode);
+    template<typename MakeNode, typename OnExisting>
+    bool insertWith(const K& key, MakeNode makeNode, OnExisting onExisting);
+    NodePtr buildBalanced(vector<pair<K, V>>& items, size_t lo, size_t hi);
+    // Batch helpers: unhook every node in key order, then relink a sorted run of nodes
+    vector<NodePtr> detachInOrder();
+    NodePtr linkBalanced(vector<NodePtr>& nodes, size_t lo, size_t hi);
+
+    // Join/split building blocks. joinAVL links left < middle < right into one
+    // balanced tree in O(|height(left) - height(right)|); splitAVL cuts a tree
+    // into (keys on the left side, the rest) in O(log n).
+    NodePtr joinAVL(NodePtr left, NodePtr middle, NodePtr right);
+    NodePtr joinAVL(NodePtr left, NodePtr right);
+    pair<NodePtr, NodePtr> splitAVL(NodePtr node, const K& key, bool keepEqualLeft);
 
 public:
     AVLTree();
-    AVLTree(function<bool(const K&, const K&)> comp);
+    explicit AVLTree(Compare comp);
     
     // Override BST methods to maintain AVL property
     // Students must implement these methods
     bool insert(const K& key, const V& value) override;
+    bool insert(K&& key, V&& value);
     bool remove(const K& key) override;
+
+    // Insert, or overwrite the value of an existing key. True if inserted.
+    template<typename M>
+    bool insert_or_assign(const K& key, M&& value);
+    template<typename M>
+    bool insert_or_assign(K&& key, M&& value);
+
+    // Construct the value in place only if the key is absent. True if inserted.
+    template<typename... Args>
+    bool try_emplace(const K& key, Args&&... args);
+    template<typename... Args>
+    bool try_emplace(K&& key, Args&&... args);
+    
+    // Bulk load: replaces the contents with a perfectly balanced tree.
+    // buildFromSorted is O(n) and expects entries ascending by key (for equal
+    // keys the first wins, a descending key throws std::invalid_argument);
+    // buildFrom accepts any order and sorts first.
+    template<typename InputIt>
+    void buildFromSorted(InputIt first, InputIt last);
+    template<typename InputIt>
+    void buildFrom(InputIt first, InputIt last);
+
+    // Binary snapshot in key order (layout in index_file.h). loadBinary
+    // rebuilds through buildFromSorted in O(n) and leaves the tree untouched
+    // if the file is missing or does not hold StoredKey -> StoredValue
+    // entries. Keys and values are stored as they are unless encode/decode
+    // functions map them to a storable type (see StoreAsIs).
+    template<typename EncodeValue = StoreAsIs, typename EncodeKey = StoreAsIs>
+    bool saveBinary(const string& path, EncodeValue encodeValue = EncodeValue(), EncodeKey encodeKey = EncodeKey()) const;
+    template<typename StoredValue = V, typename StoredKey = K, typename DecodeValue = StoreAsIs, typename DecodeKey = StoreAsIs>
+    bool loadBinary(const string& path, DecodeValue decodeValue = DecodeValue(), DecodeKey decodeKey = DecodeKey());
+
+    // Batch updates. The batch is sorted, then either applied key by key
+    // (O(m log n), small batches) or merged with the in-order node sequence
+    // and relinked into a balanced tree (O(n + m), no node reallocated),
+    // whichever is cheaper for the batch-to-tree size ratio.
+    // result[i] tells whether entries[i] / keys[i] took effect; for equal
+    // keys within one batch the first occurrence wins.
+    vector<bool> insertBatch(vector<pair<K, V>> entries);
+    vector<bool> removeBatch(vector<K> keys);
+    
+    // Range transfer, each O(log n):
+    // split moves every key >= key into the returned tree;
+    // join appends right (all keys greater than ours) and leaves it empty;
+    // removeRange drops every key in [minKey, maxKey] and returns how many.
+    AVLTree split(const K& key);
+    void join(AVLTree& right);
+    size_t removeRange(const K& minKey, const K& maxKey);
     
     // AVL-specific methods
     bool isBalanced() const;
-    int getMaxDepth() const;
-    double getAverageDepth() const;
+    int getMaxDepth() const;         // the root is at depth 1, so this equals getTreeHeight()
+    double getAverageDepth() const;  // nodes an average successful find visits
+    int getMaxDepth(ThreadPool& threads) const;
+    double getAverageDepth(ThreadPool& threads) const;
     
     // Validation methods for testing
     bool isValidAVL() const;
+    // Parallel forms of the whole-tree walks above, one task per subtree
+    // (see BST::splitForTasks). The tree must not change meanwhile.
+    bool isValidAVL(ThreadPool& threads) const;
     
 private:
-    bool isValidAVLHelper(shared_ptr<BSTNode> node) const;
-    void calculateDepthStats(shared_ptr<BSTNode> node, int depth, int& totalDepth, int& nodeCount, int& maxDepth) const;
+    bool isValidAVLHelper(NodePtr node) const;
+    bool validNode(const NodePtr& node) const;  // links, height, size and balance of node alone
+    void calculateDepthStats(NodePtr node, int depth, long long& totalDepth, size_t& nodeCount, int& maxDepth) const;
+    void calculateDepthStats(ThreadPool& threads, long long& totalDepth, size_t& nodeCount, int& maxDepth) const;
 };
 
 #include "../solution/avl_tree.cpp"
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "edit_distance.h"
+using namespace std;
+
+/**
+ * Burkhard-Keller tree: string keys indexed by their distance under a
+ * metric (Levenshtein by default), for "every key within distance k" queries.
+ *
+ * Each child hangs off its parent under its distance to the parent's key.
+ * By the triangle inequality, a key within k of the query can only sit below
+ * a child whose edge lies within k of the query's distance to the parent, so
+ * a search computes distances for a fraction of the keys rather than all of
+ * them: on usernames, from well under 1% of the names at k = 1 to a few
+ * percent at k = 3.
+ *
+ * The Metric is called as metric(a, b) and metric.prepare(query), which
+ * returns a scorer offering distance(key, maxDistance) (exact up to
+ * maxDistance, anything larger past it), distances(keys, count, out) and
+ * batchWidth(); see MyersPattern. A search scores its frontier batchWidth()
+ * nodes at a time.
+ *
+ * The shape depends only on insertion order. Removal only marks a node dead
+ * (it still routes searches); once dead nodes outnumber live ones the tree
+ * is rebuilt from the live entries.
+ */
+template<typename V, typename Metric = LevenshteinDistance>
+class BKTree {
+public:
+    explicit BKTree(Metric metric = Metric()) : metric(std::move(metric)), live(0) {}
+
+    bool insert(string_view key, const V& value);  // false if key is already present
+    bool remove(string_view key);
+    const V* find(string_view key) const;
+
+    size_t size() const { return live; }
+    bool empty() const { return live == 0; }
+    size_t nodeCount() const { return nodes.size(); }  // dead nodes included
+    void clear();
+
+    // Calls visit(value, distance) for every key within maxDistance of query,
+    // in no particular order. Returns how many distances it computed.
+    template<typename Visitor>
+    size_t forEachWithin(string_view query, int maxDistance, Visitor visit) const;
+    // Best-first form for ranked searches: subtrees are taken in order of
+    // their lower bound (the |distance - edge| of their edges), and
+    // visit(value, distance) returns the largest distance still wanted, at
+    // most maxDistance. Subtrees that cannot come within it are skipped, and
+    // the search ends once none pending can. Returns distances computed.
+    template<typename Visitor>
+    size_t forEachNearest(string_view query, int maxDistance, Visitor visit) const;
+
+    // Every edge equals the metric between its endpoints, edges are sorted, counts match
+    bool isValid() const;
+
+private:
+    struct Node {
+        string key;
+        V value;
+        bool live;
+        vector<pair<int, uint32_t>> children;  // (distance to key, node index), ascending by distance
+    };
+
+    Metric metric;
+    vector<Node> nodes;  // nodes[0] is the root; indices stay valid as the vector grows
+    size_t live;
+
+    int findIndex(string_view key) const;  // node holding key, live or dead, or -1
+    void rebuild();
+};
+
+#include "../solution/bk_tree.cpp"
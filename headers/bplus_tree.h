@@ -0,0 +1,224 @@
+#pragma once
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include "bst.h"
+#include "index_file.h"
+using namespace std;
+
+/**
+ * B+ tree with the same lookup / update surface as BST and AVLTree.
+ *
+ * Every node holds up to CAPACITY sorted keys, sized so a node's keys span a
+ * few cache lines: a search touches ~log_CAPACITY(n) nodes instead of one
+ * node per binary level. Values live only in the leaves, and the leaves are
+ * chained so range scans walk contiguous arrays. Nodes are allocated from
+ * ArenaNodeStorage pools; K and V must be default-constructible.
+ */
+template<typename K, typename V, typename Compare = less<K>>
+class BPlusTree : protected ComparatorBase<Compare> {
+public:
+    static constexpr size_t NODE_BYTES = 256;  // four 64-byte cache lines of keys per node
+    static constexpr int CAPACITY = std::max<int>(8, NODE_BYTES / sizeof(K));
+    static constexpr int MIN_KEYS = CAPACITY / 2;  // for every node but the root
+
+private:
+    struct Node {
+        bool leaf;
+        int count;     // keys in this node
+        size_t total;  // entries in this subtree, for rank/select
+        explicit Node(bool leaf) : leaf(leaf), count(0), total(0) {}
+    };
+    // Arrays keep one spare slot so an insert can overflow before the node splits
+    struct LeafNode : Node {
+        K keys[CAPACITY + 1];
+        V values[CAPACITY + 1];
+        LeafNode* prev;
+        LeafNode* next;
+        LeafNode() : Node(true), prev(nullptr), next(nullptr) {}
+    };
+    struct InnerNode : Node {
+        K keys[CAPACITY + 1];            // keys[i] is the smallest key under children[i + 1]
+        Node* children[CAPACITY + 2];
+        InnerNode() : Node(false) {}
+    };
+
+    Node* root;
+    size_t entryCount;
+    ArenaNodeStorage::Pool<LeafNode> leafPool;
+    ArenaNodeStorage::Pool<InnerNode> innerPool;
+
+    bool comparator(const K& a, const K& b) const { return this->keyCompare()(a, b); }
+    template<typename A, typename B>  // a heterogeneous probe against a stored key
+    bool comparator(const A& a, const B& b) const { return TransparentCompare<Compare>::get(this->keyCompare())(a, b); }
+    template<typename Key>
+    using EnableIfHeterogeneous = enable_if_t<TransparentCompare<Compare>::value && !is_same<decay_t<Key>, K>::value>;
+
+    // Descent helpers, templated so K and heterogeneous lookups share them
+    template<typename Key>
+    int lowerSlot(const K* keys, int count, const Key& key) const;  // first slot with keys[i] >= key
+    template<typename Key>
+    int upperSlot(const K* keys, int count, const Key& key) const;  // first slot with keys[i] > key
+    template<typename Key>
+    const LeafNode* findLeaf(const Key& key) const;
+    template<typename Key>
+    const V* findValue(const Key& key) const;
+    const LeafNode* firstLeaf() const;
+    const LeafNode* lastLeaf() const;
+    size_t countLess(const K& key, bool inclusive) const;
+
+    template<typename MakeValue>
+    Node* insertHelper(Node* node, const K& key, MakeValue& makeValue, bool& inserted, K& splitKey);
+    template<typename MakeValue>
+    bool insertWith(const K& key, MakeValue makeValue);
+    bool removeHelper(Node* node, const K& key);
+    void fixUnderflow(InnerNode* parent, int index);
+    void eraseChild(InnerNode* parent, int keyIndex);  // drops keys[keyIndex] and children[keyIndex + 1]
+    void destroySubtree(Node* node);
+    bool isValidHelper(const Node* node, const K* lower, const K* upper, int depth, int& leafDepth) const;
+
+public:
+    BPlusTree();
+    explicit BPlusTree(Compare comp);
+    BPlusTree(const BPlusTree&) = delete;
+    BPlusTree& operator=(const BPlusTree&) = delete;
+    BPlusTree(BPlusTree&& other);
+    BPlusTree& operator=(BPlusTree&& other);
+    ~BPlusTree();
+
+    bool insert(const K& key, const V& value);
+    template<typename... Args>
+    bool try_emplace(const K& key, Args&&... args);  // constructs the value only if the key is absent
+    bool remove(const K& key);
+    V* find(const K& key);
+    const V* find(const K& key) const;
+
+    pair<K, V> min() const;
+    pair<K, V> max() const;
+    vector<pair<K, V>> findRange(const K& minKey, const K& maxKey) const;
+
+    size_t size() const { return entryCount; }
+    bool empty() const { return entryCount == 0; }
+    void clear();
+    int getTreeHeight() const;  // levels, a lone leaf is 1
+
+    // Order statistics, O(height * CAPACITY) using the per-node subtree totals
+    size_t rank(const K& key) const;
+    pair<K, V> select(size_t index) const;
+    size_t countRange(const K& minKey, const K& maxKey) const;
+    vector<pair<K, V>> sliceByRank(size_t offset, size_t limit) const;
+
+    // Iteration walks the leaf chain. it->key / it->value refer into the leaf.
+    struct EntryRef {
+        const K& key;
+        const V& value;
+        const EntryRef* operator->() const { return this; }
+    };
+    class const_iterator;
+    const_iterator begin() const;
+    const_iterator end() const;
+    const_iterator lower_bound(const K& key) const;
+    const_iterator upper_bound(const K& key) const;
+    pair<const_iterator, const_iterator> equal_range(const K& key) const;
+
+    template<typename Visitor>
+    void forEachInRange(const K& minKey, const K& maxKey, Visitor visit) const;
+
+    // Finger search for runs of nearby keys, as BST::Cursor (see Cursor)
+    class Cursor;
+    Cursor cursor() const;
+
+    // Heterogeneous lookups, as BST::find(const Key&) and friends
+    template<typename Key, typename = EnableIfHeterogeneous<Key>>
+    V* find(const Key& key) { return const_cast<V*>(findValue(key)); }
+    template<typename Key, typename = EnableIfHeterogeneous<Key>>
+    const V* find(const Key& key) const { return findValue(key); }
+    template<typename Key, typename = EnableIfHeterogeneous<Key>>
+    const_iterator lower_bound(const Key& key) const { return boundAt(key, false); }
+    template<typename Key, typename = EnableIfHeterogeneous<Key>>
+    const_iterator upper_bound(const Key& key) const { return boundAt(key, true); }
+    template<typename Key, typename = EnableIfHeterogeneous<Key>>
+    vector<pair<K, V>> findRange(const Key& minKey, const Key& maxKey) const;
+
+    // Bulk load in O(n) from entries ascending by key (for equal keys the first
+    // wins, a descending key throws std::invalid_argument)
+    template<typename InputIt>
+    void buildFromSorted(InputIt first, InputIt last);
+
+    // Binary snapshot, as AVLTree::saveBinary/loadBinary (same file layout)
+    template<typename EncodeValue = StoreAsIs, typename EncodeKey = StoreAsIs>
+    bool saveBinary(const string& path, EncodeValue encodeValue = EncodeValue(), EncodeKey encodeKey = EncodeKey()) const;
+    template<typename StoredValue = V, typename StoredKey = K, typename DecodeValue = StoreAsIs, typename DecodeKey = StoreAsIs>
+    bool loadBinary(const string& path, DecodeValue decodeValue = DecodeValue(), DecodeKey decodeKey = DecodeKey());
+
+    // Batch updates, as AVLTree::insertBatch/removeBatch: key by key for small
+    // batches, otherwise merged with the leaf chain and bulk loaded.
+    vector<bool> insertBatch(vector<pair<K, V>> entries);
+    vector<bool> removeBatch(vector<K> keys);
+
+    vector<pair<K, V>> inOrderTraversal() const;
+
+    // Key order, separators, fill factor, uniform leaf depth, totals and leaf links
+    bool isValid() const;
+
+private:
+    template<typename Key>
+    const_iterator boundAt(const Key& key, bool upper) const;  // lower_bound, or upper_bound if upper
+};
+
+/**
+ * Bidirectional iterator over the leaf chain. Insert/remove invalidates iterators.
+ */
+template<typename K, typename V, typename Compare>
+class BPlusTree<K, V, Compare>::const_iterator {
+public:
+    using iterator_category = bidirectional_iterator_tag;
+    using value_type = EntryRef;
+    using difference_type = ptrdiff_t;
+    using pointer = EntryRef;
+    using reference = EntryRef;
+
+    const_iterator() : tree(nullptr), leaf(nullptr), index(0) {}
+    const_iterator(const BPlusTree* tree, const LeafNode* leaf, int index) : tree(tree), leaf(leaf), index(index) {}
+
+    reference operator*() const { return EntryRef{leaf->keys[index], leaf->values[index]}; }
+    pointer operator->() const { return **this; }
+    const_iterator& operator++();
+    const_iterator operator++(int) { const_iterator old = *this; ++*this; return old; }
+    const_iterator& operator--();  // --end() is the maximum
+    const_iterator operator--(int) { const_iterator old = *this; --*this; return old; }
+    bool operator==(const const_iterator& other) const { return leaf == other.leaf && index == other.index; }
+    bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+private:
+    const BPlusTree* tree;
+    const LeafNode* leaf;  // nullptr means end()
+    int index;
+};
+
+/**
+ * Finger search over the leaf chain, the B+ counterpart of BST::Cursor: a
+ * seek first tries the leaf the last one ended in and that leaf's
+ * neighbours, and only descends from the root when the key is further
+ * away. Insert/remove invalidates a cursor; reset() starts over.
+ */
+template<typename K, typename V, typename Compare>
+class BPlusTree<K, V, Compare>::Cursor {
+public:
+    explicit Cursor(const BPlusTree& tree) : tree(&tree), finger(nullptr) {}
+
+    template<typename Key>
+    const V* seek(const Key& key);  // value stored under key, or nullptr
+    template<typename Key>
+    const_iterator seekLowerBound(const Key& key);  // first entry with key >= key
+    void reset() { finger = nullptr; }
+
+private:
+    const BPlusTree* tree;
+    const LeafNode* finger;  // leaf the last seek ended in; nullptr starts at the root
+
+    template<typename Key>
+    bool covers(const LeafNode* leaf, const Key& key) const;  // key's lower bound is in leaf, or first in the next one
+};
+
+#include "../solution/bplus_tree.cpp"
@@ -1,45 +1,224 @@
 #pragma once
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <vector>
 #include <iostream>
+#include <iterator>
+#include <type_traits>
+#include "node_storage.h"
+#include "thread_pool.h"
 using namespace std;
 
+/**
+ * Opt-in adapter for a comparator picked at runtime: BST<K, V, DynamicCompare<K>>
+ * accepts any callable, at the price of an indirect call per comparison.
+ */
+template<typename K>
+using DynamicCompare = function<bool(const K&, const K&)>;
+
+/**
+ * Holds the key comparator. Deriving from it instead of storing a member lets
+ * a stateless Compare (less<K>) take no space, and its operator() inlines.
+ */
+template<typename Compare>
+class ComparatorBase : private Compare {
+protected:
+    ComparatorBase() = default;
+    explicit ComparatorBase(Compare comp) : Compare(std::move(comp)) {}
+    const Compare& keyCompare() const { return *this; }
+    Compare& keyCompare() { return *this; }
+};
+
+/**
+ * Comparator behind heterogeneous lookups (find(string_view) on string keys).
+ * A Compare declaring is_transparent (less<>, or a custom one) orders mixed
+ * key types itself; less<K> orders exactly like less<>, so it is promoted to
+ * it. Any other Compare (e.g. DynamicCompare) only ever sees K.
+ */
+template<typename Compare, typename = void>
+struct TransparentCompare {
+    static constexpr bool value = false;
+};
+
+template<typename Compare>
+struct TransparentCompare<Compare, void_t<typename Compare::is_transparent>> {
+    static constexpr bool value = true;
+    static const Compare& get(const Compare& comp) { return comp; }
+};
+
+template<typename K>
+struct TransparentCompare<less<K>, enable_if_t<!is_void<K>::value>> {
+    static constexpr bool value = true;
+    static less<> get(const less<K>&) { return {}; }
+};
+
+/**
+ * Batch strategy shared by the trees' insertBatch/removeBatch: m single
+ * updates walk ~log2(n + m) levels each, a merge-and-rebuild touches each
+ * of the n + m entries once.
+ */
+inline bool batchPrefersRebuild(size_t batchSize, size_t treeSize) {
+    size_t levels = 1;
+    for (size_t total = treeSize + batchSize; total > 1; total >>= 1)
+        levels++;
+    return batchSize * levels >= treeSize;
+}
+
+/**
+ * Search and restructuring counters of a tree (getStats()).
+ * Compiled in with -DTREE_STATS; otherwise every hook is an empty inline
+ * function and the counters stay zero.
+ */
+#ifdef TREE_STATS
+constexpr bool treeStatsEnabled = true;
+#else
+constexpr bool treeStatsEnabled = false;
+#endif
+
+struct TreeStats {
+    size_t rotations = 0;        // every rotation, two per double
+    size_t singleRotations = 0;
+    size_t doubleRotations = 0;  // LR / RL, not also counted as two singles
+    size_t rebalanceCalls = 0;
+    size_t operations = 0;       // find / insert / remove calls
+    size_t comparisons = 0;      // key comparisons, validation walks included
+    size_t maxDescentDepth = 0;  // most nodes one operation descended through
+
+    double comparisonsPerOperation() const { return operations ? (double)comparisons / operations : 0.0; }
+};
+
+/**
+ * Augmentation policy: a Summary kept on every node for the node's subtree,
+ * so aggregateRange() can answer from O(log n) nodes. A policy provides
+ *   using Summary = ...;
+ *   static Summary identity();
+ *   static Summary fromEntry(const K& key, const V& value);
+ *   static Summary combine(const Summary& lower, const Summary& higher);
+ * combine must be associative; its arguments arrive in key order.
+ * NoAugmentation (the default) keeps an empty Summary.
+ */
+struct NoAugmentation {
+    struct Summary {};
+    static Summary identity() { return {}; }
+    template<typename K, typename V>
+    static Summary fromEntry(const K&, const V&) { return {}; }
+    static Summary combine(const Summary&, const Summary&) { return {}; }
+};
+
 /**
  * Binary Search Tree template class
+ *
+ * Compare is a compile-time comparator policy (less<K> by default).
+ * Storage selects how nodes are allocated and linked (see node_storage.h);
+ * the default keeps the shared_ptr/weak_ptr layout.
+ * Augment selects the per-subtree summary (see NoAugmentation).
  */
-template<typename K, typename V>
-class BST {
+template<typename K, typename V, typename Compare = less<K>, typename Storage = SharedNodeStorage, typename Augment = NoAugmentation>
+class BST : protected ComparatorBase<Compare> {
 public:
+    struct BSTNode;
+    using NodePtr = typename Storage::template NodePtr<BSTNode>;
+    using ParentPtr = typename Storage::template ParentPtr<BSTNode>;
+    using Summary = typename Augment::Summary;
+
     struct BSTNode {
         K key;
         V value;
-        shared_ptr<BSTNode> left;
-        shared_ptr<BSTNode> right;
-        weak_ptr<BSTNode> parent;
+        NodePtr left;
+        NodePtr right;
+        ParentPtr parent;
         int height;  // For AVL tree extension
-        
-        BSTNode(const K& k, const V& v) : key(k), value(v), left(nullptr), right(nullptr), height(1) {}
+        bool red;  // For RBTree, unused otherwise; fits in height's padding
+        Summary summary;  // Augment summary of this subtree; an empty one fits in height's padding
+        size_t subtreeSize;  // Nodes in this subtree, for rank/select
+
+        template<typename KArg, typename VArg>
+        BSTNode(KArg&& k, VArg&& v)
+            : key(std::forward<KArg>(k)), value(std::forward<VArg>(v)), left(nullptr), right(nullptr), parent(), height(1), red(true),
+              summary(Augment::fromEntry(key, value)), subtreeSize(1) {}
     };
 protected:    
-    shared_ptr<BSTNode> root;
+    NodePtr root;
     size_t nodeCount;
-    function<bool(const K&, const K&)> comparator;
+    mutable TreeStats stats;
+    mutable size_t statsDepth;  // nodes visited by the current operation
+
+    // TreeStats hooks, no-ops unless built with TREE_STATS
+    void statsOperation() const {
+        if constexpr (treeStatsEnabled) {
+            stats.operations++;
+            statsDepth = 0;
+        }
+    }
+    void statsRotation() const {
+        if constexpr (treeStatsEnabled)
+            stats.rotations++;
+    }
+    void statsVisit() const {
+        if constexpr (treeStatsEnabled)
+            stats.maxDescentDepth = std::max(stats.maxDescentDepth, ++statsDepth);
+    }
+
+    bool comparator(const K& a, const K& b) const {
+        if constexpr (treeStatsEnabled)
+            stats.comparisons++;
+        return this->keyCompare()(a, b);
+    }
+    template<typename A, typename B>  // a heterogeneous probe against a stored key
+    bool comparator(const A& a, const B& b) const {
+        if constexpr (treeStatsEnabled)
+            stats.comparisons++;
+        return TransparentCompare<Compare>::get(this->keyCompare())(a, b);
+    }
+    template<typename Key>  // lookups taking something other than K
+    using EnableIfHeterogeneous = enable_if_t<TransparentCompare<Compare>::value && !is_same<decay_t<Key>, K>::value>;
+    static Compare defaultComparator();
+    typename Storage::template Pool<BSTNode> pool;
+
+    template<typename KArg, typename VArg>
+    NodePtr createNode(KArg&& key, VArg&& value) { return pool.create(std::forward<KArg>(key), std::forward<VArg>(value)); }
+    void destroyNode(NodePtr node) { pool.destroy(node); }
+    void destroySubtree(NodePtr node);
     
     // Helper methods for students to implement
-    shared_ptr<BSTNode> insertHelper(shared_ptr<BSTNode> node, const K& key, const V& value);
-    shared_ptr<BSTNode> removeHelper(shared_ptr<BSTNode> node, const K& key);
-    shared_ptr<BSTNode> findHelper(shared_ptr<BSTNode> node, const K& key) const;
-    shared_ptr<BSTNode> findMinHelper(shared_ptr<BSTNode> node) const;
+    NodePtr insertHelper(NodePtr node, const K& key, const V& value);
+    NodePtr removeHelper(NodePtr node, const K& key);
+    NodePtr findHelper(NodePtr node, const K& key) const;
+    NodePtr findMinHelper(NodePtr node) const;
     
-    shared_ptr<BSTNode> findMaxHelper(shared_ptr<BSTNode> node) const;
-    void updateHeight(shared_ptr<BSTNode> node);  // For AVL extension
-    int getHeight(shared_ptr<BSTNode> node) const;
+    NodePtr findMaxHelper(NodePtr node) const;
+    void updateHeight(NodePtr node);  // For AVL extension, also refreshes subtreeSize and summary
+    void refreshPath(NodePtr from, const NodePtr& top);  // updateHeight from `from` up to top
+    // After node->value was overwritten: only a non-empty Summary can go stale
+    void valueChanged(NodePtr node) {
+        if (!std::is_empty<Summary>::value)
+            refreshPath(node, root);
+    }
+    int getHeight(NodePtr node) const;
+    size_t getSize(NodePtr node) const;
+    static Summary summaryOf(const BSTNode* node) { return node ? node->summary : Augment::identity(); }
+    static Summary entrySummary(const BSTNode* node) { return Augment::fromEntry(node->key, node->value); }
+    size_t countLess(const K& key, bool inclusive) const;
+
+    // Read-only walks use plain pointers so shared_ptr storage pays no refcounting
+    static BSTNode* rawNode(const NodePtr& node) { return node ? &*node : nullptr; }
+    static BSTNode* parentNode(const BSTNode* node);
+    template<typename Key>
+    BSTNode* findNode(const Key& key) const;
+    template<typename Key>
+    BSTNode* lowerBoundNode(const Key& key) const;  // first node with key >= key
+    template<typename Key>
+    BSTNode* upperBoundNode(const Key& key) const;  // first node with key > key
 
 public:
     BST();
-    BST(function<bool(const K&, const K&)> comp);
-    virtual ~BST() = default;
+    explicit BST(Compare comp);
+    BST(const BST&) = default;
+    BST& operator=(const BST&) = default;
+    BST(BST&& other);
+    BST& operator=(BST&& other);
+    virtual ~BST();
     
     // Students must implement these methods
     virtual bool insert(const K& key, const V& value);
@@ -53,27 +232,151 @@ public:
     
     size_t size() const { return nodeCount; }
     bool empty() const { return nodeCount == 0; }
+    void clear();
     int getTreeHeight() const { return getHeight(root); }
-    
+
+    // Restructuring and search-cost counters since construction or resetStats()
+    // (all zero unless built with -DTREE_STATS)
+    const TreeStats& getStats() const { return stats; }
+    void resetStats() { stats = TreeStats(); }
+
+    // Order statistics, O(height) each using the per-node subtree sizes
+    size_t rank(const K& key) const;              // number of keys < key
+    pair<K, V> select(size_t index) const;        // index-th smallest entry (0-based)
+    size_t countRange(const K& minKey, const K& maxKey) const;  // inclusive
+    vector<pair<K, V>> sliceByRank(size_t offset, size_t limit) const;
+
+    // Augment summaries. aggregateRange combines every entry in [minKey, maxKey]
+    // in O(height); refresh recomputes the path above key after its value's
+    // summary changed in place (e.g. through find()). False if key is absent.
+    Summary aggregate() const { return summaryOf(rawNode(root)); }
+    Summary aggregateRange(const K& minKey, const K& maxKey) const;
+    bool refresh(const K& key);
+
+    // Lazy in-order iteration, driven by the parent links (no allocation)
+    class const_iterator;
+    const_iterator begin() const;
+    const_iterator end() const;
+    const_iterator lower_bound(const K& key) const;
+    const_iterator upper_bound(const K& key) const;
+    pair<const_iterator, const_iterator> equal_range(const K& key) const;
+
+    // Heterogeneous lookups, as in std::map with a transparent comparator: any
+    // Key the comparator orders against K is compared in place, so string keys
+    // can be probed with a string_view or const char* without building a string.
+    template<typename Key, typename = EnableIfHeterogeneous<Key>>
+    V* find(const Key& key);
+    template<typename Key, typename = EnableIfHeterogeneous<Key>>
+    const V* find(const Key& key) const;
+    template<typename Key, typename = EnableIfHeterogeneous<Key>>
+    const_iterator lower_bound(const Key& key) const;
+    template<typename Key, typename = EnableIfHeterogeneous<Key>>
+    const_iterator upper_bound(const Key& key) const;
+    template<typename Key, typename = EnableIfHeterogeneous<Key>>
+    vector<pair<K, V>> findRange(const Key& minKey, const Key& maxKey) const;
+
+    // Visits keys in [minKey, maxKey] in order; the callback returns false to stop early
+    template<typename Visitor>
+    void forEachInRange(const K& minKey, const K& maxKey, Visitor visit) const;
+
+    // Finger search for runs of nearby keys (see Cursor)
+    class Cursor;
+    Cursor cursor() const;
+
     // Traversal methods
     vector<pair<K, V>> inOrderTraversal() const;
+    // Parallel form for large trees (see splitForTasks): every task copies its
+    // subtree straight into its slice of the preallocated result. The tree
+    // must not change meanwhile.
+    vector<pair<K, V>> inOrderTraversal(ThreadPool& threads) const;
     void displayTree() const;
     
     // For testing and debugging
     bool isValidBST() const;
-    shared_ptr<BSTNode> getRoot(){
+    NodePtr getRoot(){
         return this->root;
     }
-    void setRoot(shared_ptr<BSTNode> ptr){
+    void setRoot(NodePtr ptr){
         this->root = ptr;
     }
     
 protected:
+    // Parallel walks cut the tree at its upper levels: each subtree of at most
+    // about n / (8 * threads) nodes becomes one task, and the nodes above the
+    // cut go to `upper` for the caller. offset is the in-order position of the
+    // subtree's first node (from the subtree sizes), depth its root's (root = 1).
+    struct SubtreeTask {
+        NodePtr node;
+        size_t offset;
+        int depth;
+    };
+    void splitForTasks(size_t threads, vector<SubtreeTask>& tasks, vector<SubtreeTask>& upper) const;
+    template<typename Visit>
+    static void forEachInOrder(BSTNode* node, Visit visit);  // visit(BSTNode*) in key order
+
     // Helper methods for traversals and validation
-    void inOrderHelper(shared_ptr<BSTNode> node, vector<pair<K, V>>& result) const;
-    void displayHelper(shared_ptr<BSTNode> node, int depth) const;
-    bool isValidBSTHelper(shared_ptr<BSTNode> node, const K* minVal, const K* maxVal) const;
-    void rangeHelper(shared_ptr<BSTNode> node, const K& minKey, const K& maxKey, vector<pair<K, V>>& result) const;
+    void inOrderHelper(NodePtr node, vector<pair<K, V>>& result) const;
+    void displayHelper(NodePtr node, int depth) const;
+    bool isValidBSTHelper(NodePtr node, const K* minVal, const K* maxVal) const;
+    void rangeHelper(NodePtr node, const K& minKey, const K& maxKey, vector<pair<K, V>>& result) const;
+};
+
+/**
+ * Bidirectional in-order iterator. Dereferences to the node, so callers read
+ * it->key / it->value without copying. Insert/remove invalidates iterators.
+ */
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+class BST<K, V, Compare, Storage, Augment>::const_iterator {
+public:
+    using iterator_category = bidirectional_iterator_tag;
+    using value_type = BSTNode;
+    using difference_type = ptrdiff_t;
+    using pointer = const BSTNode*;
+    using reference = const BSTNode&;
+
+    const_iterator() : tree(nullptr), node(nullptr) {}
+    const_iterator(const BST* tree, BSTNode* node) : tree(tree), node(node) {}
+
+    reference operator*() const { return *node; }
+    pointer operator->() const { return node; }
+    const_iterator& operator++();
+    const_iterator operator++(int) { const_iterator old = *this; ++*this; return old; }
+    const_iterator& operator--();  // --end() is the maximum
+    const_iterator operator--(int) { const_iterator old = *this; --*this; return old; }
+    bool operator==(const const_iterator& other) const { return node == other.node; }
+    bool operator!=(const const_iterator& other) const { return node != other.node; }
+
+private:
+    const BST* tree;
+    BSTNode* node;  // nullptr means end()
+};
+
+/**
+ * Finger search. A cursor keeps the node its last seek ended at and starts the
+ * next seek there, climbing the parent links only up to the first ancestor
+ * whose subtree must hold the key, then descending as usual. A key d entries
+ * away costs O(log d) visits on a balanced tree rather than a full descent,
+ * so ascending or clustered probes get cheap; a far key costs up to twice a
+ * plain find. Insert/remove invalidates a cursor, as it does iterators;
+ * reset() makes it start from the root again.
+ */
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+class BST<K, V, Compare, Storage, Augment>::Cursor {
+public:
+    explicit Cursor(const BST& tree) : tree(&tree), finger(nullptr) {}
+
+    template<typename Key>
+    const V* seek(const Key& key);  // value stored under key, or nullptr
+    template<typename Key>
+    const_iterator seekLowerBound(const Key& key);  // first entry with key >= key
+    void reset() { finger = nullptr; }
+
+private:
+    const BST* tree;
+    BSTNode* finger;  // where the last seek ended; nullptr starts at the root
+
+    template<typename Key>
+    BSTNode* climb(const Key& key) const;  // lowest ancestor of finger whose subtree bounds key
 };
 
 #include "../solution/bst.cpp"
\ No newline at end of file
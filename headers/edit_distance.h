@@ -0,0 +1,262 @@
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <vector>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define EDIT_DISTANCE_AVX2 1  // compiled with target("avx2"), used only if the CPU has it
+#endif
+using namespace std;
+
+/**
+ * Levenshtein distance (single-byte insertions, deletions and
+ * substitutions), the metric behind the fuzzy username search.
+ *
+ * classicEditDistance is the textbook dynamic program, O(|a| * |b|), kept as
+ * the reference. The other kernels use Myers' bit-vector algorithm (in
+ * Hyyrö's formulation): a column of the DP matrix is held as vertical +1/-1
+ * deltas, one bit per pattern byte, and advanced by one text byte in a
+ * dozen word operations. Patterns up to 64 bytes take one 64-bit word, longer
+ * ones a block of words with carries in between: O(ceil(m / 64) * n).
+ *
+ * A maxDistance turns on the banded early exit: values never decrease along
+ * a diagonal of the matrix, so once the cell on the final cell's diagonal
+ * exceeds maxDistance the answer does too, and the kernel returns
+ * maxDistance + 1 without reading the rest of the text.
+ */
+inline int classicEditDistance(string_view a, string_view b) {
+    if (a.size() < b.size())
+        std::swap(a, b);  // the row spans the shorter string
+    vector<int> row(b.size() + 1);
+    for (size_t j = 0; j <= b.size(); ++j)
+        row[j] = (int)j;
+    for (size_t i = 1; i <= a.size(); ++i) {
+        int diagonal = row[0];  // row[i - 1][j - 1]
+        row[0] = (int)i;
+        for (size_t j = 1; j <= b.size(); ++j) {
+            int above = row[j];
+            row[j] = std::min({above + 1, row[j - 1] + 1, diagonal + (a[i - 1] != b[j - 1])});
+            diagonal = above;
+        }
+    }
+    return row[b.size()];
+}
+
+namespace edit_distance_detail {
+inline int popcount(uint64_t bits) { return __builtin_popcountll(bits); }
+inline uint64_t lowBits(int count) { return count >= 64 ? ~0ull : (1ull << count) - 1; }
+
+// Match masks: peq[c * blocks + b] has bit i set when pattern[64 * b + i] == c
+inline void buildPeq(string_view pattern, size_t blocks, uint64_t* peq) {
+    memset(peq, 0, 256 * blocks * sizeof(uint64_t));
+    for (size_t i = 0; i < pattern.size(); ++i)
+        peq[(unsigned char)pattern[i] * blocks + i / 64] |= 1ull << (i % 64);
+}
+
+// Pattern of 1..64 bytes in one word
+inline int myersWord(const uint64_t* peq, int m, string_view text, int maxDistance) {
+    const int n = (int)text.size();
+    const uint64_t last = 1ull << (m - 1);
+    const bool banded = maxDistance < m + n;
+    uint64_t pv = ~0ull, mv = 0;
+    int score = m;
+    for (int j = 0; j < n; ++j) {
+        uint64_t eq = peq[(unsigned char)text[j]];
+        uint64_t xv = eq | mv;
+        uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+        score += (ph & last) != 0;
+        score -= (mh & last) != 0;
+        ph = (ph << 1) | 1;  // the top row D[0][j] = j grows by one per column
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+        int row = j + 1 + m - n;  // on the diagonal of D[m][n]
+        if (banded && row > 0 && row <= m &&
+            j + 1 + popcount(pv & lowBits(row)) - popcount(mv & lowBits(row)) > maxDistance)
+            return maxDistance + 1;
+    }
+    return score;
+}
+
+// Any pattern length: blocks of 64 rows, each passing its bottom row's
+// horizontal delta (hin/hout, -1..1) down to the next block
+inline int myersBlocks(const uint64_t* peq, size_t blocks, int m, string_view text, int maxDistance) {
+    const int n = (int)text.size();
+    const int lastBit = (m - 1) % 64;
+    const bool banded = maxDistance < m + n;
+    vector<uint64_t> pv(blocks, ~0ull), mv(blocks, 0);
+    int score = m;
+    for (int j = 0; j < n; ++j) {
+        const uint64_t* eqs = peq + (unsigned char)text[j] * blocks;
+        int hin = 1;
+        for (size_t b = 0; b < blocks; ++b) {
+            uint64_t eq = eqs[b];
+            uint64_t xv = eq | mv[b];
+            if (hin < 0)
+                eq |= 1;
+            uint64_t xh = (((eq & pv[b]) + pv[b]) ^ pv[b]) | eq;
+            uint64_t ph = mv[b] | ~(xh | pv[b]);
+            uint64_t mh = pv[b] & xh;
+            int hout = (int)(ph >> 63) - (int)(mh >> 63);
+            if (b == blocks - 1)
+                score += (int)((ph >> lastBit) & 1) - (int)((mh >> lastBit) & 1);
+            ph <<= 1;
+            mh <<= 1;
+            if (hin > 0)
+                ph |= 1;
+            else if (hin < 0)
+                mh |= 1;
+            pv[b] = mh | ~(xv | ph);
+            mv[b] = ph & xv;
+            hin = hout;
+        }
+        int row = j + 1 + m - n;
+        if (banded && row > 0 && row <= m) {
+            int cell = j + 1;
+            for (size_t b = 0; (int)(64 * b) < row; ++b) {
+                uint64_t mask = lowBits(row - 64 * (int)b);
+                cell += popcount(pv[b] & mask) - popcount(mv[b] & mask);
+            }
+            if (cell > maxDistance)
+                return maxDistance + 1;
+        }
+    }
+    return score;
+}
+
+#ifdef EDIT_DISTANCE_AVX2
+inline bool avx2Supported() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+// One pattern of 1..32 bytes against 8 texts, one 32-bit lane each. Lanes
+// whose text has ended stop counting; their other bits no longer matter.
+__attribute__((target("avx2"))) inline void myersLanes(const uint64_t* peq, int m, const string_view* texts, int* out) {
+    alignas(32) uint32_t eqs[8];
+    alignas(32) int32_t lengths[8];
+    int longest = 0;
+    for (int l = 0; l < 8; ++l) {
+        lengths[l] = (int32_t)texts[l].size();
+        longest = std::max(longest, lengths[l]);
+    }
+    const __m256i ones = _mm256_set1_epi32(-1);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i last = _mm256_set1_epi32((int32_t)(1u << (m - 1)));
+    const __m256i length = _mm256_load_si256(reinterpret_cast<const __m256i*>(lengths));
+    __m256i pv = ones, mv = _mm256_setzero_si256(), score = _mm256_set1_epi32(m);
+    for (int j = 0; j < longest; ++j) {
+        for (int l = 0; l < 8; ++l)
+            eqs[l] = j < lengths[l] ? (uint32_t)peq[(unsigned char)texts[l][j]] : 0;
+        __m256i eq = _mm256_load_si256(reinterpret_cast<const __m256i*>(eqs));
+        __m256i active = _mm256_cmpgt_epi32(length, _mm256_set1_epi32(j));
+        __m256i xv = _mm256_or_si256(eq, mv);
+        __m256i xh = _mm256_or_si256(_mm256_xor_si256(_mm256_add_epi32(_mm256_and_si256(eq, pv), pv), pv), eq);
+        __m256i ph = _mm256_or_si256(mv, _mm256_xor_si256(_mm256_or_si256(xh, pv), ones));
+        __m256i mh = _mm256_and_si256(pv, xh);
+        // cmpeq gives -1 in lanes whose bottom row moved: subtract for +1, add for -1
+        __m256i up = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_and_si256(ph, last), last), active);
+        __m256i down = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_and_si256(mh, last), last), active);
+        score = _mm256_add_epi32(_mm256_sub_epi32(score, up), down);
+        ph = _mm256_or_si256(_mm256_slli_epi32(ph, 1), one);
+        mh = _mm256_slli_epi32(mh, 1);
+        pv = _mm256_or_si256(mh, _mm256_xor_si256(_mm256_or_si256(xv, ph), ones));
+        mv = _mm256_and_si256(ph, xv);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), score);
+}
+#endif
+}  // namespace edit_distance_detail
+
+/**
+ * A query prepared for scoring against many texts, as a fuzzy search does:
+ * the match masks are built once per query rather than once per pair.
+ * distances() scores 8 texts per step in AVX2 lanes when the CPU has AVX2
+ * and the pattern fits a 32-bit lane; otherwise it runs distance() per text.
+ */
+class MyersPattern {
+public:
+    static constexpr size_t LANES = 8;
+
+    explicit MyersPattern(string_view pattern)
+        : length((int)pattern.size()), blocks(std::max<size_t>(1, (pattern.size() + 63) / 64)), peq(256 * blocks) {
+        edit_distance_detail::buildPeq(pattern, blocks, peq.data());
+    }
+
+    size_t size() const { return length; }
+
+    // Exact distance if it is at most maxDistance, otherwise maxDistance + 1
+    int distance(string_view text, int maxDistance = INT_MAX) const {
+        if (std::abs(length - (int)text.size()) > maxDistance)
+            return maxDistance + 1;
+        if (length == 0)
+            return (int)text.size();
+        if (blocks == 1)
+            return edit_distance_detail::myersWord(peq.data(), length, text, maxDistance);
+        return edit_distance_detail::myersBlocks(peq.data(), blocks, length, text, maxDistance);
+    }
+
+    // How many texts distances() scores per step (LANES, or 1 without AVX2)
+    size_t batchWidth() const {
+#ifdef EDIT_DISTANCE_AVX2
+        if (length > 0 && length <= 32 && edit_distance_detail::avx2Supported())
+            return LANES;
+#endif
+        return 1;
+    }
+
+    // out[i] = distance(texts[i]), exact
+    void distances(const string_view* texts, size_t count, int* out) const {
+        size_t i = 0;
+#ifdef EDIT_DISTANCE_AVX2
+        if (batchWidth() == LANES) {
+            for (; i + LANES <= count; i += LANES)
+                edit_distance_detail::myersLanes(peq.data(), length, texts + i, out + i);
+            if (i < count) { //pad the last group with empty texts
+                string_view group[LANES];
+                int scores[LANES];
+                std::copy(texts + i, texts + count, group);
+                edit_distance_detail::myersLanes(peq.data(), length, group, scores);
+                std::copy(scores, scores + (count - i), out + i);
+                return;
+            }
+        }
+#endif
+        for (; i < count; ++i)
+            out[i] = distance(texts[i]);
+    }
+
+private:
+    int length;
+    size_t blocks;
+    vector<uint64_t> peq;
+};
+
+/**
+ * Levenshtein metric for BKTree and the engine. A one-off pair builds its
+ * match masks on the stack (patterns up to 64 bytes, the shorter string
+ * taken as the pattern); prepare() keeps them for a query scored many times.
+ */
+struct LevenshteinDistance {
+    int operator()(string_view a, string_view b, int maxDistance = INT_MAX) const {
+        if (a.size() > b.size())
+            std::swap(a, b);
+        if (a.size() > 64)
+            return MyersPattern(a).distance(b, maxDistance);
+        if (b.size() - a.size() > (size_t)maxDistance)
+            return maxDistance + 1;
+        if (a.empty())
+            return (int)b.size();
+        uint64_t peq[256];
+        edit_distance_detail::buildPeq(a, 1, peq);
+        return edit_distance_detail::myersWord(peq, (int)a.size(), b, maxDistance);
+    }
+
+    MyersPattern prepare(string_view query) const { return MyersPattern(query); }
+};
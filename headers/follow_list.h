@@ -1,6 +1,8 @@
 #ifndef FOLLOW_LIST_H
 #define FOLLOW_LIST_H
 
+#include <cstddef>
+
 // Forward declaration of User
 struct User;
 
@@ -15,14 +17,16 @@ struct FollowNode
 struct FollowList
 {
     FollowNode *head;
+    size_t count; // users in the list, kept by addFollowing/removeFollowing
 
-    FollowList() : head(nullptr) {}
+    FollowList() : head(nullptr), count(0) {}
     ~FollowList();
 
     void addFollowing(User *u);
     bool removeFollowing(int userID);
     User *findFollowing(int userID);
     void displayFollowing() const;
+    size_t size() const { return count; }
 };
 
 #endif // FOLLOW_LIST_Hz
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "bst.h"
+#include "index_file.h"
+using namespace std;
+
+/**
+ * Read-only sorted index for data that rarely changes, built in O(n) from
+ * the in-order traversal of a tree (e.g. AVLTree::inOrderTraversal()).
+ *
+ * Searches run over a copy of the keys in Eytzinger (BFS) order: the
+ * descent has no data-dependent branch, and the next levels are always
+ * at predictable addresses that can be prefetched. Entries themselves stay
+ * in sorted order, so range scans walk one contiguous array.
+ *
+ * For arithmetic K and V the entries can instead be read in place from a
+ * memory-mapped saveBinary file (see mapFile); copies then share the mapping.
+ */
+template<typename K, typename V, typename Compare = less<K>>
+class FrozenIndex : protected ComparatorBase<Compare> {
+public:
+    using Entry = IndexRecord<K, V>;  // key, value
+    using const_iterator = const Entry*;
+
+    FrozenIndex() = default;
+    explicit FrozenIndex(const vector<pair<K, V>>& sortedEntries, Compare comp = Compare());
+
+    // Replaces the contents; entries must be ascending by key with no duplicates
+    void build(const vector<pair<K, V>>& sortedEntries);
+
+    // Replaces the contents with the entries of an AVLTree/BPlusTree
+    // saveBinary file, mapped rather than copied: only the Eytzinger keys
+    // are built, in O(n). False, leaving the index as it was, if the file is
+    // missing, not strictly ascending, or its K -> V entries are not
+    // fixed-size IndexRecords (any non-arithmetic K or V).
+    bool mapFile(const string& path);
+    bool isMapped() const { return mapping != nullptr; }
+
+    size_t size() const { return mapping ? mappedCount : entries.size(); }
+    bool empty() const { return size() == 0; }
+
+    const V* find(const K& key) const;
+    const_iterator begin() const { return sorted(); }
+    const_iterator end() const { return sorted() + size(); }
+    const_iterator lower_bound(const K& key) const { return sorted() + boundRank(key, false); }
+    const_iterator upper_bound(const K& key) const { return sorted() + boundRank(key, true); }
+
+    template<typename Visitor>
+    void forEachInRange(const K& minKey, const K& maxKey, Visitor visit) const;
+    vector<pair<K, V>> findRange(const K& minKey, const K& maxKey) const;
+
+private:
+    // Prefetching layout: children of eytzinger[k] live at 2k and 2k + 1, so the
+    // 16 descendants four levels down share one cache line for 4-byte keys
+    static constexpr size_t KEYS_PER_LINE = (64 / sizeof(K)) > 0 ? 64 / sizeof(K) : 1;
+
+    vector<Entry> entries;       // sorted by key, unless mapped
+    shared_ptr<const MappedFile> mapping;  // file holding the sorted entries instead
+    size_t mappedCount = 0;
+    vector<K> eytzinger;         // 1-based BFS order, slot 0 unused
+    vector<uint32_t> rankAt;     // eytzinger slot -> position in entries
+
+    const Entry* sorted() const {
+        return mapping ? reinterpret_cast<const Entry*>(mapping->data() + sizeof(IndexFileHeader)) : entries.data();
+    }
+    bool comparator(const K& a, const K& b) const { return this->keyCompare()(a, b); }
+    size_t fillEytzinger(size_t next, size_t slot);
+    size_t boundRank(const K& key, bool upper) const;  // first position with key >= key (> key if upper)
+};
+
+#include "../solution/frozen_index.cpp"
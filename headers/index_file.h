@@ -0,0 +1,330 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define INDEX_FILE_MMAP 1
+#endif
+using namespace std;
+
+/**
+ * Binary snapshot of a sorted index, as written by AVLTree::saveBinary and
+ * BPlusTree::saveBinary and read back by their loadBinary or, for fixed-size
+ * entries, mapped in place by FrozenIndex::mapFile.
+ *
+ * A 32-byte header is followed by `count` entries in ascending key order.
+ * When key and value are both fixed-size, each entry is an IndexRecord
+ * exactly as it sits in memory (padding zeroed), so a mapped file can be
+ * searched without copying. Otherwise each entry is its key then its value,
+ * a string being a uint32 length and its bytes. Numbers are stored in
+ * native byte order: files only move between machines of the same endianness.
+ */
+struct IndexFileHeader {
+    char magic[4];        // "SIDX"
+    uint16_t version;
+    uint8_t keyType;      // BinaryCodec<T>::type of the stored key / value
+    uint8_t valueType;
+    uint16_t keySize;     // bytes per key / value, 0 for strings
+    uint16_t valueSize;
+    uint32_t recordSize;  // sizeof(IndexRecord<K, V>) when both are fixed-size, else 0
+    uint64_t count;       // entries
+    uint64_t bodyBytes;   // bytes after the header
+};
+static_assert(sizeof(IndexFileHeader) == 32, "the header must keep IndexRecords 32-byte aligned");
+
+constexpr char INDEX_FILE_MAGIC[4] = {'S', 'I', 'D', 'X'};
+constexpr uint16_t INDEX_FILE_VERSION = 1;
+
+template<typename K, typename V>
+struct IndexRecord {
+    K key;
+    V value;
+};
+
+/**
+ * How one key or value type is stored. type is 'i' (signed), 'u' (unsigned),
+ * 'f' (floating point) or 's' (string); size is 0 for variable-length types.
+ * Types without a specialization cannot be saved as they are: saveBinary and
+ * loadBinary take functions mapping them to and from a storable type.
+ */
+template<typename T, typename = void>
+struct BinaryCodec;
+
+template<typename T>
+struct BinaryCodec<T, enable_if_t<is_arithmetic<T>::value>> {
+    static constexpr uint8_t type = is_floating_point<T>::value ? 'f' : is_signed<T>::value ? 'i' : 'u';
+    static constexpr uint16_t size = sizeof(T);
+
+    static void write(string& out, T value) { out.append(reinterpret_cast<const char*>(&value), sizeof(T)); }
+    static bool read(const char*& in, const char* end, T& value) {
+        if ((size_t)(end - in) < sizeof(T))
+            return false;
+        memcpy(&value, in, sizeof(T));
+        in += sizeof(T);
+        return true;
+    }
+};
+
+template<>
+struct BinaryCodec<string> {
+    static constexpr uint8_t type = 's';
+    static constexpr uint16_t size = 0;
+
+    static void write(string& out, string_view text) {
+        BinaryCodec<uint32_t>::write(out, static_cast<uint32_t>(text.size()));
+        out.append(text.data(), text.size());
+    }
+    static bool read(const char*& in, const char* end, string& text) {
+        uint32_t length;
+        if (!BinaryCodec<uint32_t>::read(in, end, length) || (size_t)(end - in) < length)
+            return false;
+        text.assign(in, length);
+        in += length;
+        return true;
+    }
+};
+
+// Written like string; read back as string
+template<>
+struct BinaryCodec<string_view> : BinaryCodec<string> {};
+
+/**
+ * Default key/value mapping of saveBinary and loadBinary: entries are
+ * stored as they are. A custom mapping follows the same two shapes:
+ * encode(const T&) returns the stored form, decode(Stored&&, T&) fills
+ * in the entry and returns false to reject the file.
+ */
+struct StoreAsIs {
+    template<typename T>
+    const T& operator()(const T& value) const { return value; }
+    template<typename T>
+    bool operator()(T&& stored, T& value) const {
+        value = std::move(stored);
+        return true;
+    }
+};
+
+/**
+ * Read-only view of a whole file: mapped where the platform has mmap,
+ * otherwise read into an aligned heap buffer. data() is null if the file
+ * could not be opened or is empty.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const string& path) {
+#ifdef INDEX_FILE_MMAP
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* mapping = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                bytes = static_cast<const char*>(mapping);
+                length = (size_t)info.st_size;
+            }
+        }
+        close(fd);
+#else
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file)
+            return;
+        if (fseek(file, 0, SEEK_END) == 0) {
+            long end = ftell(file);
+            if (end > 0 && fseek(file, 0, SEEK_SET) == 0) {
+                copy.reset(new max_align_t[(end + sizeof(max_align_t) - 1) / sizeof(max_align_t)]);
+                if (fread(copy.get(), 1, (size_t)end, file) == (size_t)end) {
+                    bytes = reinterpret_cast<const char*>(copy.get());
+                    length = (size_t)end;
+                }
+            }
+        }
+        fclose(file);
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef INDEX_FILE_MMAP
+        if (bytes)
+            munmap(const_cast<char*>(bytes), length);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+#ifndef INDEX_FILE_MMAP
+    unique_ptr<max_align_t[]> copy;
+#endif
+};
+
+// The header of an index file holding StoredKey -> StoredValue entries, or
+// nullptr if the file is not one (wrong magic, version, types or length).
+template<typename StoredKey, typename StoredValue>
+const IndexFileHeader* indexFileHeader(const MappedFile& file) {
+    using KeyCodec = BinaryCodec<StoredKey>;
+    using ValueCodec = BinaryCodec<StoredValue>;
+    constexpr bool fixed = KeyCodec::size && ValueCodec::size;
+    // a string costs at least its 4-byte length, which bounds a believable count
+    constexpr uint64_t minEntryBytes = (KeyCodec::size ? KeyCodec::size : 4) + (ValueCodec::size ? ValueCodec::size : 4);
+    if (!file.data() || file.size() < sizeof(IndexFileHeader))
+        return nullptr;
+    const IndexFileHeader* header = reinterpret_cast<const IndexFileHeader*>(file.data());
+    if (memcmp(header->magic, INDEX_FILE_MAGIC, 4) != 0 || header->version != INDEX_FILE_VERSION)
+        return nullptr;
+    if (header->keyType != KeyCodec::type || header->keySize != KeyCodec::size ||
+        header->valueType != ValueCodec::type || header->valueSize != ValueCodec::size)
+        return nullptr;
+    if (header->bodyBytes != file.size() - sizeof(IndexFileHeader) || header->count > header->bodyBytes / minEntryBytes)
+        return nullptr;
+    if (fixed && (header->recordSize != sizeof(IndexRecord<StoredKey, StoredValue>) ||
+                  header->bodyBytes / header->recordSize != header->count ||
+                  header->bodyBytes % header->recordSize != 0))
+        return nullptr;
+    return header;
+}
+
+/**
+ * Writes `count` entries to path. forEach(emit) must call
+ * emit(storedKey, storedValue) once per entry, in ascending key order.
+ * The data goes to path + ".tmp", which is renamed over path only once
+ * complete, so a failed save leaves the previous snapshot in place.
+ */
+template<typename StoredKey, typename StoredValue, typename ForEach>
+bool writeIndexFile(const string& path, size_t count, ForEach forEach) {
+    using KeyCodec = BinaryCodec<StoredKey>;
+    using ValueCodec = BinaryCodec<StoredValue>;
+    constexpr bool fixed = KeyCodec::size && ValueCodec::size;
+    constexpr size_t FLUSH_BYTES = 1 << 20;
+
+    const string tempPath = path + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (!file)
+        return false;
+    IndexFileHeader header{};
+    memcpy(header.magic, INDEX_FILE_MAGIC, 4);
+    header.version = INDEX_FILE_VERSION;
+    header.keyType = KeyCodec::type;
+    header.valueType = ValueCodec::type;
+    header.keySize = KeyCodec::size;
+    header.valueSize = ValueCodec::size;
+    header.recordSize = fixed ? sizeof(IndexRecord<StoredKey, StoredValue>) : 0;
+    header.count = count;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    string buffer;
+    buffer.reserve(FLUSH_BYTES + 4096);
+    size_t written = 0;
+    forEach([&](const auto& key, const auto& value) {
+        if constexpr (fixed) {
+            // built whole so the padding bytes are zero, not stack garbage
+            IndexRecord<StoredKey, StoredValue> record;
+            memset(&record, 0, sizeof(record));
+            record.key = key;
+            record.value = value;
+            buffer.append(reinterpret_cast<const char*>(&record), sizeof(record));
+        } else {
+            KeyCodec::write(buffer, key);
+            ValueCodec::write(buffer, value);
+        }
+        written++;
+        if (buffer.size() >= FLUSH_BYTES) {
+            ok = ok && fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+            header.bodyBytes += buffer.size();
+            buffer.clear();
+        }
+    });
+    ok = ok && fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+    header.bodyBytes += buffer.size();
+    ok = ok && written == count;
+    // the real body length is only known now
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = (fclose(file) == 0) && ok;
+    ok = ok && std::rename(tempPath.c_str(), path.c_str()) == 0;
+    if (!ok)
+        std::remove(tempPath.c_str());
+    return ok;
+}
+
+/**
+ * Reads a file written by writeIndexFile. reserve(count) is called once
+ * the header checks out, then visit(StoredKey&&, StoredValue&&) for each
+ * entry in file order. False if the file is missing, not an index of
+ * these types, truncated, or visit returned false.
+ */
+template<typename StoredKey, typename StoredValue, typename Reserve, typename Visit>
+bool readIndexFile(const string& path, Reserve reserve, Visit visit) {
+    using KeyCodec = BinaryCodec<StoredKey>;
+    using ValueCodec = BinaryCodec<StoredValue>;
+    constexpr bool fixed = KeyCodec::size && ValueCodec::size;
+
+    MappedFile file(path);
+    const IndexFileHeader* header = indexFileHeader<StoredKey, StoredValue>(file);
+    if (!header)
+        return false;
+    reserve((size_t)header->count);
+    const char* in = file.data() + sizeof(IndexFileHeader);
+    const char* end = file.data() + file.size();
+    for (uint64_t i = 0; i < header->count; ++i) {
+        StoredKey key;
+        StoredValue value;
+        if constexpr (fixed) {
+            IndexRecord<StoredKey, StoredValue> record;
+            memcpy(&record, in, sizeof(record));
+            in += sizeof(record);
+            key = record.key;
+            value = record.value;
+        } else {
+            if (!KeyCodec::read(in, end, key) || !ValueCodec::read(in, end, value))
+                return false;
+        }
+        if (!visit(std::move(key), std::move(value)))
+            return false;
+    }
+    return in == end;
+}
+
+// writeIndexFile over a whole tree, iterated as entry.key / entry.value.
+// Stored types are whatever encodeKey / encodeValue return.
+template<typename K, typename V, typename Tree, typename EncodeKey, typename EncodeValue>
+bool saveIndexFile(const Tree& tree, const string& path, EncodeKey encodeKey, EncodeValue encodeValue) {
+    using StoredKey = decay_t<invoke_result_t<EncodeKey&, const K&>>;
+    using StoredValue = decay_t<invoke_result_t<EncodeValue&, const V&>>;
+    return writeIndexFile<StoredKey, StoredValue>(path, tree.size(), [&](auto emit) {
+        for (const auto& entry : tree)
+            emit(encodeKey(entry.key), encodeValue(entry.value));
+    });
+}
+
+// readIndexFile into entries ascending by `less`, decoded through
+// decodeKey / decodeValue. Keys out of order or repeated fail the read,
+// since a tree built from them would be broken.
+template<typename StoredKey, typename StoredValue, typename K, typename V, typename Less, typename DecodeKey, typename DecodeValue>
+bool readSortedIndexFile(const string& path, vector<pair<K, V>>& items, Less less, DecodeKey decodeKey, DecodeValue decodeValue) {
+    items.clear();
+    return readIndexFile<StoredKey, StoredValue>(path,
+        [&](size_t count) { items.reserve(count); },
+        [&](StoredKey&& storedKey, StoredValue&& storedValue) {
+            items.emplace_back();
+            pair<K, V>& item = items.back();
+            if (!decodeKey(std::move(storedKey), item.first) || !decodeValue(std::move(storedValue), item.second))
+                return false;
+            return items.size() == 1 || less(items[items.size() - 2].first, item.first);
+        });
+}
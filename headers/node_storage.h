@@ -0,0 +1,213 @@
+#pragma once
+#include <cstddef> // size_t
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+using namespace std;
+
+/**
+ * Node storage policies for BST / AVLTree.
+ *
+ * A policy tells the tree which pointer types link its nodes together and
+ * owns the allocation of those nodes:
+ *   - SharedNodeStorage: original layout, shared_ptr children and a weak_ptr
+ *     parent, every node created with make_shared.
+ *   - ArenaNodeStorage: nodes live in slabs (same scheme as PostPool)
+ *     and are linked with raw pointers, so walking the tree never touches a
+ *     reference count and removed nodes are recycled through a free list.
+ */
+struct SharedNodeStorage
+{
+    template <typename Node>
+    using NodePtr = shared_ptr<Node>;
+    template <typename Node>
+    using ParentPtr = weak_ptr<Node>;
+
+    static constexpr bool ownsNodes = false; // nodes free themselves
+
+    template <typename Node>
+    class Pool
+    {
+    public:
+        template <typename... Args>
+        shared_ptr<Node> create(Args &&...args) { return make_shared<Node>(std::forward<Args>(args)...); }
+        void destroy(const shared_ptr<Node> &) {} // last owner releases it
+
+        static shared_ptr<Node> parentOf(const Node *node) { return node->parent.lock(); }
+
+        // Nodes are independently owned, so moving them between trees needs no bookkeeping
+        void shareBlocks(const Pool &) {}
+        void adopt(Pool &) {}
+
+        size_t totalAllocations() const { return 0; }
+        size_t reuseCount() const { return 0; }
+    };
+};
+
+struct ArenaNodeStorage
+{
+    template <typename Node>
+    using NodePtr = Node *;
+    template <typename Node>
+    using ParentPtr = Node *;
+
+    static constexpr bool ownsNodes = true; // tree must destroy() every live node
+
+    template <typename Node>
+    class Pool
+    {
+        struct alignas(Node) Slot
+        {
+            unsigned char bytes[sizeof(Node)];
+        };
+
+        // Slabs holding the nodes of one or more trees. split() hands nodes to
+        // a new tree that shares its source's group; join() gives the
+        // surviving tree a group over both, so neither copies slab lists.
+        struct Slabs
+        {
+            vector<unique_ptr<Slot[]>> blocks; // allocated through this group
+            vector<shared_ptr<Slabs>> parts;   // groups merged in by join
+            mutex lock;                        // trees sharing a group may allocate from different threads
+
+            Slabs() = default;
+            explicit Slabs(vector<shared_ptr<Slabs>> parts) : parts(std::move(parts)) {}
+            ~Slabs()
+            {
+                // release merged groups iteratively, not one stack frame per join
+                vector<shared_ptr<Slabs>> pending = std::move(parts);
+                while (!pending.empty())
+                {
+                    shared_ptr<Slabs> group = std::move(pending.back());
+                    pending.pop_back();
+                    if (group.use_count() == 1)
+                        for (auto &part : group->parts)
+                            pending.push_back(std::move(part));
+                }
+            }
+        };
+
+    public:
+        explicit Pool(size_t block_size = 1024) // number of nodes per slab
+            : block_size(block_size), current_block(nullptr), current_block_index(block_size), alloc_count(0), reuse_count(0) {}
+        ~Pool() { purge(); }
+
+        Pool(const Pool &) = delete;
+        Pool &operator=(const Pool &) = delete;
+
+        Pool(Pool &&other) noexcept
+            : block_size(other.block_size), slabs(std::move(other.slabs)), free_list(std::move(other.free_list)),
+              current_block(other.current_block), current_block_index(other.current_block_index),
+              alloc_count(other.alloc_count), reuse_count(other.reuse_count)
+        {
+            other.purge();
+        }
+
+        Pool &operator=(Pool &&other) noexcept
+        {
+            if (this != &other)
+            {
+                block_size = other.block_size;
+                slabs = std::move(other.slabs);
+                free_list = std::move(other.free_list);
+                current_block = other.current_block;
+                current_block_index = other.current_block_index;
+                alloc_count = other.alloc_count;
+                reuse_count = other.reuse_count;
+                other.purge();
+            }
+            return *this;
+        }
+
+        template <typename... Args>
+        Node *create(Args &&...args)
+        {
+            void *slot;
+            if (!free_list.empty())
+            {
+                slot = free_list.back();
+                free_list.pop_back();
+                reuse_count++;
+            }
+            else
+            {
+                if (current_block_index >= block_size)
+                    allocateBlock();
+                slot = &current_block[current_block_index++];
+            }
+            return new (slot) Node(std::forward<Args>(args)...);
+        }
+
+        // Runs the node's destructor and hands its slot back to the free list
+        void destroy(Node *node)
+        {
+            if (!node)
+                return;
+            node->~Node();
+            free_list.push_back(node);
+        }
+
+        static Node *parentOf(const Node *node) { return node->parent; }
+
+        // When split/join hand nodes to another tree, that tree's pool keeps the
+        // other's slabs alive: both end up holding one refcounted group, freed
+        // with the last pool that holds it. O(1) whatever the slab count.
+        void shareBlocks(const Pool &other)
+        {
+            if (!other.slabs || other.slabs == slabs)
+                return;
+            if (!slabs)
+                slabs = other.slabs;
+            else
+                slabs = make_shared<Slabs>(vector<shared_ptr<Slabs>>{slabs, other.slabs});
+        }
+
+        // shareBlocks, and take over the other's free slots
+        void adopt(Pool &other)
+        {
+            if (this == &other)
+                return;
+            shareBlocks(other);
+            if (free_list.size() < other.free_list.size())
+                free_list.swap(other.free_list);
+            free_list.insert(free_list.end(), other.free_list.begin(), other.free_list.end());
+            other.free_list.clear();
+        }
+
+        size_t totalAllocations() const { return alloc_count; } // number of slab allocations
+        size_t reuseCount() const { return reuse_count; }       // number of recycled slots
+
+        // Releases this pool's hold on its slabs. Live nodes must already have
+        // been destroy()ed (or handed to a tree that shares the slabs).
+        void purge()
+        {
+            slabs.reset();
+            free_list.clear();
+            current_block = nullptr;
+            current_block_index = block_size;
+        }
+
+    private:
+        size_t block_size;
+        shared_ptr<Slabs> slabs;    // null until the first slab or share
+        vector<void *> free_list;   // destroyed slots ready to be reused
+        Slot *current_block;        // slab being bump-allocated from, owned by slabs
+        size_t current_block_index; // next unused slot in current_block
+
+        size_t alloc_count;
+        size_t reuse_count;
+
+        void allocateBlock()
+        {
+            if (!slabs)
+                slabs = make_shared<Slabs>();
+            lock_guard<mutex> guard(slabs->lock);
+            slabs->blocks.emplace_back(new Slot[block_size]);
+            current_block = slabs->blocks.back().get();
+            current_block_index = 0;
+            alloc_count++;
+        }
+    };
+};
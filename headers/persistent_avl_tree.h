@@ -0,0 +1,109 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "bst.h"
+using namespace std;
+
+template<typename K, typename V, typename Compare>
+class PersistentAVLTree;
+
+/**
+ * Immutable version of a persistent AVL tree.
+ *
+ * Nodes are never modified once built, so a snapshot can be read from any
+ * thread while the tree it came from keeps changing. Each node is owned by
+ * every version that reaches it; a version's private nodes are freed when
+ * its last handle goes away.
+ */
+template<typename K, typename V, typename Compare = less<K>>
+class AVLSnapshot : protected ComparatorBase<Compare> {
+public:
+    struct Node;
+    using NodePtr = shared_ptr<const Node>;
+
+    struct Node {
+        K key;
+        V value;
+        NodePtr left;
+        NodePtr right;
+        int height;
+        size_t subtreeSize;
+
+        Node(K key, V value, NodePtr left, NodePtr right);
+    };
+
+    AVLSnapshot() = default;
+
+    size_t size() const { return sizeOf(root.get()); }
+    bool empty() const { return !root; }
+    int getTreeHeight() const { return heightOf(root.get()); }
+
+    // Pointers and references stay valid for as long as this snapshot lives
+    const V* find(const K& key) const;
+    vector<pair<K, V>> findRange(const K& minKey, const K& maxKey) const;
+    vector<pair<K, V>> inOrderTraversal() const;
+    template<typename Visitor>
+    void forEachInRange(const K& minKey, const K& maxKey, Visitor visit) const;
+
+    size_t rank(const K& key) const;
+    pair<K, V> select(size_t index) const;
+    size_t countRange(const K& minKey, const K& maxKey) const;
+
+    bool isValidAVL() const;  // ordering, heights, sizes and balance of every node
+
+protected:
+    friend class PersistentAVLTree<K, V, Compare>;
+    NodePtr root;
+
+    AVLSnapshot(NodePtr root, Compare comp);
+
+    bool comparator(const K& a, const K& b) const { return this->keyCompare()(a, b); }
+    static int heightOf(const Node* node) { return node ? node->height : 0; }
+    static size_t sizeOf(const Node* node) { return node ? node->subtreeSize : 0; }
+    size_t countLess(const K& key, bool inclusive) const;
+    template<typename Visitor>
+    bool rangeHelper(const Node* node, const K& minKey, const K& maxKey, Visitor& visit) const;
+    bool isValidHelper(const Node* node, const K* lower, const K* upper) const;
+};
+
+/**
+ * AVL tree in persistent (path-copying) mode.
+ *
+ * insert/remove never touch an existing node: they rebuild the O(log n) nodes
+ * on the search path and share every other subtree with the previous version.
+ * snapshot() hands out the current version for lock-free reading.
+ *
+ * Threading: mutations must be serialized by the caller (one writer at a
+ * time); any number of threads may call snapshot() concurrently with it.
+ * The read methods inherited from AVLSnapshot read the live version and are
+ * meant for the writer's thread.
+ */
+template<typename K, typename V, typename Compare = less<K>>
+class PersistentAVLTree : public AVLSnapshot<K, V, Compare> {
+public:
+    using Snapshot = AVLSnapshot<K, V, Compare>;
+    using Node = typename Snapshot::Node;
+    using NodePtr = typename Snapshot::NodePtr;
+
+    PersistentAVLTree() = default;
+    explicit PersistentAVLTree(Compare comp);
+
+    bool insert(const K& key, const V& value);  // false if the key exists
+    template<typename M>
+    bool insert_or_assign(const K& key, M&& value);  // true if inserted
+    bool remove(const K& key);
+    void clear();
+
+    Snapshot snapshot() const;  // O(1), safe to call while another thread mutates
+
+private:
+    static NodePtr makeNode(const K& key, const V& value, NodePtr left, NodePtr right);
+    static NodePtr balance(const K& key, const V& value, NodePtr left, NodePtr right);
+    // Return the new subtree root, or node itself when nothing changed below it
+    NodePtr insertPath(const NodePtr& node, const K& key, const V& value, bool assign, bool& inserted);
+    NodePtr removePath(const NodePtr& node, const K& key, bool& removed);
+    NodePtr removeMinPath(const NodePtr& node, const Node*& minNode);
+    void publish(NodePtr newRoot);
+};
+
+#include "../solution/persistent_avl_tree.cpp"
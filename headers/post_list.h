@@ -11,8 +11,9 @@ struct PostNode {
 
 struct PostList {
     PostNode* head;
+    size_t count;  // posts in the list, kept by addPost/removePost
 
-    PostList() : head(nullptr) {}
+    PostList() : head(nullptr), count(0) {}
     ~PostList();
 
     void addPost(const Post& p);
@@ -20,6 +21,7 @@ struct PostList {
     Post* findPost(int postID);
     void displayPosts() const;
     bool isEmpty() const;
+    size_t size() const { return count; }
 };
 
 #endif
@@ -0,0 +1,93 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+using namespace std;
+
+/**
+ * Compressed radix trie over string keys, for prefix queries.
+ *
+ * Every edge carries the whole run of bytes up to the next branch or key
+ * (path compression), so a lookup compares each byte of the key once and
+ * visits one node per branch point rather than one per byte or per
+ * log2(n) tree level. Each node caches how many keys its subtree holds:
+ * countWithPrefix costs O(|prefix|), and withPrefix(prefix, offset, limit)
+ * skips whole subtrees to reach the offset-th completion, so the first k
+ * completions cost about O(|prefix| + k).
+ *
+ * Nodes adapt to their fanout: up to SMALL_FANOUT children sit in a sorted
+ * byte array searched linearly, beyond that the node switches to a 256-slot
+ * table indexed by the next byte (and back once it drops to half that).
+ * Keys come out in byte order, which is std::string order.
+ */
+template<typename V>
+class RadixTrie {
+public:
+    static constexpr size_t SMALL_FANOUT = 16;
+
+    RadixTrie();
+    RadixTrie(RadixTrie&&) = default;
+    RadixTrie& operator=(RadixTrie&&) = default;
+
+    bool insert(string_view key, const V& value);  // false if key is already present
+    bool remove(string_view key);
+    const V* find(string_view key) const;
+    V* find(string_view key);
+
+    size_t size() const { return root->count; }
+    bool empty() const { return size() == 0; }
+    size_t nodeCount() const { return nodes; }  // the root included
+    void clear();
+
+    // Number of keys starting with prefix (every key for an empty prefix)
+    size_t countWithPrefix(string_view prefix) const;
+    // Values of the keys starting with prefix, in key order, from the
+    // offset-th such key on and at most limit of them
+    vector<V> withPrefix(string_view prefix, size_t offset = 0, size_t limit = SIZE_MAX) const;
+    // Visits the values of keys starting with prefix in key order; the callback returns false to stop early
+    template<typename Visitor>
+    void forEachWithPrefix(string_view prefix, Visitor visit) const;
+
+    // Labels, path compression, child order, node kinds and cached counts
+    bool isValid() const;
+
+private:
+    struct Node {
+        string label;        // bytes on the edge from the parent; empty only at the root
+        bool terminal;       // a key ends here
+        V value;
+        size_t count;        // keys in this subtree, this node's included
+        // Small form: children sorted by their label's first byte, the bytes
+        // kept in the node so a lookup scans them without leaving it
+        unsigned char bytes[SMALL_FANOUT];
+        vector<unique_ptr<Node>> small;
+        // Wide form, once there are more than SMALL_FANOUT children
+        unique_ptr<array<unique_ptr<Node>, 256>> wide;
+        size_t fanout;
+
+        explicit Node(string_view label) : label(label), terminal(false), value(), count(0), fanout(0) {}
+
+        unique_ptr<Node>* slot(unsigned char byte);  // link to the child starting with byte, or nullptr
+        Node* child(unsigned char byte) const;
+        void addChild(unique_ptr<Node> node);      // no child may start with the same byte yet
+        unique_ptr<Node> takeChild(unsigned char byte);
+        template<typename Visit>
+        void forEachChild(Visit visit) const;     // visit(Node*) in byte order; false stops the walk
+    };
+
+    unique_ptr<Node> root;
+    size_t nodes;
+
+    const Node* findNode(string_view key) const;        // node where key ends, terminal or not
+    const Node* prefixNode(string_view prefix) const;   // top node of the subtree holding prefix's keys
+    void mergeWithChild(Node* parent, Node* node);      // node has one child and no key: splice it out
+    void collect(const Node* node, size_t& skip, size_t& limit, vector<V>& result) const;
+    template<typename Visitor>
+    bool visitSubtree(const Node* node, Visitor& visit) const;
+    size_t validNode(const Node* node, bool isRoot, bool& ok) const;  // returns the node count below and at node
+};
+
+#include "../solution/radix_trie.cpp"
@@ -0,0 +1,64 @@
+#pragma once
+#include "bst.h"
+using namespace std;
+
+/**
+ * Red-Black (self-balancing) Binary Search Tree
+ *
+ * Rebalancing does at most two rotations per insert and three per remove;
+ * the rest is recoloring. AVLTree can rotate at every level of a removal,
+ * but keeps a tighter height (~1.44 log2 n against 2 log2(n + 1)).
+ * Colors live in BSTNode::red. Heights, subtree sizes and Augment summaries
+ * are kept as in AVLTree, so rank/select and aggregateRange work unchanged.
+ */
+template<typename K, typename V, typename Compare = less<K>, typename Storage = SharedNodeStorage, typename Augment = NoAugmentation>
+class RBTree : public BST<K, V, Compare, Storage, Augment> {
+private:
+    using BSTNode = typename BST<K, V, Compare, Storage, Augment>::BSTNode;
+    using NodePtr = typename BST<K, V, Compare, Storage, Augment>::NodePtr;
+    using ParentPtr = typename BST<K, V, Compare, Storage, Augment>::ParentPtr;
+
+    static bool isRed(const NodePtr& node) { return node && node->red; }
+    static NodePtr parentOf(const NodePtr& node);
+    NodePtr& linkTo(const NodePtr& node);  // the child pointer (or root) that holds node
+
+    // Rotate in place, relinking the parent; the node moves down one level
+    void rotateLeft(NodePtr node);
+    void rotateRight(NodePtr node);
+
+    // Restore the color rules after an update. Each returns the top of the
+    // last (highest) rotation, whose ancestors' heights are then stale, or
+    // nullptr if only colors changed.
+    NodePtr insertFixup(NodePtr node);
+    NodePtr removeFixup(NodePtr node, NodePtr parent);  // node took a black node's place (may be null)
+    template<typename MakeNode, typename OnExisting>
+    bool insertWith(const K& key, MakeNode makeNode, OnExisting onExisting);
+
+public:
+    RBTree();
+    explicit RBTree(Compare comp);
+
+    bool insert(const K& key, const V& value) override;
+    bool insert(K&& key, V&& value);
+    bool remove(const K& key) override;
+
+    // Insert, or overwrite the value of an existing key. True if inserted.
+    template<typename M>
+    bool insert_or_assign(const K& key, M&& value);
+    template<typename M>
+    bool insert_or_assign(K&& key, M&& value);
+
+    // Construct the value in place only if the key is absent. True if inserted.
+    template<typename... Args>
+    bool try_emplace(const K& key, Args&&... args);
+    template<typename... Args>
+    bool try_emplace(K&& key, Args&&... args);
+
+    // Validation methods for testing
+    bool isValidRB() const;
+
+private:
+    int blackHeight(NodePtr node) const;  // -1 if a rule is broken below node
+};
+
+#include "../solution/rb_tree.cpp"
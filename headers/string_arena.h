@@ -0,0 +1,177 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+/**
+ * Handle to a string stored in a StringArena: 8 bytes in place of a
+ * std::string key and its heap copy. Only meaningful with its arena.
+ */
+struct InternedString {
+    uint32_t offset;  // suffix position in the arena's byte buffer
+    uint16_t prefix;  // shared prefix id, 0 for none
+    uint16_t length;  // suffix length
+};
+
+/**
+ * Interned storage for string keys, front-coded by shared prefix.
+ *
+ * A string is split after its first separator ('_', '.' or '-') within the
+ * first MAX_PREFIX bytes, unless the part before it holds a digit (such
+ * segments are rarely shared): "team_alpha" becomes the prefix "team_" plus the
+ * suffix "alpha". Each distinct prefix is stored once and every suffix is
+ * appended to one byte buffer, so names like team_*, bot_* or official_*
+ * pay for their common part once.
+ *
+ * The buffer is append-only: release() only counts a suffix as dead, and
+ * the owner reclaims the space by re-interning the live keys into a fresh
+ * arena once deadBytes() outgrows liveBytes().
+ */
+class StringArena {
+public:
+    static constexpr size_t MAX_PREFIX = 32;  // longer leading segments are not shared
+
+    StringArena() { clear(); }
+
+    InternedString intern(string_view text) {
+        uint16_t prefixID = prefixFor(text);
+        text.remove_prefix(prefixes[prefixID].text.size());
+        if (text.size() > UINT16_MAX)
+            throw std::length_error("string arena keys are at most 65535 bytes past their prefix");
+        if (bytes.size() + text.size() > UINT32_MAX)
+            throw std::length_error("string arena holds at most 4 GiB of suffixes");
+        InternedString key{static_cast<uint32_t>(bytes.size()), prefixID, static_cast<uint16_t>(text.size())};
+        bytes.insert(bytes.end(), text.begin(), text.end());
+        prefixes[prefixID].users++;
+        liveCount++;
+        live += text.size();
+        return key;
+    }
+
+    // The key must not be used afterwards; its bytes stay until the arena is rebuilt
+    void release(InternedString key) {
+        prefixes[key.prefix].users--;
+        liveCount--;
+        live -= key.length;
+        dead += key.length;
+    }
+
+    string_view prefixOf(InternedString key) const { return prefixes[key.prefix].text; }
+    string_view suffixOf(InternedString key) const { return string_view(bytes.data() + key.offset, key.length); }
+    size_t length(InternedString key) const { return prefixes[key.prefix].text.size() + key.length; }
+    string str(InternedString key) const { return string(prefixOf(key)).append(suffixOf(key)); }
+
+    // Three-way comparison of the full strings, same order as std::string
+    int compare(InternedString a, InternedString b) const {
+        if (a.prefix == b.prefix)
+            return suffixOf(a).compare(suffixOf(b));
+        return compareJoined(prefixOf(a), suffixOf(a), prefixOf(b), suffixOf(b));
+    }
+    int compare(InternedString a, string_view b) const {
+        return compareJoined(prefixOf(a), suffixOf(a), b, string_view());
+    }
+
+    bool startsWith(InternedString key, string_view text) const {
+        return text.size() <= length(key) &&
+               compareJoined(prefixOf(key), suffixOf(key), text, string_view(), text.size()) == 0;
+    }
+
+    size_t size() const { return liveCount; }      // keys interned and not released
+    size_t liveBytes() const { return live; }      // suffix bytes still referenced
+    size_t deadBytes() const { return dead; }      // suffix bytes of released keys
+    size_t prefixCount() const { return prefixes.size() - 1; }
+
+    // Heap bytes held: suffix buffer, prefix texts and the prefix lookup table
+    size_t memoryUsage() const {
+        size_t total = bytes.capacity() + prefixes.capacity() * sizeof(Prefix);
+        for (const Prefix& prefix : prefixes) {
+            // past the small-string buffer; the text is held here and as a prefixIDs key
+            if (prefix.text.capacity() > string().capacity())
+                total += 2 * (prefix.text.capacity() + 1);
+        }
+        // one node per entry plus the bucket array, as unordered_map allocates them
+        total += prefixIDs.size() * (sizeof(pair<const string, uint16_t>) + 2 * sizeof(void*)) +
+                 prefixIDs.bucket_count() * sizeof(void*);
+        return total;
+    }
+
+    void clear() {
+        bytes.clear();
+        prefixes.assign(1, Prefix{string(), 0});
+        prefixIDs.clear();
+        liveCount = live = dead = 0;
+    }
+
+private:
+    struct Prefix {
+        string text;
+        size_t users;  // live keys sharing it
+    };
+
+    vector<char> bytes;                          // suffixes, back to back
+    vector<Prefix> prefixes;                     // id -> prefix, id 0 is ""
+    unordered_map<string, uint16_t> prefixIDs;   // prefix text -> id
+    size_t liveCount, live, dead;
+
+    uint16_t prefixFor(string_view text) {
+        size_t end = text.substr(0, MAX_PREFIX).find_first_of("_.-");
+        // a digit before the separator ("x1234_") usually makes the segment unique
+        if (end == string_view::npos || text.substr(0, end).find_first_of("0123456789") != string_view::npos)
+            return 0;
+        string prefix(text.substr(0, end + 1));
+        auto found = prefixIDs.find(prefix);
+        if (found != prefixIDs.end())
+            return found->second;
+        if (prefixes.size() > UINT16_MAX)
+            return 0;  // table full: later prefixes are stored with their suffix
+        uint16_t id = static_cast<uint16_t>(prefixes.size());
+        prefixes.push_back(Prefix{prefix, 0});
+        prefixIDs.emplace(std::move(prefix), id);
+        return id;
+    }
+
+    // Compares a1 + a2 with b1 + b2 (at most `limit` bytes of each) without
+    // building either string. Bytes compare as unsigned char, like std::string.
+    static int compareJoined(string_view a1, string_view a2, string_view b1, string_view b2, size_t limit = SIZE_MAX) {
+        for (;;) {
+            if (a1.empty()) {
+                a1 = a2;
+                a2 = string_view();
+            }
+            if (b1.empty()) {
+                b1 = b2;
+                b2 = string_view();
+            }
+            if (limit == 0 || (a1.empty() && b1.empty()))
+                return 0;
+            if (a1.empty() || b1.empty())
+                return a1.empty() ? -1 : 1;
+            size_t n = std::min({a1.size(), b1.size(), limit});
+            if (int result = memcmp(a1.data(), b1.data(), n))
+                return result;
+            a1.remove_prefix(n);
+            b1.remove_prefix(n);
+            limit -= n;
+        }
+    }
+};
+
+/**
+ * Transparent comparator for InternedString keys. The tree only stores the
+ * 8-byte handles; every comparison reads the bytes through the arena, and
+ * string / string_view probes are compared against them in place.
+ */
+struct InternedStringCompare {
+    using is_transparent = void;
+    const StringArena* arena = nullptr;
+
+    bool operator()(const InternedString& a, const InternedString& b) const { return arena->compare(a, b) < 0; }
+    bool operator()(const InternedString& a, string_view b) const { return arena->compare(a, b) < 0; }
+    bool operator()(string_view a, const InternedString& b) const { return arena->compare(b, a) > 0; }
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+/**
+ * Fixed set of worker threads for fork-join loops over independent tasks,
+ * as used by the parallel tree traversals and checks.
+ *
+ * parallelFor hands task indices out from a shared counter and the calling
+ * thread takes tasks too, so a pool of n threads starts n - 1 workers and
+ * ThreadPool(1) runs everything inline. Tasks must not throw, and a pool
+ * runs one parallelFor at a time.
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads = std::max(1u, thread::hardware_concurrency())) {
+        for (size_t i = 1; i < threads; ++i)
+            workers.emplace_back([this]() { workerLoop(); });
+    }
+
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (thread& worker : workers)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size() + 1; }  // threads, the caller included
+
+    // Runs body(i) for every i in [0, count) and returns once all are done
+    template<typename Body>
+    void parallelFor(size_t count, Body body) {
+        if (workers.empty() || count <= 1) {
+            for (size_t i = 0; i < count; ++i)
+                body(i);
+            return;
+        }
+        {
+            lock_guard<mutex> guard(lock);
+            job = [&body](size_t i) { body(i); };
+            jobCount = count;
+            next = 0;
+            busy = workers.size();
+            generation++;
+        }
+        wake.notify_all();
+        runTasks();
+        unique_lock<mutex> guard(lock);
+        done.wait(guard, [this]() { return busy == 0; });
+        job = nullptr;
+    }
+
+private:
+    vector<thread> workers;
+    mutex lock;
+    condition_variable wake;  // a new job, or stopping
+    condition_variable done;  // the last worker left the current job
+    function<void(size_t)> job;
+    size_t jobCount = 0;
+    atomic<size_t> next{0};   // next task index to hand out
+    size_t busy = 0;          // workers not yet finished with the current job
+    uint64_t generation = 0;  // bumped per job, so a worker never runs one twice
+    bool stopping = false;
+
+    void runTasks() {
+        for (size_t i = next.fetch_add(1); i < jobCount; i = next.fetch_add(1))
+            job(i);
+    }
+
+    void workerLoop() {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                unique_lock<mutex> guard(lock);
+                wake.wait(guard, [&]() { return stopping || generation != seen; });
+                if (stopping)
+                    return;
+                seen = generation;
+            }
+            runTasks();
+            lock_guard<mutex> guard(lock);
+            if (--busy == 0)
+                done.notify_one();
+        }
+    }
+};
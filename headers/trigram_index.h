@@ -0,0 +1,347 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+/**
+ * Sorted set of int IDs stored as delta-varint blocks.
+ *
+ * IDs are flipped into order-preserving uint32 keys and split into blocks of
+ * at most BLOCK_SIZE. A block keeps its first key whole and every later one
+ * as the LEB128 varint of its gap to the previous key (one byte for gaps
+ * under 128), and caches its last key so a search can skip whole blocks
+ * without decoding them. Inserting or removing an ID re-encodes one block;
+ * appending past the end, as a load in ID order does, only writes one gap.
+ */
+class PostingList {
+public:
+    static constexpr size_t BLOCK_SIZE = 128;
+
+    bool insert(int id) {  // false if already present
+        uint32_t key = toKey(id);
+        if (blocks.empty() || key > blocks.back().last) {
+            if (blocks.empty() || blocks.back().size == BLOCK_SIZE) {
+                blocks.push_back(Block{key, key, 1, {}});
+            } else {
+                Block& last = blocks.back();
+                putVarint(last.gaps, key - last.last);
+                last.last = key;
+                last.size++;
+            }
+            count++;
+            return true;
+        }
+        size_t b = blockFor(key);
+        vector<uint32_t> keys;
+        decode(blocks[b], keys);
+        auto at = lower_bound(keys.begin(), keys.end(), key);
+        if (at != keys.end() && *at == key)
+            return false;
+        keys.insert(at, key);
+        if (keys.size() > BLOCK_SIZE) { //split the full block in two halves
+            size_t half = keys.size() / 2;
+            blocks[b] = encode(keys.data(), half);
+            blocks.insert(blocks.begin() + b + 1, encode(keys.data() + half, keys.size() - half));
+        } else {
+            blocks[b] = encode(keys.data(), keys.size());
+        }
+        count++;
+        return true;
+    }
+
+    bool remove(int id) {
+        uint32_t key = toKey(id);
+        size_t b = blockFor(key);
+        if (b == blocks.size() || key < blocks[b].first)
+            return false;
+        vector<uint32_t> keys;
+        decode(blocks[b], keys);
+        auto at = lower_bound(keys.begin(), keys.end(), key);
+        if (at == keys.end() || *at != key)
+            return false;
+        keys.erase(at);
+        // a block that shrinks to a quarter absorbs its successor if both fit in half a block
+        if (keys.size() < BLOCK_SIZE / 4 && b + 1 < blocks.size() && keys.size() + blocks[b + 1].size <= BLOCK_SIZE / 2) {
+            decode(blocks[b + 1], keys, true);
+            blocks.erase(blocks.begin() + b + 1);
+        }
+        if (keys.empty())
+            blocks.erase(blocks.begin() + b);
+        else
+            blocks[b] = encode(keys.data(), keys.size());
+        count--;
+        return true;
+    }
+
+    bool contains(int id) const {
+        Cursor cursor(*this);
+        return cursor.seek(id) && cursor.value() == id;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t blockCount() const { return blocks.size(); }
+    // Encoded size: block headers plus gap bytes
+    size_t byteCount() const {
+        size_t total = blocks.size() * 3 * sizeof(uint32_t);
+        for (const Block& block : blocks)
+            total += block.gaps.size();
+        return total;
+    }
+
+    vector<int> ids() const {
+        vector<int> result;
+        result.reserve(count);
+        for (Cursor cursor(*this); !cursor.atEnd(); cursor.next())
+            result.push_back(cursor.value());
+        return result;
+    }
+
+    // Blocks are non-empty, at most BLOCK_SIZE, strictly ascending within and
+    // across blocks, their cached first/last/size match the bytes
+    bool isValid() const {
+        size_t total = 0;
+        vector<uint32_t> keys;
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            const Block& block = blocks[b];
+            decode(block, keys);
+            if (keys.size() != block.size || keys.empty() || keys.size() > BLOCK_SIZE || keys.back() != block.last)
+                return false;
+            if (adjacent_find(keys.begin(), keys.end(), [](uint32_t a, uint32_t c) { return a >= c; }) != keys.end())
+                return false;
+            if (b > 0 && blocks[b - 1].last >= block.first)
+                return false;
+            total += keys.size();
+        }
+        return total == count;
+    }
+
+    /**
+     * Forward cursor over the IDs in ascending order. seek(id) moves to the
+     * first ID >= id by galloping: doubling steps over the block ends, then
+     * inside the decoded block, so a seek d entries ahead costs O(log d).
+     */
+    class Cursor {
+    public:
+        explicit Cursor(const PostingList& list) : list(&list), block(0), pos(0) { load(0); }
+
+        bool atEnd() const { return pos == keys.size(); }
+        int value() const { return toID(keys[pos]); }
+        void next() {
+            if (++pos == keys.size())
+                load(block + 1);
+        }
+        bool seek(int id) {  // false once past the last ID
+            uint32_t key = toKey(id);
+            if (atEnd() || key <= keys[pos])
+                return !atEnd();
+            const vector<Block>& blocks = list->blocks;
+            if (key > blocks[block].last) {
+                size_t low = block, step = 1;  // blocks[low].last < key
+                while (low + step < blocks.size() && blocks[low + step].last < key) {
+                    low += step;
+                    step *= 2;
+                }
+                size_t high = std::min(low + step, blocks.size());
+                auto found = lower_bound(blocks.begin() + low + 1, blocks.begin() + high, key,
+                                         [](const Block& b, uint32_t k) { return b.last < k; });
+                load(found - blocks.begin());
+                if (atEnd())
+                    return false;
+            }
+            size_t low = pos, step = 1;  // keys[low] < key
+            while (low + step < keys.size() && keys[low + step] < key) {
+                low += step;
+                step *= 2;
+            }
+            pos = lower_bound(keys.begin() + low, keys.begin() + std::min(low + step, keys.size()), key) - keys.begin();
+            return true;  // the block's last key is >= key
+        }
+
+    private:
+        const PostingList* list;
+        size_t block;
+        vector<uint32_t> keys;  // the current block, decoded
+        size_t pos;
+
+        void load(size_t b) {
+            block = b;
+            pos = 0;
+            if (b < list->blocks.size())
+                decode(list->blocks[b], keys);
+            else
+                keys.clear();
+        }
+    };
+
+private:
+    struct Block {
+        uint32_t first;
+        uint32_t last;
+        uint32_t size;
+        vector<uint8_t> gaps;  // varint gaps of keys 2..size
+    };
+
+    vector<Block> blocks;
+    size_t count = 0;
+
+    static uint32_t toKey(int id) { return static_cast<uint32_t>(id) ^ 0x80000000u; }
+    static int toID(uint32_t key) { return static_cast<int>(key ^ 0x80000000u); }
+
+    static void putVarint(vector<uint8_t>& out, uint32_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    static void decode(const Block& block, vector<uint32_t>& out, bool append = false) {
+        if (!append)
+            out.clear();
+        uint32_t key = block.first;
+        out.push_back(key);
+        for (size_t i = 0; i < block.gaps.size();) {
+            uint32_t gap = 0;
+            for (int shift = 0;; shift += 7) {
+                uint8_t byte = block.gaps[i++];
+                gap |= static_cast<uint32_t>(byte & 0x7f) << shift;
+                if (!(byte & 0x80))
+                    break;
+            }
+            key += gap;
+            out.push_back(key);
+        }
+    }
+
+    static Block encode(const uint32_t* keys, size_t n) {
+        Block block{keys[0], keys[n - 1], static_cast<uint32_t>(n), {}};
+        for (size_t i = 1; i < n; ++i)
+            putVarint(block.gaps, keys[i] - keys[i - 1]);
+        return block;
+    }
+
+    // First block whose last key is >= key, or blocks.size()
+    size_t blockFor(uint32_t key) const {
+        return lower_bound(blocks.begin(), blocks.end(), key, [](const Block& b, uint32_t k) { return b.last < k; }) - blocks.begin();
+    }
+};
+
+/**
+ * Inverted index from byte trigrams to the IDs of the texts holding them,
+ * for substring search.
+ *
+ * A text of length L is filed under its (at most L - 2) distinct trigrams.
+ * Every text containing a pattern of 3 or more bytes holds all of the
+ * pattern's trigrams, so intersecting their posting lists yields a small
+ * superset of the matches; the caller confirms each candidate against its
+ * text. The intersection walks the shortest list and gallops the others
+ * (and itself) forward to each candidate, touching O(k log(n / k)) entries
+ * for lists of n and k IDs.
+ */
+class TrigramIndex {
+public:
+    static constexpr size_t GRAM = 3;  // patterns shorter than this cannot use the index
+
+    // Files id under text's trigrams; id must not be in the index yet
+    void insert(int id, string_view text) {
+        for (uint32_t gram : trigramsOf(text))
+            lists[gram].insert(id);
+        documents++;
+    }
+
+    // text must be the one id was inserted with
+    void remove(int id, string_view text) {
+        for (uint32_t gram : trigramsOf(text)) {
+            auto list = lists.find(gram);
+            if (list != lists.end() && list->second.remove(id) && list->second.empty())
+                lists.erase(list);
+        }
+        documents--;
+    }
+
+    // IDs, ascending, of the texts holding every trigram of pattern
+    // (|pattern| >= GRAM): the texts containing pattern and possibly others
+    vector<int> candidates(string_view pattern) const {
+        vector<int> result;
+        vector<const PostingList*> postings;
+        for (uint32_t gram : trigramsOf(pattern)) {
+            auto list = lists.find(gram);
+            if (list == lists.end())
+                return result;  // no text holds this trigram
+            postings.push_back(&list->second);
+        }
+        if (postings.empty())
+            return result;
+        sort(postings.begin(), postings.end(), [](const PostingList* a, const PostingList* b) { return a->size() < b->size(); });
+        vector<PostingList::Cursor> cursors;
+        for (const PostingList* list : postings)
+            cursors.emplace_back(*list);
+        // leapfrog: each list in turn jumps to the highest ID seen so far;
+        // once every list agrees on an ID, it is a candidate
+        int target = cursors[0].value();
+        size_t agreeing = 1, i = 1;
+        while (true) {
+            if (agreeing == cursors.size()) {
+                result.push_back(target);
+                cursors[0].next();
+                if (cursors[0].atEnd())
+                    break;
+                target = cursors[0].value();
+                agreeing = 1;
+                i = 1 % cursors.size();
+                continue;
+            }
+            if (!cursors[i].seek(target))
+                break;
+            if (cursors[i].value() == target) {
+                agreeing++;
+            } else {
+                target = cursors[i].value();
+                agreeing = 1;
+            }
+            i = (i + 1) % cursors.size();
+        }
+        return result;
+    }
+
+    size_t size() const { return documents; }  // texts indexed, short ones included
+    size_t trigramCount() const { return lists.size(); }
+    size_t byteCount() const {  // encoded posting bytes
+        size_t total = 0;
+        for (const auto& list : lists)
+            total += list.second.byteCount();
+        return total;
+    }
+    void clear() {
+        lists.clear();
+        documents = 0;
+    }
+
+    // Every posting list is non-empty and well formed
+    bool isValid() const {
+        for (const auto& list : lists) {
+            if (list.second.empty() || !list.second.isValid())
+                return false;
+        }
+        return true;
+    }
+
+private:
+    unordered_map<uint32_t, PostingList> lists;  // trigram bytes packed big-endian
+    size_t documents = 0;
+
+    static vector<uint32_t> trigramsOf(string_view text) {
+        vector<uint32_t> grams;
+        for (size_t i = 0; i + GRAM <= text.size(); ++i)
+            grams.push_back(static_cast<uint32_t>(static_cast<unsigned char>(text[i])) << 16 |
+                            static_cast<uint32_t>(static_cast<unsigned char>(text[i + 1])) << 8 |
+                            static_cast<unsigned char>(text[i + 2]));
+        sort(grams.begin(), grams.end());
+        grams.erase(unique(grams.begin(), grams.end()), grams.end());
+        return grams;
+    }
+};
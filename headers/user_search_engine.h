@@ -1,22 +1,108 @@
 #pragma once
 #include "avl_tree.h"
+#include "bplus_tree.h"
+#include "frozen_index.h"
+#include "radix_trie.h"
+#include "bk_tree.h"
+#include "string_arena.h"
+#include "trigram_index.h"
 #include "../headers/linked_list.h"
 #include "../headers/user.h"
+#include "../headers/follow_list.h"
 #include <string>
+#include <string_view>
+#include <unordered_set>
 #include <vector>
 using namespace std;
 
+/**
+ * Tree type behind both indexes, picked at compile time. Build with
+ * -DUSER_SEARCH_BPLUS_INDEX to back them with BPlusTree instead of AVLTree.
+ */
+#ifdef USER_SEARCH_BPLUS_INDEX
+template<typename K, typename V, typename Compare = less<K>>
+using UserIndex = BPlusTree<K, V, Compare>;
+#else
+template<typename K, typename V, typename Compare = less<K>>
+using UserIndex = AVLTree<K, V, Compare>;
+#endif
+
+/**
+ * Key type of the name index. By default each node holds a string copy of
+ * the username; build with -DUSER_SEARCH_INTERNED_NAMES to key it by an
+ * 8-byte handle into the engine's prefix-sharing StringArena instead.
+ */
+#ifdef USER_SEARCH_INTERNED_NAMES
+using NameKey = InternedString;
+using NameIndex = UserIndex<InternedString, User*, InternedStringCompare>;
+#else
+using NameKey = string;
+using NameIndex = UserIndex<string, User*>;
+#endif
+
+/**
+ * Activity totals over a set of users. Users carry no follower list, so
+ * `following` sums how many accounts each user follows.
+ */
+struct UserActivity {
+    size_t users;
+    size_t posts;
+    size_t following;
+};
+
+// Augmentation policy for an index of User*: each node sums its subtree's activity
+struct UserActivityAugment {
+    using Summary = UserActivity;
+    static Summary identity() { return {0, 0, 0}; }
+    template<typename K>
+    static Summary fromEntry(const K&, User* const& user) {
+        return {1, user->posts.size(), user->following ? user->following->size() : 0};
+    }
+    static Summary combine(const Summary& a, const Summary& b) {
+        return {a.users + b.users, a.posts + b.posts, a.following + b.following};
+    }
+};
+
+/**
+ * Tree type of the ID index. As an AVLTree it carries the per-subtree
+ * activity totals behind getActivityInIDRange; B+-tree leaves keep no
+ * summaries, so in that mode a range's totals are summed from a leaf scan.
+ */
+#ifdef USER_SEARCH_BPLUS_INDEX
+using IDIndex = UserIndex<int, User*>;
+#else
+using IDIndex = AVLTree<int, User*, less<int>, SharedNodeStorage, UserActivityAugment>;
+#endif
+
 /**
  * High-performance user search engine using AVL trees
  */
 class UserSearchEngine {
 protected:
-    AVLTree<int, User*> usersByID;           // Primary index: userID -> User*
-    AVLTree<string, User*> usersByName; // Secondary index: username -> User*
+    IDIndex usersByID;           // Primary index: userID -> User*, with activity totals
+    StringArena nameArena;  // username bytes behind usersByName's keys (interned mode only)
+    NameIndex usersByName; // Secondary index: username -> User*
+
+    // Read-optimized copy of usersByID that searchByID answers from once
+    // freezeIDIndex() has been called; later adds/removes go to the delta.
+    FrozenIndex<int, User*> frozenByID;
+    AVLTree<int, User*> idDelta;      // users added since the last freeze
+    unordered_set<int> idTombstones;  // frozen IDs removed since the last freeze
+    bool idIndexFrozen;
+
+    // username -> User* as a compressed radix trie with per-subtree counts,
+    // serving the prefix queries (autocomplete) without string comparisons
+    RadixTrie<User*> namesTrie;
+    // username -> User* by edit distance, for fuzzyUsernameSearch
+    BKTree<User*> namesFuzzy;
+    // name trigram -> compressed sorted userIDs, for searchByUsernameSubstring
+    TrigramIndex namesTrigrams;
 
 public:
     UserSearchEngine();
     ~UserSearchEngine();
+    UserSearchEngine(const UserSearchEngine&) = delete;  // usersByName's comparator may point at nameArena
+    UserSearchEngine& operator=(const UserSearchEngine&) = delete;
     
     // Migration from PA1 - students must implement
     void migrateFromLinkedList(const LinkedList<User>& userList);
@@ -25,26 +111,83 @@ public:
     bool addUser(User* user);
     bool removeUser(int userID);
     bool removeUser(const string& username);
+
+    // Bulk forms for imports: each index takes the whole batch in one
+    // insertBatch/removeBatch. result[i] is what addUser(users[i]) /
+    // removeUser(userIDs[i]) would return if the batch ran in order.
+    vector<bool> addUsers(const vector<User*>& users);
+    vector<bool> removeUsers(const vector<int>& userIDs);
     
     // Search operations - students must implement
     User* searchByID(int userID) const;
-    User* searchByUsername(const string& username) const;
-    vector<User*> searchByUsernamePrefix(const string& prefix) const;
+    // Names are taken as string_view (a string, literal or buffer slice all
+    // convert) and compared against the index in place, without a copy.
+    User* searchByUsername(string_view username) const;
+    vector<User*> searchByUsernamePrefix(string_view prefix) const;
+    // Autocomplete: the offset-th to (offset + limit)-th users, in name order,
+    // whose names start with prefix, and how many there are in all.
+    // O(|prefix| + limit) through the trie's subtree counts.
+    vector<User*> getUsernameCompletions(string_view prefix, size_t limit = 10, size_t offset = 0) const;
+    size_t countUsersWithPrefix(string_view prefix) const;
     vector<User*> getUsersInIDRange(int minID, int maxID) const;
+
+    // Batched forms for nearly sorted input (e.g. consecutive IDs from an
+    // export): one finger-search cursor serves the whole batch, so each
+    // lookup costs O(log d) for an ID d entries from the previous one.
+    // result[i] is what searchByID / getUsersInIDRange gives for entry i.
+    vector<User*> searchByIDs(const vector<int>& userIDs) const;
+    vector<vector<User*>> getUsersInIDRanges(const vector<pair<int, int>>& ranges) const;
     
     // Advanced search features - students must implement
-    vector<User*> fuzzyUsernameSearch(const string& username, int maxEditDistance = 2) const;
+    vector<User*> fuzzyUsernameSearch(string_view username, int maxEditDistance = 2) const;
+    // The k best users within maxEditDistance of query, best first: by edit
+    // distance, then by the length of the prefix the name shares with query,
+    // then by post count. Subtrees of the fuzzy index that cannot beat the
+    // current k-th user are never scored.
+    vector<User*> fuzzyTopK(string_view query, size_t k, int maxEditDistance = 2) const;
+    // Users whose name contains pattern, in ID order. Patterns of 3 or more
+    // bytes intersect the trigram index's posting lists and check only the
+    // names it returns; shorter ones scan every name.
+    vector<User*> searchByUsernameSubstring(string_view pattern) const;
     vector<User*> getAllUsersSorted(bool byID = true) const;
+    vector<User*> getUsersSortedPage(size_t offset, size_t limit, bool byID = true) const;
+    size_t countUsersInIDRange(int minID, int maxID) const;
+
+    // Post / following totals of the users in [minID, maxID], from O(log n) nodes.
+    // addPost / followUser / unfollowUser keep them current; after changing
+    // a User directly, call refreshUserActivity for it.
+    UserActivity getActivityInIDRange(int minID, int maxID) const;
+    bool refreshUserActivity(int userID);
+    bool addPost(int userID, int postID, const string& category);
+    bool followUser(int followerID, int followeeID);
+    bool unfollowUser(int followerID, int followeeID);
+
+    // Snapshot usersByID into frozenByID. After the first call the snapshot
+    // is rebuilt automatically whenever the delta outgrows 1/8 of it.
+    void freezeIDIndex();
+
+    // Write usersByID / usersByName to <pathPrefix>.ids / .names with
+    // saveBinary, storing each user as its ID. loadIndexes rebuilds every
+    // index from those files in O(n), resolving IDs against userList; if a
+    // file is missing or no longer matches the users (unknown ID, renamed
+    // user) it returns false and leaves the engine empty.
+    bool saveIndexes(const string& pathPrefix) const;
+    bool loadIndexes(const string& pathPrefix, const LinkedList<User>& userList);
     
     // Statistics and utilities
     size_t getTotalUsers() const;
     void displaySearchStats() const;
     bool isConsistent() const;  // Verify both indices are in sync
+    // Same checks over usersByID and usersByName with every whole-index walk
+    // split across threads
+    bool isConsistent(ThreadPool& threads) const;
     
 private:
     // Helper methods for fuzzy search
     int calculateEditDistance(const string& str1, const string& str2) const;
-    void collectPrefixMatches(const AVLTree<string, User*>& tree, const string& prefix, vector<User*>& results) const;
+    void recordIDChange(int userID, User* addedUser);  // addedUser is nullptr for a removal
+    void compactNameKeys();  // re-interns live names once released ones dominate nameArena
+    void clearIndexes();
 };
 
 // #include "../solution/user_search_engine.cpp"
\ No newline at end of file
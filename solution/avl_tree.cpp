@@ -1,89 +1,158 @@
 #include "../headers/avl_tree.h"
 #include <algorithm>
 #include <cmath>
+#include <numeric>
+#include <stdexcept>
 using namespace std;
 
-template<typename K, typename V>
-AVLTree<K, V>::AVLTree() : BST<K, V>() {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+AVLTree<K, V, Compare, Storage, Augment>::AVLTree() : BST<K, V, Compare, Storage, Augment>() {
 }
 
-template<typename K, typename V>
-AVLTree<K, V>::AVLTree(function<bool(const K&, const K&)> comp) : BST<K, V>(comp) {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+AVLTree<K, V, Compare, Storage, Augment>::AVLTree(Compare comp) : BST<K, V, Compare, Storage, Augment>(std::move(comp)) {
 }
 
-template<typename K, typename V>
-bool AVLTree<K, V>::insert(const K& key, const V& value) {
-    if (this->find(key))
-    {
-        return false;
-    }
-    this->root = insertAVL(this->root,key,value);
-    this->nodeCount++;
-    return true;
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+bool AVLTree<K, V, Compare, Storage, Augment>::insert(const K& key, const V& value) {
+    return insertWith(key,
+        [&]() { return this->createNode(key, value); },
+        [](NodePtr) {});
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+bool AVLTree<K, V, Compare, Storage, Augment>::insert(K&& key, V&& value) {
+    // key is only read during the descent; it is moved into the leaf at the end
+    return insertWith(key,
+        [&]() { return this->createNode(std::move(key), std::move(value)); },
+        [](NodePtr) {});
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename M>
+bool AVLTree<K, V, Compare, Storage, Augment>::insert_or_assign(const K& key, M&& value) {
+    return insertWith(key,
+        [&]() { return this->createNode(key, std::forward<M>(value)); },
+        [&](NodePtr node) { node->value = std::forward<M>(value); this->valueChanged(node); });
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename M>
+bool AVLTree<K, V, Compare, Storage, Augment>::insert_or_assign(K&& key, M&& value) {
+    return insertWith(key,
+        [&]() { return this->createNode(std::move(key), std::forward<M>(value)); },
+        [&](NodePtr node) { node->value = std::forward<M>(value); this->valueChanged(node); });
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename... Args>
+bool AVLTree<K, V, Compare, Storage, Augment>::try_emplace(const K& key, Args&&... args) {
+    return insertWith(key,
+        [&]() { return this->createNode(key, V(std::forward<Args>(args)...)); },
+        [](NodePtr) {});
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename... Args>
+bool AVLTree<K, V, Compare, Storage, Augment>::try_emplace(K&& key, Args&&... args) {
+    return insertWith(key,
+        [&]() { return this->createNode(std::move(key), V(std::forward<Args>(args)...)); },
+        [](NodePtr) {});
+}
 
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename MakeNode, typename OnExisting>
+bool AVLTree<K, V, Compare, Storage, Augment>::insertWith(const K& key, MakeNode makeNode, OnExisting onExisting) {
+    this->statsOperation();
+    bool inserted = false;
+    this->root = insertAVL(this->root, key, makeNode, onExisting, inserted);
+    this->root->parent = ParentPtr();
+    if (inserted)
+        this->nodeCount++;
+    return inserted;
 }
 
-template<typename K, typename V>
-shared_ptr<typename AVLTree<K, V>::BSTNode> AVLTree<K, V>::insertAVL(shared_ptr<BSTNode> node, const K& key, const V& value) {
-    if (node ==nullptr)
-        return make_shared<BSTNode>(key,value);
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename MakeNode, typename OnExisting>
+typename AVLTree<K, V, Compare, Storage, Augment>::NodePtr AVLTree<K, V, Compare, Storage, Augment>::insertAVL(NodePtr node, const K& key, MakeNode& makeNode, OnExisting& onExisting, bool& inserted) {
+    if (node ==nullptr) {
+        inserted = true;
+        return makeNode();
+    }
+    this->statsVisit();
     if (this->comparator(key,node->key)) //key<node.key -- go left
     {
-        node->left = insertAVL(node->left,key,value);
-        if (node->left)
+        node->left = insertAVL(node->left,key,makeNode,onExisting,inserted);
         node->left->parent=node;
     }
-    else
+    else if (this->comparator(node->key,key)) //key>node.key -- go right
     {
-        node->right = insertAVL(node->right,key,value);
-        if (node->right)
+        node->right = insertAVL(node->right,key,makeNode,onExisting,inserted);
         node->right->parent=node;
     }
+    else //already present, nothing below changes
+    {
+        onExisting(node);
+        return node;
+    }
+    if (!inserted)
+        return node;
     this->updateHeight(node);
     return rebalance(node);
 }
 
-template<typename K, typename V>
-bool AVLTree<K, V>::remove(const K& key) {
-    if (this->find(key)==nullptr){
-        return false;
-    }
-    this->root = removeAVL(this->root,key);
-    this->nodeCount--;
-    return true;
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+bool AVLTree<K, V, Compare, Storage, Augment>::remove(const K& key) {
+    this->statsOperation();
+    bool removed = false;
+    this->root = removeAVL(this->root,key,removed);
+    if (this->root)
+        this->root->parent = ParentPtr();
+    if (removed)
+        this->nodeCount--;
+    return removed;
 }
 
-template<typename K, typename V>
-shared_ptr<typename AVLTree<K, V>::BSTNode> AVLTree<K, V>::removeAVL(shared_ptr<BSTNode> node, const K& key) {
-    {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename AVLTree<K, V, Compare, Storage, Augment>::NodePtr AVLTree<K, V, Compare, Storage, Augment>::removeAVL(NodePtr node, const K& key, bool& removed) {
     // finds the key,
     // if no child then remove.
     // if one child then assign child to parent.
-    // if two child then replace it with PSN or NGE.
+    // if two child then replace it with NGE, unlinked in the same descent.
     if (node == nullptr)
-            return nullptr;
+            return nullptr; //not found
+    this->statsVisit();
     if (this->comparator(node->key,key)) //node.key is less than key to find. move right
     {
-        node->right = removeAVL(node->right,key);
+        node->right = removeAVL(node->right,key,removed);
     }
     else if (this->comparator(key,node->key)) //key<node.key
     {
-        node->left = removeAVL(node->left,key);
+        node->left = removeAVL(node->left,key,removed);
     }
     else{ //node found
+        removed = true;
         if (node->right == nullptr) //right doesnt exist
         {
-            return node->left;
+            NodePtr child = node->left;
+            this->destroyNode(node);
+            return child;
         }
         if (node->left == nullptr) //left doesnt exist
-            return node->right;
-        //both children exist, replace with Next greater element.
-        // change key value, then call remove on the NGE node
-        auto nge = (this->findMinHelper(node->right));
-        node->key = nge->key;
-        node->value = nge->value;
-        node->right = removeAVL(node->right,nge->key);
+        {
+            NodePtr child = node->right;
+            this->destroyNode(node);
+            return child;
+        }
+        //both children exist: detach the next greater element and move its entry here
+        NodePtr nge = nullptr;
+        node->right = removeMinAVL(node->right,nge);
+        node->key = std::move(nge->key);
+        node->value = std::move(nge->value);
+        this->destroyNode(nge);
     }
+    if (!removed)
+        return node;
     if (node->left)
     node->left->parent = node;
     if (node->right)
@@ -92,12 +161,299 @@ shared_ptr<typename AVLTree<K, V>::BSTNode> AVLTree<K, V>::removeAVL(shared_ptr<
     this->updateHeight(node);
     return rebalance(node);
 }
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename AVLTree<K, V, Compare, Storage, Augment>::NodePtr AVLTree<K, V, Compare, Storage, Augment>::removeMinAVL(NodePtr node, NodePtr& minNode) {
+    if (node->left == nullptr) {
+        minNode = node;
+        return node->right;
+    }
+    node->left = removeMinAVL(node->left,minNode);
+    if (node->left)
+    node->left->parent = node;
+    this->updateHeight(node);
+    return rebalance(node);
 }
 
-template<typename K, typename V>
-shared_ptr<typename AVLTree<K, V>::BSTNode> AVLTree<K, V>::rotateLeft(shared_ptr<BSTNode> node) {
-    shared_ptr<BSTNode> child =  node->right;
-    shared_ptr<BSTNode> T1 =  child->left;
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename InputIt>
+void AVLTree<K, V, Compare, Storage, Augment>::buildFromSorted(InputIt first, InputIt last) {
+    vector<pair<K, V>> items;
+    for (; first != last; ++first) {
+        auto&& item = *first;
+        if (!items.empty() && !this->comparator(items.back().first, item.first)) {
+            if (this->comparator(item.first, items.back().first))
+                throw std::invalid_argument("buildFromSorted: keys must be ascending");
+            continue; //equal key, the earlier entry wins
+        }
+        items.emplace_back(std::forward<decltype(item)>(item));
+    }
+    this->clear();
+    this->root = buildBalanced(items, 0, items.size());
+    this->nodeCount = items.size();
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename InputIt>
+void AVLTree<K, V, Compare, Storage, Augment>::buildFrom(InputIt first, InputIt last) {
+    vector<pair<K, V>> items(first, last);
+    std::stable_sort(items.begin(), items.end(), [this](const pair<K, V>& a, const pair<K, V>& b) {
+        return this->comparator(a.first, b.first);
+    });
+    buildFromSorted(make_move_iterator(items.begin()), make_move_iterator(items.end()));
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename EncodeValue, typename EncodeKey>
+bool AVLTree<K, V, Compare, Storage, Augment>::saveBinary(const string& path, EncodeValue encodeValue, EncodeKey encodeKey) const {
+    return saveIndexFile<K, V>(*this, path, encodeKey, encodeValue);
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename StoredValue, typename StoredKey, typename DecodeValue, typename DecodeKey>
+bool AVLTree<K, V, Compare, Storage, Augment>::loadBinary(const string& path, DecodeValue decodeValue, DecodeKey decodeKey) {
+    vector<pair<K, V>> items;
+    auto less = [this](const K& a, const K& b) { return this->comparator(a, b); };
+    if (!readSortedIndexFile<StoredKey, StoredValue>(path, items, less, decodeKey, decodeValue))
+        return false;
+    buildFromSorted(make_move_iterator(items.begin()), make_move_iterator(items.end()));
+    return true;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename AVLTree<K, V, Compare, Storage, Augment>::NodePtr AVLTree<K, V, Compare, Storage, Augment>::buildBalanced(vector<pair<K, V>>& items, size_t lo, size_t hi) {
+    // middle element becomes the root, so sibling subtrees differ by at most one node
+    if (lo >= hi)
+        return nullptr;
+    size_t mid = lo + (hi - lo) / 2;
+    NodePtr node = this->createNode(std::move(items[mid].first), std::move(items[mid].second));
+    node->left = buildBalanced(items, lo, mid);
+    node->right = buildBalanced(items, mid + 1, hi);
+    if (node->left)
+        node->left->parent = node;
+    if (node->right)
+        node->right->parent = node;
+    this->updateHeight(node);
+    return node;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+vector<bool> AVLTree<K, V, Compare, Storage, Augment>::insertBatch(vector<pair<K, V>> entries) {
+    vector<bool> inserted(entries.size(), false);
+    // stable, so the first of several equal keys is the one that gets in
+    vector<size_t> order(entries.size());
+    iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return this->comparator(entries[a].first, entries[b].first);
+    });
+
+    if (!batchPrefersRebuild(entries.size(), this->nodeCount)) {
+        for (size_t i : order)
+            inserted[i] = insert(std::move(entries[i].first), std::move(entries[i].second));
+        return inserted;
+    }
+
+    vector<NodePtr> existing = detachInOrder();
+    vector<NodePtr> merged;
+    merged.reserve(existing.size() + entries.size());
+    size_t next = 0;
+    for (size_t i : order) {
+        const K& key = entries[i].first;
+        while (next < existing.size() && this->comparator(existing[next]->key, key))
+            merged.push_back(std::move(existing[next++]));
+        bool inTree = next < existing.size() && !this->comparator(key, existing[next]->key);
+        bool earlierInBatch = !merged.empty() && !this->comparator(merged.back()->key, key);
+        if (inTree || earlierInBatch)
+            continue;
+        merged.push_back(this->createNode(std::move(entries[i].first), std::move(entries[i].second)));
+        inserted[i] = true;
+    }
+    merged.insert(merged.end(), make_move_iterator(existing.begin() + next), make_move_iterator(existing.end()));
+    this->root = linkBalanced(merged, 0, merged.size());
+    if (this->root)
+        this->root->parent = ParentPtr();
+    this->nodeCount = merged.size();
+    return inserted;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+vector<bool> AVLTree<K, V, Compare, Storage, Augment>::removeBatch(vector<K> keys) {
+    vector<bool> removed(keys.size(), false);
+    vector<size_t> order(keys.size());
+    iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return this->comparator(keys[a], keys[b]);
+    });
+
+    if (!batchPrefersRebuild(keys.size(), this->nodeCount)) {
+        for (size_t i : order)
+            removed[i] = remove(keys[i]);
+        return removed;
+    }
+
+    vector<NodePtr> existing = detachInOrder();
+    vector<NodePtr> kept;
+    kept.reserve(existing.size());
+    size_t next = 0;
+    for (size_t i : order) {
+        while (next < existing.size() && this->comparator(existing[next]->key, keys[i]))
+            kept.push_back(std::move(existing[next++]));
+        if (next < existing.size() && !this->comparator(keys[i], existing[next]->key)) {
+            this->destroyNode(std::move(existing[next++]));
+            removed[i] = true;
+        }
+    }
+    kept.insert(kept.end(), make_move_iterator(existing.begin() + next), make_move_iterator(existing.end()));
+    this->root = linkBalanced(kept, 0, kept.size());
+    if (this->root)
+        this->root->parent = ParentPtr();
+    this->nodeCount = kept.size();
+    return removed;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+vector<typename AVLTree<K, V, Compare, Storage, Augment>::NodePtr> AVLTree<K, V, Compare, Storage, Augment>::detachInOrder() {
+    // the child links are left stale; linkBalanced overwrites every one of them
+    vector<NodePtr> nodes;
+    nodes.reserve(this->nodeCount);
+    vector<NodePtr> pending;
+    NodePtr node = this->root;
+    while (node || !pending.empty()) {
+        for (; node; node = node->left)
+            pending.push_back(node);
+        node = std::move(pending.back());
+        pending.pop_back();
+        nodes.push_back(node);
+        node = node->right;
+    }
+    this->root = nullptr;
+    return nodes;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename AVLTree<K, V, Compare, Storage, Augment>::NodePtr AVLTree<K, V, Compare, Storage, Augment>::linkBalanced(vector<NodePtr>& nodes, size_t lo, size_t hi) {
+    // same shape as buildBalanced, but reuses the nodes instead of allocating
+    if (lo >= hi)
+        return nullptr;
+    size_t mid = lo + (hi - lo) / 2;
+    NodePtr node = nodes[mid];
+    node->left = linkBalanced(nodes, lo, mid);
+    node->right = linkBalanced(nodes, mid + 1, hi);
+    if (node->left)
+        node->left->parent = node;
+    if (node->right)
+        node->right->parent = node;
+    this->updateHeight(node);
+    return node;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+AVLTree<K, V, Compare, Storage, Augment> AVLTree<K, V, Compare, Storage, Augment>::split(const K& key) {
+    AVLTree right(this->keyCompare());
+    auto parts = splitAVL(this->root, key, false);
+    this->root = parts.first;
+    right.root = parts.second;
+    for (AVLTree* tree : {this, &right}) {
+        if (tree->root)
+            tree->root->parent = ParentPtr();
+        tree->nodeCount = this->getSize(tree->root);
+    }
+    right.pool.shareBlocks(this->pool);
+    return right;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+void AVLTree<K, V, Compare, Storage, Augment>::join(AVLTree& right) {
+    if (this == &right || right.empty())
+        return;
+    if (!this->empty() && !this->comparator(this->max().first, right.min().first))
+        throw std::invalid_argument("join: keys of the right tree must all be greater");
+    this->root = joinAVL(this->root, right.root);
+    this->root->parent = ParentPtr();
+    this->nodeCount += right.nodeCount;
+    this->pool.adopt(right.pool);
+    right.root = nullptr;
+    right.nodeCount = 0;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+size_t AVLTree<K, V, Compare, Storage, Augment>::removeRange(const K& minKey, const K& maxKey) {
+    if (this->comparator(maxKey, minKey))
+        return 0;
+    // [ < minKey | minKey..maxKey | > maxKey ]: cut twice, drop the middle, glue the ends
+    auto lower = splitAVL(this->root, minKey, false);
+    auto upper = splitAVL(lower.second, maxKey, true);
+    size_t removed = this->getSize(upper.first);
+    this->destroySubtree(std::move(upper.first));
+    this->root = joinAVL(lower.first, upper.second);
+    if (this->root)
+        this->root->parent = ParentPtr();
+    this->nodeCount -= removed;
+    return removed;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename AVLTree<K, V, Compare, Storage, Augment>::NodePtr AVLTree<K, V, Compare, Storage, Augment>::joinAVL(NodePtr left, NodePtr middle, NodePtr right) {
+    int hl = this->getHeight(left);
+    int hr = this->getHeight(right);
+    if (hl > hr + 1) { //walk down the right spine of the taller left tree
+        left->right = joinAVL(left->right, middle, right);
+        left->right->parent = left;
+        this->updateHeight(left);
+        return rebalance(left);
+    }
+    if (hr > hl + 1) { //walk down the left spine of the taller right tree
+        right->left = joinAVL(left, middle, right->left);
+        right->left->parent = right;
+        this->updateHeight(right);
+        return rebalance(right);
+    }
+    middle->left = left;
+    middle->right = right;
+    if (left)
+        left->parent = middle;
+    if (right)
+        right->parent = middle;
+    this->updateHeight(middle);
+    return middle;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename AVLTree<K, V, Compare, Storage, Augment>::NodePtr AVLTree<K, V, Compare, Storage, Augment>::joinAVL(NodePtr left, NodePtr right) {
+    if (!left)
+        return right;
+    if (!right)
+        return left;
+    //the minimum of the right tree becomes the middle node
+    NodePtr middle = nullptr;
+    right = removeMinAVL(right, middle);
+    return joinAVL(left, middle, right);
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+pair<typename AVLTree<K, V, Compare, Storage, Augment>::NodePtr, typename AVLTree<K, V, Compare, Storage, Augment>::NodePtr>
+AVLTree<K, V, Compare, Storage, Augment>::splitAVL(NodePtr node, const K& key, bool keepEqualLeft) {
+    if (!node)
+        return make_pair(NodePtr(nullptr), NodePtr(nullptr));
+    NodePtr left = node->left;
+    NodePtr right = node->right;
+    if (left)
+        left->parent = ParentPtr();
+    if (right)
+        right->parent = ParentPtr();
+    bool nodeGoesLeft = keepEqualLeft ? !this->comparator(key, node->key) : this->comparator(node->key, key);
+    if (nodeGoesLeft) {
+        auto parts = splitAVL(right, key, keepEqualLeft);
+        return make_pair(joinAVL(left, node, parts.first), parts.second);
+    }
+    auto parts = splitAVL(left, key, keepEqualLeft);
+    return make_pair(parts.first, joinAVL(parts.second, node, right));
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename AVLTree<K, V, Compare, Storage, Augment>::NodePtr AVLTree<K, V, Compare, Storage, Augment>::rotateLeft(NodePtr node) {
+    NodePtr child =  node->right;
+    NodePtr T1 =  child->left;
     child->left = node;
     node->right = T1;
     child->parent=node->parent;
@@ -107,14 +463,15 @@ shared_ptr<typename AVLTree<K, V>::BSTNode> AVLTree<K, V>::rotateLeft(shared_ptr
 
     this->updateHeight(node);
     this->updateHeight(child);
+    this->statsRotation();
     return child;
 
 }
 
-template<typename K, typename V>
-shared_ptr<typename AVLTree<K, V>::BSTNode> AVLTree<K, V>::rotateRight(shared_ptr<BSTNode> node) {
-    shared_ptr<BSTNode> child =  node->left;
-    shared_ptr<BSTNode> T1 =  child->right;
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename AVLTree<K, V, Compare, Storage, Augment>::NodePtr AVLTree<K, V, Compare, Storage, Augment>::rotateRight(NodePtr node) {
+    NodePtr child =  node->left;
+    NodePtr T1 =  child->right;
     child->right = node;
     node->left = T1;
     child->parent=node->parent;
@@ -123,36 +480,42 @@ shared_ptr<typename AVLTree<K, V>::BSTNode> AVLTree<K, V>::rotateRight(shared_pt
     node->parent = child;
     this->updateHeight(node);
     this->updateHeight(child);
+    this->statsRotation();
     return child;
 }
 
-template<typename K, typename V>
-shared_ptr<typename AVLTree<K, V>::BSTNode> AVLTree<K, V>::rotateLeftRight(shared_ptr<BSTNode> node) {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename AVLTree<K, V, Compare, Storage, Augment>::NodePtr AVLTree<K, V, Compare, Storage, Augment>::rotateLeftRight(NodePtr node) {
     // 1. left rotation on left node
     // 2. right rotation on root
     node->left = rotateLeft(node->left);
     return rotateRight(node);
 }
 
-template<typename K, typename V>
-shared_ptr<typename AVLTree<K, V>::BSTNode> AVLTree<K, V>::rotateRightLeft(shared_ptr<BSTNode> node) {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename AVLTree<K, V, Compare, Storage, Augment>::NodePtr AVLTree<K, V, Compare, Storage, Augment>::rotateRightLeft(NodePtr node) {
     node->right = rotateRight(node->right);
     return rotateLeft(node);
 }
 
-template<typename K, typename V>
-int AVLTree<K, V>::getBalanceFactor(shared_ptr<BSTNode> node) const {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+int AVLTree<K, V, Compare, Storage, Augment>::getBalanceFactor(NodePtr node) const {
     if (!node)
     return 0;
     return (this->getHeight(node->left) - this->getHeight(node->right));
 }
 
-template<typename K, typename V>
-shared_ptr<typename AVLTree<K, V>::BSTNode> AVLTree<K, V>::rebalance(shared_ptr<BSTNode> node) {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename AVLTree<K, V, Compare, Storage, Augment>::NodePtr AVLTree<K, V, Compare, Storage, Augment>::rebalance(NodePtr node) {
     int bf;
     bf = getBalanceFactor(node);
     int bfr = getBalanceFactor(node->right);
     int bfl = getBalanceFactor(node->left);
+    if constexpr (treeStatsEnabled) {
+        this->stats.rebalanceCalls++;
+        if (bf > 1 || bf < -1)
+            ((bf > 1 ? bfl >= 0 : bfr <= 0) ? this->stats.singleRotations : this->stats.doubleRotations)++;
+    }
     
     if (bf>1){//left heavy
         if (bfl>=0) //LL heavy
@@ -171,31 +534,175 @@ shared_ptr<typename AVLTree<K, V>::BSTNode> AVLTree<K, V>::rebalance(shared_ptr<
     
 }
 
-template<typename K, typename V>
-bool AVLTree<K, V>::isBalanced() const {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+bool AVLTree<K, V, Compare, Storage, Augment>::isBalanced() const {
+    return isValidAVLHelper(this->root);
 }
 
-template<typename K, typename V>
-bool AVLTree<K, V>::isValidAVLHelper(shared_ptr<BSTNode> node) const {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+bool AVLTree<K, V, Compare, Storage, Augment>::isValidAVLHelper(NodePtr node) const {
+    // stored height/size must match the children, |balance| <= 1, and every
+    // child has to point back at this node
+    if (!node)
+        return true;
+    return isValidAVLHelper(node->left) && isValidAVLHelper(node->right) && validNode(node);
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+bool AVLTree<K, V, Compare, Storage, Augment>::validNode(const NodePtr& node) const {
+    for (const NodePtr* child : {&node->left, &node->right}) {
+        if (*child && this->parentNode(this->rawNode(*child)) != this->rawNode(node))
+            return false;
+    }
+    if (node->height != 1 + std::max(this->getHeight(node->left), this->getHeight(node->right)))
+        return false;
+    if (node->subtreeSize != 1 + this->getSize(node->left) + this->getSize(node->right))
+        return false;
+    return std::abs(getBalanceFactor(node)) <= 1;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+int AVLTree<K, V, Compare, Storage, Augment>::getMaxDepth() const {
+    long long totalDepth = 0;
+    size_t nodeCount = 0;
+    int maxDepth = 0;
+    calculateDepthStats(this->root, 1, totalDepth, nodeCount, maxDepth);
+    return maxDepth;
 }
 
-template<typename K, typename V>
-int AVLTree<K, V>::getMaxDepth() const {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+double AVLTree<K, V, Compare, Storage, Augment>::getAverageDepth() const {
+    long long totalDepth = 0;  // summed over n nodes, outgrows int near 10^8
+    size_t nodeCount = 0;
+    int maxDepth = 0;
+    calculateDepthStats(this->root, 1, totalDepth, nodeCount, maxDepth);
+    return nodeCount ? (double)totalDepth / nodeCount : 0.0;
 }
 
-template<typename K, typename V>
-double AVLTree<K, V>::getAverageDepth() const {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+int AVLTree<K, V, Compare, Storage, Augment>::getMaxDepth(ThreadPool& threads) const {
+    long long totalDepth;
+    size_t nodeCount;
+    int maxDepth;
+    calculateDepthStats(threads, totalDepth, nodeCount, maxDepth);
+    return maxDepth;
 }
 
-template<typename K, typename V>
-void AVLTree<K, V>::calculateDepthStats(shared_ptr<BSTNode> node, int depth, int& totalDepth, int& nodeCount, int& maxDepth) const {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+double AVLTree<K, V, Compare, Storage, Augment>::getAverageDepth(ThreadPool& threads) const {
+    long long totalDepth;
+    size_t nodeCount;
+    int maxDepth;
+    calculateDepthStats(threads, totalDepth, nodeCount, maxDepth);
+    return nodeCount ? (double)totalDepth / nodeCount : 0.0;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+void AVLTree<K, V, Compare, Storage, Augment>::calculateDepthStats(ThreadPool& threads, long long& totalDepth, size_t& nodeCount, int& maxDepth) const {
+    vector<SubtreeTask> tasks, upper;
+    this->splitForTasks(threads.size(), tasks, upper);
+    totalDepth = 0;
+    nodeCount = upper.size();
+    maxDepth = 0;
+    for (const SubtreeTask& top : upper) {
+        totalDepth += top.depth;
+        maxDepth = std::max(maxDepth, top.depth);
+    }
+    vector<long long> totals(tasks.size(), 0);
+    vector<size_t> counts(tasks.size(), 0);
+    vector<int> maxes(tasks.size(), 0);
+    threads.parallelFor(tasks.size(), [&](size_t i) {
+        calculateDepthStats(tasks[i].node, tasks[i].depth, totals[i], counts[i], maxes[i]);
+    });
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        totalDepth += totals[i];
+        nodeCount += counts[i];
+        maxDepth = std::max(maxDepth, maxes[i]);
+    }
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+void AVLTree<K, V, Compare, Storage, Augment>::calculateDepthStats(NodePtr node, int depth, long long& totalDepth, size_t& nodeCount, int& maxDepth) const {
+    // recursion is bounded by the AVL height, ~1.44 log2 n
+    if (!node)
+        return;
+    totalDepth += depth;
+    nodeCount++;
+    maxDepth = std::max(maxDepth, depth);
+    calculateDepthStats(node->left, depth + 1, totalDepth, nodeCount, maxDepth);
+    calculateDepthStats(node->right, depth + 1, totalDepth, nodeCount, maxDepth);
 }
 
-template<typename K, typename V>
-bool AVLTree<K, V>::isValidAVL() const {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+bool AVLTree<K, V, Compare, Storage, Augment>::isValidAVL() const {
+    if (this->root && this->parentNode(this->rawNode(this->root)))
+        return false;
+    if (this->getSize(this->root) != this->nodeCount || !isValidAVLHelper(this->root))
+        return false;
+    //keys must come out of the in-order walk strictly ascending
+    auto it = this->begin();
+    if (it == this->end())
+        return true;
+    for (auto prev = it++; it != this->end(); prev = it++) {
+        if (!this->comparator(prev->key, it->key))
+            return false;
+    }
+    return true;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+bool AVLTree<K, V, Compare, Storage, Augment>::isValidAVL(ThreadPool& threads) const {
+    if (this->root && this->parentNode(this->rawNode(this->root)))
+        return false;
+    if (this->getSize(this->root) != this->nodeCount)
+        return false;
+    vector<SubtreeTask> tasks, upper;
+    this->splitForTasks(threads.size(), tasks, upper);
+
+    // Each task checks its subtree whole, keys ascending inside it, and notes
+    // its first and last node. Keys are compared through keyCompare(): the
+    // counting comparator() is not safe to call from several threads.
+    vector<char> valid(tasks.size(), false);
+    vector<pair<BSTNode*, BSTNode*>> ends(tasks.size());
+    threads.parallelFor(tasks.size(), [&](size_t i) {
+        BSTNode* prev = nullptr;
+        bool ascending = true;
+        this->forEachInOrder(this->rawNode(tasks[i].node), [&](BSTNode* node) {
+            if (!prev)
+                ends[i].first = node;
+            else if (!this->keyCompare()(prev->key, node->key))
+                ascending = false;
+            prev = node;
+        });
+        ends[i].second = prev;
+        valid[i] = ascending && isValidAVLHelper(tasks[i].node);
+    });
+    if (std::find(valid.begin(), valid.end(), false) != valid.end())
+        return false;
+
+    // Nodes above the cut only need their own links and fields checked, then
+    // the pieces, laid out by in-order position, must meet in ascending order
+    vector<pair<size_t, pair<BSTNode*, BSTNode*>>> pieces;
+    for (size_t i = 0; i < tasks.size(); ++i)
+        pieces.emplace_back(tasks[i].offset, ends[i]);
+    for (const SubtreeTask& top : upper) {
+        if (!validNode(top.node))
+            return false;
+        BSTNode* node = this->rawNode(top.node);
+        pieces.emplace_back(top.offset, make_pair(node, node));
+    }
+    std::sort(pieces.begin(), pieces.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (size_t i = 1; i < pieces.size(); ++i) {
+        if (!this->comparator(pieces[i - 1].second.second->key, pieces[i].second.first->key))
+            return false;
+    }
+    return true;
 }
 
 template class AVLTree<int, string>;
 template class AVLTree<string, string>;
 template class AVLTree<int, int>;
-template class AVLTree<string, void*>;
\ No newline at end of file
+template class AVLTree<string, void*>;
+template class AVLTree<int, string, DynamicCompare<int>>;
+template class AVLTree<int, int, less<int>, ArenaNodeStorage>;
+template class AVLTree<string, string, less<string>, ArenaNodeStorage>;
\ No newline at end of file
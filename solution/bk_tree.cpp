@@ -0,0 +1,216 @@
+#include "../headers/bk_tree.h"
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+using namespace std;
+
+template<typename V, typename Metric>
+int BKTree<V, Metric>::findIndex(string_view key) const {
+    if (nodes.empty())
+        return -1;
+    uint32_t index = 0;
+    for (;;) {
+        const Node& node = nodes[index];
+        int distance = metric(key, node.key);
+        if (distance == 0)
+            return (int)index;
+        auto edge = lower_bound(node.children.begin(), node.children.end(), make_pair(distance, (uint32_t)0));
+        if (edge == node.children.end() || edge->first != distance)
+            return -1;
+        index = edge->second;
+    }
+}
+
+template<typename V, typename Metric>
+const V* BKTree<V, Metric>::find(string_view key) const {
+    int index = findIndex(key);
+    return index >= 0 && nodes[index].live ? &nodes[index].value : nullptr;
+}
+
+template<typename V, typename Metric>
+bool BKTree<V, Metric>::insert(string_view key, const V& value) {
+    if (nodes.empty()) {
+        nodes.push_back(Node{string(key), value, true, {}});
+        live++;
+        return true;
+    }
+    if (nodes.size() >= UINT32_MAX)
+        throw std::length_error("bk-tree holds at most 2^32 - 1 nodes");
+    uint32_t index = 0;
+    for (;;) {
+        int distance = metric(key, nodes[index].key);
+        if (distance == 0) { //present: only a dead node takes the key back
+            Node& node = nodes[index];
+            if (node.live)
+                return false;
+            node.live = true;
+            node.value = value;
+            live++;
+            return true;
+        }
+        vector<pair<int, uint32_t>>& children = nodes[index].children;
+        auto edge = lower_bound(children.begin(), children.end(), make_pair(distance, (uint32_t)0));
+        if (edge == children.end() || edge->first != distance) {
+            uint32_t added = (uint32_t)nodes.size();
+            children.insert(edge, make_pair(distance, added));  // before push_back, which may move children
+            nodes.push_back(Node{string(key), value, true, {}});
+            live++;
+            return true;
+        }
+        index = edge->second;
+    }
+}
+
+template<typename V, typename Metric>
+bool BKTree<V, Metric>::remove(string_view key) {
+    int index = findIndex(key);
+    if (index < 0 || !nodes[index].live)
+        return false;
+    nodes[index].live = false;
+    nodes[index].value = V();
+    live--;
+    if (nodes.size() - live > live)
+        rebuild();
+    return true;
+}
+
+template<typename V, typename Metric>
+void BKTree<V, Metric>::rebuild() {
+    vector<Node> old = std::move(nodes);
+    nodes.clear();
+    live = 0;
+    for (Node& node : old) {
+        if (node.live)
+            insert(node.key, node.value);
+    }
+}
+
+template<typename V, typename Metric>
+void BKTree<V, Metric>::clear() {
+    nodes.clear();
+    live = 0;
+}
+
+template<typename V, typename Metric>
+template<typename Visitor>
+size_t BKTree<V, Metric>::forEachWithin(string_view query, int maxDistance, Visitor visit) const {
+    if (nodes.empty() || maxDistance < 0)
+        return 0;
+    maxDistance = std::min(maxDistance, INT_MAX / 4);  // leaves room for distance + edge sums
+    size_t computed = 0;
+    auto scorer = metric.prepare(query);  // per-query setup, shared by every node
+    const size_t width = scorer.batchWidth();
+    vector<uint32_t> pending = {0}, scored;
+    vector<string_view> keys(width);
+    vector<int> distances(width);
+    while (!pending.empty()) {
+        size_t count = std::min(width, pending.size());
+        const uint32_t* batch = pending.data() + pending.size() - count;
+        if (count > 1) { //several frontier nodes scored in one pass
+            for (size_t i = 0; i < count; ++i)
+                keys[i] = nodes[batch[i]].key;
+            scorer.distances(keys.data(), count, distances.data());
+        } else {
+            // beyond maxDistance plus the widest edge, neither the node nor a
+            // child can match, so the exact distance no longer matters
+            const Node& node = nodes[*batch];
+            int widest = node.children.empty() ? 0 : node.children.back().first;
+            distances[0] = scorer.distance(node.key, maxDistance + widest);
+        }
+        computed += count;
+        scored.assign(batch, batch + count);
+        pending.resize(pending.size() - count);
+        for (size_t i = 0; i < count; ++i) {
+            const Node& node = nodes[scored[i]];
+            int distance = distances[i];
+            if (node.live && distance <= maxDistance)
+                visit(node.value, distance);
+            // only children whose edge is within maxDistance of distance can hold a match
+            auto first = lower_bound(node.children.begin(), node.children.end(), make_pair(distance - maxDistance, (uint32_t)0));
+            for (auto edge = first; edge != node.children.end() && edge->first <= distance + maxDistance; ++edge)
+                pending.push_back(edge->second);
+        }
+    }
+    return computed;
+}
+
+template<typename V, typename Metric>
+template<typename Visitor>
+size_t BKTree<V, Metric>::forEachNearest(string_view query, int maxDistance, Visitor visit) const {
+    if (nodes.empty() || maxDistance < 0)
+        return 0;
+    maxDistance = std::min(maxDistance, INT_MAX / 4);  // leaves room for distance + edge sums
+    size_t computed = 0;
+    int radius = maxDistance;
+    auto scorer = metric.prepare(query);
+    const size_t width = scorer.batchWidth();
+    // Pending subtrees bucketed by the lower bound on any of their keys'
+    // distances (at most radius, grown on demand); each bucket is a stack, so
+    // within a bound the walk stays depth-first
+    vector<vector<uint32_t>> pending(1, vector<uint32_t>{0});
+    int bound = 0;  // lowest bucket that may be non-empty
+    vector<pair<int, uint32_t>> batch;  // (bound, node)
+    vector<string_view> keys(width);
+    vector<int> distances(width);
+    for (;;) {
+        batch.clear();
+        while (batch.size() < width) {
+            while (bound <= radius && bound < (int)pending.size() && pending[bound].empty())
+                bound++;
+            if (bound > radius || bound == (int)pending.size())
+                break;
+            batch.push_back(make_pair(bound, pending[bound].back()));
+            pending[bound].pop_back();
+        }
+        if (batch.empty())
+            break;  // nothing pending can come within radius
+        if (batch.size() > 1) {
+            for (size_t i = 0; i < batch.size(); ++i)
+                keys[i] = nodes[batch[i].second].key;
+            scorer.distances(keys.data(), batch.size(), distances.data());
+        } else {
+            const Node& node = nodes[batch[0].second];
+            int widest = node.children.empty() ? 0 : node.children.back().first;
+            distances[0] = scorer.distance(node.key, radius + widest);
+        }
+        computed += batch.size();
+        for (size_t i = 0; i < batch.size(); ++i) {
+            const Node& node = nodes[batch[i].second];
+            int distance = distances[i];
+            if (node.live && distance <= radius)
+                radius = std::min(radius, visit(node.value, distance));
+            // every key below an edge lies at the edge's distance from node
+            auto first = lower_bound(node.children.begin(), node.children.end(), make_pair(distance - radius, (uint32_t)0));
+            for (auto edge = first; edge != node.children.end() && edge->first <= distance + radius; ++edge) {
+                int below = std::max(batch[i].first, std::abs(distance - edge->first));
+                if (below >= (int)pending.size())
+                    pending.resize(below + 1);
+                pending[below].push_back(edge->second);
+                bound = std::min(bound, below);
+            }
+        }
+    }
+    return computed;
+}
+
+template<typename V, typename Metric>
+bool BKTree<V, Metric>::isValid() const {
+    size_t counted = 0;
+    vector<bool> reached(nodes.size(), false);
+    for (uint32_t index = 0; index < nodes.size(); ++index) {
+        const Node& node = nodes[index];
+        counted += node.live;
+        for (size_t i = 0; i < node.children.size(); ++i) {
+            auto edge = node.children[i];
+            if (edge.second <= index || edge.second >= nodes.size() || reached[edge.second])
+                return false;
+            if ((i > 0 && node.children[i - 1].first >= edge.first) || metric(node.key, nodes[edge.second].key) != edge.first)
+                return false;
+            reached[edge.second] = true;
+        }
+    }
+    return counted == live;
+}
+
+template class BKTree<int>;
+template class BKTree<string>;
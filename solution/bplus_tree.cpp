@@ -0,0 +1,850 @@
+#include "../headers/bplus_tree.h"
+#include <numeric>
+#include <stdexcept>
+using namespace std;
+
+// Nodes per arena slab; B+ tree nodes are large, so slabs stay small
+static constexpr size_t BPLUS_NODES_PER_SLAB = 64;
+
+template<typename K, typename V, typename Compare>
+BPlusTree<K, V, Compare>::BPlusTree()
+    : root(nullptr), entryCount(0), leafPool(BPLUS_NODES_PER_SLAB), innerPool(BPLUS_NODES_PER_SLAB) {
+}
+
+template<typename K, typename V, typename Compare>
+BPlusTree<K, V, Compare>::BPlusTree(Compare comp)
+    : ComparatorBase<Compare>(std::move(comp)), root(nullptr), entryCount(0),
+      leafPool(BPLUS_NODES_PER_SLAB), innerPool(BPLUS_NODES_PER_SLAB) {
+}
+
+template<typename K, typename V, typename Compare>
+BPlusTree<K, V, Compare>::BPlusTree(BPlusTree&& other)
+    : ComparatorBase<Compare>(std::move(other.keyCompare())), root(other.root), entryCount(other.entryCount),
+      leafPool(std::move(other.leafPool)), innerPool(std::move(other.innerPool)) {
+    other.root = nullptr;
+    other.entryCount = 0;
+}
+
+template<typename K, typename V, typename Compare>
+BPlusTree<K, V, Compare>& BPlusTree<K, V, Compare>::operator=(BPlusTree&& other) {
+    if (this != &other) {
+        clear();
+        this->keyCompare() = std::move(other.keyCompare());
+        root = other.root;
+        entryCount = other.entryCount;
+        leafPool = std::move(other.leafPool);
+        innerPool = std::move(other.innerPool);
+        other.root = nullptr;
+        other.entryCount = 0;
+    }
+    return *this;
+}
+
+template<typename K, typename V, typename Compare>
+BPlusTree<K, V, Compare>::~BPlusTree() {
+    clear();
+}
+
+template<typename K, typename V, typename Compare>
+void BPlusTree<K, V, Compare>::clear() {
+    destroySubtree(root);
+    root = nullptr;
+    entryCount = 0;
+}
+
+template<typename K, typename V, typename Compare>
+void BPlusTree<K, V, Compare>::destroySubtree(Node* node) {
+    if (!node)
+        return;
+    if (node->leaf) {
+        leafPool.destroy(static_cast<LeafNode*>(node));
+        return;
+    }
+    InnerNode* inner = static_cast<InnerNode*>(node);
+    for (int i = 0; i <= inner->count; ++i)
+        destroySubtree(inner->children[i]);
+    innerPool.destroy(inner);
+}
+
+template<typename K, typename V, typename Compare>
+template<typename Key>
+int BPlusTree<K, V, Compare>::lowerSlot(const K* keys, int count, const Key& key) const {
+    int lo = 0, hi = count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (comparator(keys[mid], key))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+template<typename K, typename V, typename Compare>
+template<typename Key>
+int BPlusTree<K, V, Compare>::upperSlot(const K* keys, int count, const Key& key) const {
+    int lo = 0, hi = count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (comparator(key, keys[mid]))
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+
+template<typename K, typename V, typename Compare>
+template<typename Key>
+const typename BPlusTree<K, V, Compare>::LeafNode* BPlusTree<K, V, Compare>::findLeaf(const Key& key) const {
+    const Node* node = root;
+    if (!node)
+        return nullptr;
+    while (!node->leaf) {
+        const InnerNode* inner = static_cast<const InnerNode*>(node);
+        node = inner->children[upperSlot(inner->keys, inner->count, key)];
+    }
+    return static_cast<const LeafNode*>(node);
+}
+
+template<typename K, typename V, typename Compare>
+const typename BPlusTree<K, V, Compare>::LeafNode* BPlusTree<K, V, Compare>::firstLeaf() const {
+    const Node* node = root;
+    if (!node)
+        return nullptr;
+    while (!node->leaf)
+        node = static_cast<const InnerNode*>(node)->children[0];
+    return static_cast<const LeafNode*>(node);
+}
+
+template<typename K, typename V, typename Compare>
+const typename BPlusTree<K, V, Compare>::LeafNode* BPlusTree<K, V, Compare>::lastLeaf() const {
+    const Node* node = root;
+    if (!node)
+        return nullptr;
+    while (!node->leaf) {
+        const InnerNode* inner = static_cast<const InnerNode*>(node);
+        node = inner->children[inner->count];
+    }
+    return static_cast<const LeafNode*>(node);
+}
+
+template<typename K, typename V, typename Compare>
+bool BPlusTree<K, V, Compare>::insert(const K& key, const V& value) {
+    return insertWith(key, [&]() { return value; });
+}
+
+template<typename K, typename V, typename Compare>
+template<typename... Args>
+bool BPlusTree<K, V, Compare>::try_emplace(const K& key, Args&&... args) {
+    return insertWith(key, [&]() { return V(std::forward<Args>(args)...); });
+}
+
+template<typename K, typename V, typename Compare>
+template<typename MakeValue>
+bool BPlusTree<K, V, Compare>::insertWith(const K& key, MakeValue makeValue) {
+    if (!root)
+        root = leafPool.create();
+    bool inserted = false;
+    K splitKey;
+    Node* sibling = insertHelper(root, key, makeValue, inserted, splitKey);
+    if (sibling) {
+        // the root split: grow the tree by one level
+        InnerNode* newRoot = innerPool.create();
+        newRoot->keys[0] = std::move(splitKey);
+        newRoot->children[0] = root;
+        newRoot->children[1] = sibling;
+        newRoot->count = 1;
+        newRoot->total = root->total + sibling->total;
+        root = newRoot;
+    }
+    if (inserted)
+        entryCount++;
+    return inserted;
+}
+
+template<typename K, typename V, typename Compare>
+template<typename MakeValue>
+typename BPlusTree<K, V, Compare>::Node* BPlusTree<K, V, Compare>::insertHelper(Node* node, const K& key, MakeValue& makeValue, bool& inserted, K& splitKey) {
+    if (node->leaf) {
+        LeafNode* leaf = static_cast<LeafNode*>(node);
+        int i = lowerSlot(leaf->keys, leaf->count, key);
+        if (i < leaf->count && !comparator(key, leaf->keys[i]))
+            return nullptr;  // duplicate key
+        V value = makeValue();
+        move_backward(leaf->keys + i, leaf->keys + leaf->count, leaf->keys + leaf->count + 1);
+        move_backward(leaf->values + i, leaf->values + leaf->count, leaf->values + leaf->count + 1);
+        leaf->keys[i] = key;
+        leaf->values[i] = std::move(value);
+        leaf->count++;
+        leaf->total++;
+        inserted = true;
+        if (leaf->count <= CAPACITY)
+            return nullptr;
+
+        // overflow: move the upper half into a new right sibling
+        LeafNode* right = leafPool.create();
+        int keep = leaf->count / 2;
+        right->count = leaf->count - keep;
+        move(leaf->keys + keep, leaf->keys + leaf->count, right->keys);
+        move(leaf->values + keep, leaf->values + leaf->count, right->values);
+        leaf->count = keep;
+        leaf->total = keep;
+        right->total = right->count;
+        right->next = leaf->next;
+        if (right->next)
+            right->next->prev = right;
+        right->prev = leaf;
+        leaf->next = right;
+        splitKey = right->keys[0];
+        return right;
+    }
+
+    InnerNode* inner = static_cast<InnerNode*>(node);
+    int i = upperSlot(inner->keys, inner->count, key);
+    K childSplitKey;
+    Node* newChild = insertHelper(inner->children[i], key, makeValue, inserted, childSplitKey);
+    if (!inserted)
+        return nullptr;
+    inner->total++;
+    if (!newChild)
+        return nullptr;
+
+    move_backward(inner->keys + i, inner->keys + inner->count, inner->keys + inner->count + 1);
+    move_backward(inner->children + i + 1, inner->children + inner->count + 1, inner->children + inner->count + 2);
+    inner->keys[i] = std::move(childSplitKey);
+    inner->children[i + 1] = newChild;
+    inner->count++;
+    if (inner->count <= CAPACITY)
+        return nullptr;
+
+    // overflow: keys[mid] moves up, everything after it goes to a new right sibling
+    InnerNode* right = innerPool.create();
+    int mid = inner->count / 2;
+    right->count = inner->count - mid - 1;
+    move(inner->keys + mid + 1, inner->keys + inner->count, right->keys);
+    move(inner->children + mid + 1, inner->children + inner->count + 1, right->children);
+    splitKey = std::move(inner->keys[mid]);
+    inner->count = mid;
+    for (int c = 0; c <= right->count; ++c)
+        right->total += right->children[c]->total;
+    inner->total -= right->total;
+    return right;
+}
+
+template<typename K, typename V, typename Compare>
+bool BPlusTree<K, V, Compare>::remove(const K& key) {
+    if (!root || !removeHelper(root, key))
+        return false;
+    entryCount--;
+    if (root->leaf && root->count == 0) {
+        leafPool.destroy(static_cast<LeafNode*>(root));
+        root = nullptr;
+    } else if (!root->leaf && root->count == 0) {
+        // the root's last two children merged: shrink the tree by one level
+        InnerNode* oldRoot = static_cast<InnerNode*>(root);
+        root = oldRoot->children[0];
+        innerPool.destroy(oldRoot);
+    }
+    return true;
+}
+
+template<typename K, typename V, typename Compare>
+bool BPlusTree<K, V, Compare>::removeHelper(Node* node, const K& key) {
+    if (node->leaf) {
+        LeafNode* leaf = static_cast<LeafNode*>(node);
+        int i = lowerSlot(leaf->keys, leaf->count, key);
+        if (i == leaf->count || comparator(key, leaf->keys[i]))
+            return false;
+        move(leaf->keys + i + 1, leaf->keys + leaf->count, leaf->keys + i);
+        move(leaf->values + i + 1, leaf->values + leaf->count, leaf->values + i);
+        leaf->count--;
+        leaf->total--;
+        return true;
+    }
+
+    InnerNode* inner = static_cast<InnerNode*>(node);
+    int i = upperSlot(inner->keys, inner->count, key);
+    if (!removeHelper(inner->children[i], key))
+        return false;
+    inner->total--;
+    if (inner->children[i]->count < MIN_KEYS)
+        fixUnderflow(inner, i);
+    return true;
+}
+
+template<typename K, typename V, typename Compare>
+void BPlusTree<K, V, Compare>::eraseChild(InnerNode* parent, int keyIndex) {
+    move(parent->keys + keyIndex + 1, parent->keys + parent->count, parent->keys + keyIndex);
+    move(parent->children + keyIndex + 2, parent->children + parent->count + 1, parent->children + keyIndex + 1);
+    parent->count--;
+}
+
+template<typename K, typename V, typename Compare>
+void BPlusTree<K, V, Compare>::fixUnderflow(InnerNode* parent, int index) {
+    // Borrow one entry from a sibling that can spare it, otherwise merge with one
+    Node* child = parent->children[index];
+    Node* leftSibling = index > 0 ? parent->children[index - 1] : nullptr;
+    Node* rightSibling = index < parent->count ? parent->children[index + 1] : nullptr;
+
+    if (child->leaf) {
+        LeafNode* leaf = static_cast<LeafNode*>(child);
+        LeafNode* left = static_cast<LeafNode*>(leftSibling);
+        LeafNode* right = static_cast<LeafNode*>(rightSibling);
+        if (left && left->count > MIN_KEYS) {
+            move_backward(leaf->keys, leaf->keys + leaf->count, leaf->keys + leaf->count + 1);
+            move_backward(leaf->values, leaf->values + leaf->count, leaf->values + leaf->count + 1);
+            leaf->keys[0] = std::move(left->keys[left->count - 1]);
+            leaf->values[0] = std::move(left->values[left->count - 1]);
+            left->count--;
+            left->total--;
+            leaf->count++;
+            leaf->total++;
+            parent->keys[index - 1] = leaf->keys[0];
+        } else if (right && right->count > MIN_KEYS) {
+            leaf->keys[leaf->count] = std::move(right->keys[0]);
+            leaf->values[leaf->count] = std::move(right->values[0]);
+            move(right->keys + 1, right->keys + right->count, right->keys);
+            move(right->values + 1, right->values + right->count, right->values);
+            right->count--;
+            right->total--;
+            leaf->count++;
+            leaf->total++;
+            parent->keys[index] = right->keys[0];
+        } else {
+            // merge the right one of the pair into the left one
+            LeafNode* dst = left ? left : leaf;
+            LeafNode* src = left ? leaf : right;
+            int keyIndex = left ? index - 1 : index;
+            move(src->keys, src->keys + src->count, dst->keys + dst->count);
+            move(src->values, src->values + src->count, dst->values + dst->count);
+            dst->count += src->count;
+            dst->total += src->total;
+            dst->next = src->next;
+            if (dst->next)
+                dst->next->prev = dst;
+            leafPool.destroy(src);
+            eraseChild(parent, keyIndex);
+        }
+        return;
+    }
+
+    InnerNode* inner = static_cast<InnerNode*>(child);
+    InnerNode* left = static_cast<InnerNode*>(leftSibling);
+    InnerNode* right = static_cast<InnerNode*>(rightSibling);
+    if (left && left->count > MIN_KEYS) {
+        // rotate through the parent: separator comes down, left's last key goes up
+        move_backward(inner->keys, inner->keys + inner->count, inner->keys + inner->count + 1);
+        move_backward(inner->children, inner->children + inner->count + 1, inner->children + inner->count + 2);
+        inner->keys[0] = std::move(parent->keys[index - 1]);
+        inner->children[0] = left->children[left->count];
+        parent->keys[index - 1] = std::move(left->keys[left->count - 1]);
+        left->count--;
+        inner->count++;
+        size_t moved = inner->children[0]->total;
+        left->total -= moved;
+        inner->total += moved;
+    } else if (right && right->count > MIN_KEYS) {
+        inner->keys[inner->count] = std::move(parent->keys[index]);
+        inner->children[inner->count + 1] = right->children[0];
+        parent->keys[index] = std::move(right->keys[0]);
+        move(right->keys + 1, right->keys + right->count, right->keys);
+        move(right->children + 1, right->children + right->count + 1, right->children);
+        right->count--;
+        inner->count++;
+        size_t moved = inner->children[inner->count]->total;
+        right->total -= moved;
+        inner->total += moved;
+    } else {
+        InnerNode* dst = left ? left : inner;
+        InnerNode* src = left ? inner : right;
+        int keyIndex = left ? index - 1 : index;
+        dst->keys[dst->count] = std::move(parent->keys[keyIndex]);
+        move(src->keys, src->keys + src->count, dst->keys + dst->count + 1);
+        move(src->children, src->children + src->count + 1, dst->children + dst->count + 1);
+        dst->count += src->count + 1;
+        dst->total += src->total;
+        innerPool.destroy(src);
+        eraseChild(parent, keyIndex);
+    }
+}
+
+template<typename K, typename V, typename Compare>
+V* BPlusTree<K, V, Compare>::find(const K& key) {
+    return const_cast<V*>(static_cast<const BPlusTree*>(this)->find(key));
+}
+
+template<typename K, typename V, typename Compare>
+const V* BPlusTree<K, V, Compare>::find(const K& key) const {
+    return findValue(key);
+}
+
+template<typename K, typename V, typename Compare>
+template<typename Key>
+const V* BPlusTree<K, V, Compare>::findValue(const Key& key) const {
+    const LeafNode* leaf = findLeaf(key);
+    if (!leaf)
+        return nullptr;
+    int i = lowerSlot(leaf->keys, leaf->count, key);
+    if (i == leaf->count || comparator(key, leaf->keys[i]))
+        return nullptr;
+    return &leaf->values[i];
+}
+
+template<typename K, typename V, typename Compare>
+pair<K, V> BPlusTree<K, V, Compare>::min() const {
+    const LeafNode* leaf = firstLeaf();
+    if (!leaf)
+        throw std::runtime_error("the b+ tree is empty, couldnt find minimum");
+    return make_pair(leaf->keys[0], leaf->values[0]);
+}
+
+template<typename K, typename V, typename Compare>
+pair<K, V> BPlusTree<K, V, Compare>::max() const {
+    const LeafNode* leaf = lastLeaf();
+    if (!leaf)
+        throw std::runtime_error("the b+ tree is empty, couldnt find max");
+    return make_pair(leaf->keys[leaf->count - 1], leaf->values[leaf->count - 1]);
+}
+
+template<typename K, typename V, typename Compare>
+vector<pair<K, V>> BPlusTree<K, V, Compare>::findRange(const K& minKey, const K& maxKey) const {
+    vector<pair<K, V>> result;
+    forEachInRange(minKey, maxKey, [&](const K& key, const V& value) {
+        result.emplace_back(key, value);
+        return true;
+    });
+    return result;
+}
+
+template<typename K, typename V, typename Compare>
+int BPlusTree<K, V, Compare>::getTreeHeight() const {
+    int height = 0;
+    for (const Node* node = root; node; node = node->leaf ? nullptr : static_cast<const InnerNode*>(node)->children[0])
+        height++;
+    return height;
+}
+
+template<typename K, typename V, typename Compare>
+size_t BPlusTree<K, V, Compare>::countLess(const K& key, bool inclusive) const {
+    size_t count = 0;
+    const Node* node = root;
+    if (!node)
+        return 0;
+    while (!node->leaf) {
+        const InnerNode* inner = static_cast<const InnerNode*>(node);
+        int i = inclusive ? upperSlot(inner->keys, inner->count, key) : lowerSlot(inner->keys, inner->count, key);
+        for (int c = 0; c < i; ++c)
+            count += inner->children[c]->total;
+        node = inner->children[i];
+    }
+    const LeafNode* leaf = static_cast<const LeafNode*>(node);
+    return count + (inclusive ? upperSlot(leaf->keys, leaf->count, key) : lowerSlot(leaf->keys, leaf->count, key));
+}
+
+template<typename K, typename V, typename Compare>
+size_t BPlusTree<K, V, Compare>::rank(const K& key) const {
+    return countLess(key, false);
+}
+
+template<typename K, typename V, typename Compare>
+pair<K, V> BPlusTree<K, V, Compare>::select(size_t index) const {
+    if (index >= entryCount)
+        throw std::out_of_range("select index is past the end of the b+ tree");
+    const Node* node = root;
+    while (!node->leaf) {
+        const InnerNode* inner = static_cast<const InnerNode*>(node);
+        int c = 0;
+        while (index >= inner->children[c]->total)
+            index -= inner->children[c++]->total;
+        node = inner->children[c];
+    }
+    const LeafNode* leaf = static_cast<const LeafNode*>(node);
+    return make_pair(leaf->keys[index], leaf->values[index]);
+}
+
+template<typename K, typename V, typename Compare>
+size_t BPlusTree<K, V, Compare>::countRange(const K& minKey, const K& maxKey) const {
+    if (comparator(maxKey, minKey))
+        return 0;
+    return countLess(maxKey, true) - countLess(minKey, false);
+}
+
+template<typename K, typename V, typename Compare>
+vector<pair<K, V>> BPlusTree<K, V, Compare>::sliceByRank(size_t offset, size_t limit) const {
+    vector<pair<K, V>> result;
+    if (offset >= entryCount || limit == 0)
+        return result;
+    limit = std::min(limit, entryCount - offset);
+    result.reserve(limit);
+
+    // descend to the offset-th entry, then follow the leaf chain
+    const Node* node = root;
+    size_t index = offset;
+    while (!node->leaf) {
+        const InnerNode* inner = static_cast<const InnerNode*>(node);
+        int c = 0;
+        while (index >= inner->children[c]->total)
+            index -= inner->children[c++]->total;
+        node = inner->children[c];
+    }
+    const LeafNode* leaf = static_cast<const LeafNode*>(node);
+    for (int i = (int)index; result.size() < limit; i = 0, leaf = leaf->next) {
+        for (; i < leaf->count && result.size() < limit; ++i)
+            result.emplace_back(leaf->keys[i], leaf->values[i]);
+    }
+    return result;
+}
+
+template<typename K, typename V, typename Compare>
+typename BPlusTree<K, V, Compare>::const_iterator BPlusTree<K, V, Compare>::begin() const {
+    return const_iterator(this, firstLeaf(), 0);
+}
+
+template<typename K, typename V, typename Compare>
+typename BPlusTree<K, V, Compare>::const_iterator BPlusTree<K, V, Compare>::end() const {
+    return const_iterator(this, nullptr, 0);
+}
+
+template<typename K, typename V, typename Compare>
+typename BPlusTree<K, V, Compare>::const_iterator BPlusTree<K, V, Compare>::lower_bound(const K& key) const {
+    return boundAt(key, false);
+}
+
+template<typename K, typename V, typename Compare>
+typename BPlusTree<K, V, Compare>::const_iterator BPlusTree<K, V, Compare>::upper_bound(const K& key) const {
+    return boundAt(key, true);
+}
+
+template<typename K, typename V, typename Compare>
+template<typename Key>
+typename BPlusTree<K, V, Compare>::const_iterator BPlusTree<K, V, Compare>::boundAt(const Key& key, bool upper) const {
+    const LeafNode* leaf = findLeaf(key);
+    if (!leaf)
+        return end();
+    int i = upper ? upperSlot(leaf->keys, leaf->count, key) : lowerSlot(leaf->keys, leaf->count, key);
+    if (i == leaf->count)
+        return const_iterator(this, leaf->next, 0);
+    return const_iterator(this, leaf, i);
+}
+
+template<typename K, typename V, typename Compare>
+pair<typename BPlusTree<K, V, Compare>::const_iterator, typename BPlusTree<K, V, Compare>::const_iterator>
+BPlusTree<K, V, Compare>::equal_range(const K& key) const {
+    return make_pair(lower_bound(key), upper_bound(key));
+}
+
+template<typename K, typename V, typename Compare>
+template<typename Key, typename>
+vector<pair<K, V>> BPlusTree<K, V, Compare>::findRange(const Key& minKey, const Key& maxKey) const {
+    // probes are only ever compared with stored keys: two const char* would compare as pointers
+    vector<pair<K, V>> result;
+    for (const_iterator it = lower_bound(minKey); it != end() && !comparator(maxKey, it->key); ++it)
+        result.emplace_back(it->key, it->value);
+    return result;
+}
+
+template<typename K, typename V, typename Compare>
+template<typename Visitor>
+void BPlusTree<K, V, Compare>::forEachInRange(const K& minKey, const K& maxKey, Visitor visit) const {
+    const LeafNode* leaf = findLeaf(minKey);
+    if (!leaf)
+        return;
+    for (int i = lowerSlot(leaf->keys, leaf->count, minKey); leaf; i = 0, leaf = leaf->next) {
+        for (; i < leaf->count; ++i) {
+            if (comparator(maxKey, leaf->keys[i]))
+                return;
+            if (!visit(leaf->keys[i], leaf->values[i]))
+                return;
+        }
+    }
+}
+
+template<typename K, typename V, typename Compare>
+template<typename InputIt>
+void BPlusTree<K, V, Compare>::buildFromSorted(InputIt first, InputIt last) {
+    vector<pair<K, V>> items;
+    for (; first != last; ++first) {
+        auto&& item = *first;
+        if (!items.empty() && !comparator(items.back().first, item.first)) {
+            if (comparator(item.first, items.back().first))
+                throw std::invalid_argument("buildFromSorted: keys must be ascending");
+            continue; //equal key, the earlier entry wins
+        }
+        items.emplace_back(std::forward<decltype(item)>(item));
+    }
+    clear();
+    if (items.empty())
+        return;
+
+    // Leaves first, spreading entries evenly so every node meets MIN_KEYS,
+    // then each inner level over the one below until a single root remains.
+    vector<Node*> level;
+    vector<K> lowKeys;  // smallest key under each node of the current level
+    size_t leafCount = (items.size() + CAPACITY - 1) / CAPACITY;
+    LeafNode* prev = nullptr;
+    for (size_t l = 0, pos = 0; l < leafCount; ++l) {
+        size_t take = items.size() / leafCount + (l < items.size() % leafCount ? 1 : 0);
+        LeafNode* leaf = leafPool.create();
+        for (size_t i = 0; i < take; ++i, ++pos) {
+            leaf->keys[i] = std::move(items[pos].first);
+            leaf->values[i] = std::move(items[pos].second);
+        }
+        leaf->count = (int)take;
+        leaf->total = take;
+        leaf->prev = prev;
+        if (prev)
+            prev->next = leaf;
+        prev = leaf;
+        level.push_back(leaf);
+        lowKeys.push_back(leaf->keys[0]);
+    }
+
+    while (level.size() > 1) {
+        vector<Node*> parents;
+        vector<K> parentLowKeys;
+        size_t parentCount = (level.size() + CAPACITY) / (CAPACITY + 1);
+        for (size_t p = 0, pos = 0; p < parentCount; ++p) {
+            size_t take = level.size() / parentCount + (p < level.size() % parentCount ? 1 : 0);
+            InnerNode* inner = innerPool.create();
+            for (size_t c = 0; c < take; ++c, ++pos) {
+                inner->children[c] = level[pos];
+                inner->total += level[pos]->total;
+                if (c > 0)
+                    inner->keys[c - 1] = lowKeys[pos];
+            }
+            inner->count = (int)take - 1;
+            parents.push_back(inner);
+            parentLowKeys.push_back(std::move(lowKeys[pos - take]));
+        }
+        level.swap(parents);
+        lowKeys.swap(parentLowKeys);
+    }
+    root = level[0];
+    entryCount = items.size();
+}
+
+template<typename K, typename V, typename Compare>
+template<typename EncodeValue, typename EncodeKey>
+bool BPlusTree<K, V, Compare>::saveBinary(const string& path, EncodeValue encodeValue, EncodeKey encodeKey) const {
+    return saveIndexFile<K, V>(*this, path, encodeKey, encodeValue);
+}
+
+template<typename K, typename V, typename Compare>
+template<typename StoredValue, typename StoredKey, typename DecodeValue, typename DecodeKey>
+bool BPlusTree<K, V, Compare>::loadBinary(const string& path, DecodeValue decodeValue, DecodeKey decodeKey) {
+    vector<pair<K, V>> items;
+    auto less = [this](const K& a, const K& b) { return comparator(a, b); };
+    if (!readSortedIndexFile<StoredKey, StoredValue>(path, items, less, decodeKey, decodeValue))
+        return false;
+    buildFromSorted(make_move_iterator(items.begin()), make_move_iterator(items.end()));
+    return true;
+}
+
+template<typename K, typename V, typename Compare>
+vector<bool> BPlusTree<K, V, Compare>::insertBatch(vector<pair<K, V>> entries) {
+    vector<bool> inserted(entries.size(), false);
+    // stable, so the first of several equal keys is the one that gets in
+    vector<size_t> order(entries.size());
+    iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return comparator(entries[a].first, entries[b].first);
+    });
+
+    if (!batchPrefersRebuild(entries.size(), entryCount)) {
+        for (size_t i : order)
+            inserted[i] = insert(entries[i].first, entries[i].second);
+        return inserted;
+    }
+
+    vector<pair<K, V>> merged;
+    merged.reserve(entryCount + entries.size());
+    auto it = begin();
+    for (size_t i : order) {
+        const K& key = entries[i].first;
+        for (; it != end() && comparator(it->key, key); ++it)
+            merged.emplace_back(it->key, it->value);
+        bool inTree = it != end() && !comparator(key, it->key);
+        bool earlierInBatch = !merged.empty() && !comparator(merged.back().first, key);
+        if (inTree || earlierInBatch)
+            continue;
+        merged.push_back(std::move(entries[i]));
+        inserted[i] = true;
+    }
+    for (; it != end(); ++it)
+        merged.emplace_back(it->key, it->value);
+    buildFromSorted(make_move_iterator(merged.begin()), make_move_iterator(merged.end()));
+    return inserted;
+}
+
+template<typename K, typename V, typename Compare>
+vector<bool> BPlusTree<K, V, Compare>::removeBatch(vector<K> keys) {
+    vector<bool> removed(keys.size(), false);
+    vector<size_t> order(keys.size());
+    iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return comparator(keys[a], keys[b]);
+    });
+
+    if (!batchPrefersRebuild(keys.size(), entryCount)) {
+        for (size_t i : order)
+            removed[i] = remove(keys[i]);
+        return removed;
+    }
+
+    vector<pair<K, V>> kept;
+    kept.reserve(entryCount);
+    auto it = begin();
+    for (size_t i : order) {
+        for (; it != end() && comparator(it->key, keys[i]); ++it)
+            kept.emplace_back(it->key, it->value);
+        if (it != end() && !comparator(keys[i], it->key)) {
+            ++it;
+            removed[i] = true;
+        }
+    }
+    for (; it != end(); ++it)
+        kept.emplace_back(it->key, it->value);
+    buildFromSorted(make_move_iterator(kept.begin()), make_move_iterator(kept.end()));
+    return removed;
+}
+
+template<typename K, typename V, typename Compare>
+vector<pair<K, V>> BPlusTree<K, V, Compare>::inOrderTraversal() const {
+    vector<pair<K, V>> result;
+    result.reserve(entryCount);
+    for (const LeafNode* leaf = firstLeaf(); leaf; leaf = leaf->next) {
+        for (int i = 0; i < leaf->count; ++i)
+            result.emplace_back(leaf->keys[i], leaf->values[i]);
+    }
+    return result;
+}
+
+template<typename K, typename V, typename Compare>
+bool BPlusTree<K, V, Compare>::isValid() const {
+    if (!root)
+        return entryCount == 0;
+    int leafDepth = -1;
+    if (root->total != entryCount || !isValidHelper(root, nullptr, nullptr, 0, leafDepth))
+        return false;
+    if (!root->leaf && root->count < 1)
+        return false;
+    // the leaf chain must visit every entry exactly once, ascending, with matching back links
+    size_t seen = 0;
+    const LeafNode* prev = nullptr;
+    for (const LeafNode* leaf = firstLeaf(); leaf; prev = leaf, leaf = leaf->next) {
+        if (leaf->prev != prev)
+            return false;
+        if (prev && !comparator(prev->keys[prev->count - 1], leaf->keys[0]))
+            return false;
+        seen += leaf->count;
+    }
+    return seen == entryCount && prev == lastLeaf();
+}
+
+template<typename K, typename V, typename Compare>
+bool BPlusTree<K, V, Compare>::isValidHelper(const Node* node, const K* lower, const K* upper, int depth, int& leafDepth) const {
+    // every key must satisfy lower <= key < upper
+    if (node != root && (node->count < MIN_KEYS || node->count > CAPACITY))
+        return false;
+    if (node->leaf) {
+        const LeafNode* leaf = static_cast<const LeafNode*>(node);
+        if (leafDepth == -1)
+            leafDepth = depth;
+        if (depth != leafDepth || leaf->total != (size_t)leaf->count)
+            return false;
+        for (int i = 0; i < leaf->count; ++i) {
+            if (i > 0 && !comparator(leaf->keys[i - 1], leaf->keys[i]))
+                return false;
+            if ((lower && comparator(leaf->keys[i], *lower)) || (upper && !comparator(leaf->keys[i], *upper)))
+                return false;
+        }
+        return true;
+    }
+    const InnerNode* inner = static_cast<const InnerNode*>(node);
+    size_t total = 0;
+    for (int c = 0; c <= inner->count; ++c) {
+        if (c > 0 && c < inner->count && !comparator(inner->keys[c - 1], inner->keys[c]))
+            return false;
+        const K* childLower = c > 0 ? &inner->keys[c - 1] : lower;
+        const K* childUpper = c < inner->count ? &inner->keys[c] : upper;
+        if (!isValidHelper(inner->children[c], childLower, childUpper, depth + 1, leafDepth))
+            return false;
+        total += inner->children[c]->total;
+    }
+    return total == inner->total;
+}
+
+template<typename K, typename V, typename Compare>
+typename BPlusTree<K, V, Compare>::const_iterator& BPlusTree<K, V, Compare>::const_iterator::operator++() {
+    if (++index == leaf->count) {
+        leaf = leaf->next;
+        index = 0;
+    }
+    return *this;
+}
+
+template<typename K, typename V, typename Compare>
+typename BPlusTree<K, V, Compare>::const_iterator& BPlusTree<K, V, Compare>::const_iterator::operator--() {
+    if (!leaf) {
+        leaf = tree->lastLeaf();
+        index = leaf ? leaf->count - 1 : 0;
+    } else if (index > 0) {
+        index--;
+    } else {
+        leaf = leaf->prev;
+        index = leaf ? leaf->count - 1 : 0;
+    }
+    return *this;
+}
+
+template<typename K, typename V, typename Compare>
+typename BPlusTree<K, V, Compare>::Cursor BPlusTree<K, V, Compare>::cursor() const {
+    return Cursor(*this);
+}
+
+template<typename K, typename V, typename Compare>
+template<typename Key>
+bool BPlusTree<K, V, Compare>::Cursor::covers(const LeafNode* leaf, const Key& key) const {
+    // every key of the previous leaf is below key, and key is at most the next leaf's first
+    const LeafNode* prev = leaf->prev;
+    return (!prev || tree->comparator(prev->keys[prev->count - 1], key)) &&
+           (!leaf->next || !tree->comparator(leaf->next->keys[0], key));
+}
+
+template<typename K, typename V, typename Compare>
+template<typename Key>
+typename BPlusTree<K, V, Compare>::const_iterator BPlusTree<K, V, Compare>::Cursor::seekLowerBound(const Key& key) {
+    const LeafNode* leaf = nullptr;
+    if (finger) {
+        const LeafNode* neighbours[] = {finger, finger->next, finger->prev};
+        for (const LeafNode* near : neighbours) {
+            if (near && covers(near, key)) {
+                leaf = near;
+                break;
+            }
+        }
+    }
+    if (!leaf)
+        leaf = tree->findLeaf(key);
+    if (!leaf)
+        return tree->end();
+    finger = leaf;
+    int i = tree->lowerSlot(leaf->keys, leaf->count, key);
+    if (i == leaf->count)
+        return const_iterator(tree, leaf->next, 0);
+    return const_iterator(tree, leaf, i);
+}
+
+template<typename K, typename V, typename Compare>
+template<typename Key>
+const V* BPlusTree<K, V, Compare>::Cursor::seek(const Key& key) {
+    const_iterator it = seekLowerBound(key);
+    if (it == tree->end() || tree->comparator(key, it->key))
+        return nullptr;
+    return &it->value;
+}
+
+template class BPlusTree<int, string>;
+template class BPlusTree<string, string>;
+template class BPlusTree<int, int>;
@@ -4,126 +4,227 @@
 #include <stdexcept>
 using namespace std;
 
-template<typename K, typename V>
-BST<K, V>::BST() : root(nullptr), nodeCount(0) {
-    comparator = [](const K& a, const K& b) { return a < b; };
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+BST<K, V, Compare, Storage, Augment>::BST() : BST(defaultComparator()) {
 }
 
-template<typename K, typename V> 
-BST<K, V>::BST(function<bool(const K&, const K&)> comp) 
-    : root(nullptr), nodeCount(0), comparator(comp) {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+BST<K, V, Compare, Storage, Augment>::BST(Compare comp)
+    : ComparatorBase<Compare>(std::move(comp)), root(nullptr), nodeCount(0), statsDepth(0) {
 }
 
-template<typename K, typename V>
-bool BST<K, V>::insert(const K& key, const V& value) {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+Compare BST<K, V, Compare, Storage, Augment>::defaultComparator() {
+    // an empty DynamicCompare would throw on first use, so default it to <
+    if constexpr (is_same<Compare, DynamicCompare<K>>::value)
+        return [](const K& a, const K& b) { return a < b; };
+    else
+        return Compare();
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+BST<K, V, Compare, Storage, Augment>::BST(BST&& other)
+    : ComparatorBase<Compare>(std::move(other.keyCompare())),
+      root(std::move(other.root)), nodeCount(other.nodeCount), stats(other.stats),
+      statsDepth(0), pool(std::move(other.pool)) {
+    other.root = nullptr;
+    other.nodeCount = 0;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+BST<K, V, Compare, Storage, Augment>& BST<K, V, Compare, Storage, Augment>::operator=(BST&& other) {
+    if (this != &other) {
+        clear();
+        root = std::move(other.root);
+        nodeCount = other.nodeCount;
+        stats = other.stats;
+        this->keyCompare() = std::move(other.keyCompare());
+        pool = std::move(other.pool);
+        other.root = nullptr;
+        other.nodeCount = 0;
+    }
+    return *this;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+BST<K, V, Compare, Storage, Augment>::~BST() {
+    clear();
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+void BST<K, V, Compare, Storage, Augment>::clear() {
+    destroySubtree(std::move(root));
+    root = nullptr;
+    nodeCount = 0;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+void BST<K, V, Compare, Storage, Augment>::destroySubtree(NodePtr node) {
+    // shared_ptr nodes release themselves once the last owner lets go;
+    // pooled nodes have to be handed back explicitly.
+    if constexpr (Storage::ownsNodes) {
+        vector<NodePtr> pending;
+        if (node) pending.push_back(node);
+        while (!pending.empty()) {
+            NodePtr current = pending.back();
+            pending.pop_back();
+            if (current->left) pending.push_back(current->left);
+            if (current->right) pending.push_back(current->right);
+            destroyNode(current);
+        }
+    } else {
+        // Dropping the root would free a long chain through one nested
+        // destructor per level; detach each node's children before it dies.
+        // A node someone else still holds is left intact for that owner.
+        vector<NodePtr> pending;
+        if (node) pending.push_back(std::move(node));
+        while (!pending.empty()) {
+            NodePtr current = std::move(pending.back());
+            pending.pop_back();
+            if (current.use_count() != 1)
+                continue;
+            if (current->left) pending.push_back(std::move(current->left));
+            if (current->right) pending.push_back(std::move(current->right));
+        }
+    }
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+bool BST<K, V, Compare, Storage, Augment>::insert(const K& key, const V& value) {
     if (find(key) != nullptr) return false; 
     root = insertHelper(root, key, value);
+    root->parent = ParentPtr();
     nodeCount++;
     return true;
 }
 
-template<typename K, typename V>
-shared_ptr<typename BST<K, V>::BSTNode> BST<K, V>::insertHelper(shared_ptr<BSTNode> node, const K& key, const V& value) {
-    if (node ==nullptr)
-        return make_shared<BSTNode>(key,value);
-    if (comparator(key,node->key)) //key<node.key -- go left
-    {
-        node->left = insertHelper(node->left,key,value);
-        if (node->left)
-        node->left->parent=node;
-    }
-    else
-    {
-        node->right = insertHelper(node->right,key,value);
-        if (node->right)
-        node->right->parent=node;
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename BST<K, V, Compare, Storage, Augment>::NodePtr BST<K, V, Compare, Storage, Augment>::insertHelper(NodePtr node, const K& key, const V& value) {
+    // Iterative so a degenerate tree (e.g. sequential keys) cannot overflow the stack.
+    // Walks the child links themselves so the new node is attached in place.
+    if (node == nullptr)
+        return createNode(key,value);
+    NodePtr* link = &node;
+    NodePtr* parentLink = nullptr;
+    while (*link) {
+        parentLink = link;
+        BSTNode* current = rawNode(*link);
+        link = comparator(key,current->key) ? &current->left : &current->right; //key<node.key -- go left
     }
-
-    updateHeight(node);
+    *link = createNode(key,value);
+    (*link)->parent = ParentPtr(*parentLink);
+    refreshPath(*parentLink, node);
     return node;
 }
-// template<typename K, typename V>
-// shared_ptr<typename BST<K, V>::BSTNode> BST<K, V>::insertHelper(shared_ptr<BSTNode> node, const K& key, const V& value) {
+// template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+// typename BST<K, V, Compare, Storage, Augment>::NodePtr BST<K, V, Compare, Storage, Augment>::insertHelper(NodePtr node, const K& key, const V& value) {
 
 // }
 
 
-template<typename K, typename V>
-bool BST<K, V>::remove(const K& key) {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+bool BST<K, V, Compare, Storage, Augment>::remove(const K& key) {
     if (find(key)==nullptr){
         return false;
     }
     root = removeHelper(root,key);
+    if (root)
+        root->parent = ParentPtr();
     nodeCount--;
     return true;
 }
 
-template<typename K, typename V>
-shared_ptr<typename BST<K, V>::BSTNode> BST<K, V>::removeHelper(shared_ptr<BSTNode> node, const K& key) {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename BST<K, V, Compare, Storage, Augment>::NodePtr BST<K, V, Compare, Storage, Augment>::removeHelper(NodePtr node, const K& key) {
     // finds the key,
     // if no child then remove.
     // if one child then assign child to parent.
-    // if two child then replace it with PSN or NGE.
-    if (node == nullptr)
-            return nullptr;
-    if (comparator(node->key,key)) //node.key is less than key to find. move right
-    {
-        node->right = removeHelper(node->right,key);
+    // if two child then replace it with NGE (next greater element).
+    NodePtr* link = &node;
+    while (*link) {
+        BSTNode* current = rawNode(*link);
+        if (comparator(current->key,key)) //node.key is less than key to find. move right
+            link = &current->right;
+        else if (comparator(key,current->key)) //key<node.key
+            link = &current->left;
+        else
+            break;
     }
-    else if (comparator(key,node->key)) //key<node.key
-    {
-        node->left = removeHelper(node->left,key);
+    if (!*link)
+        return node;
+
+    NodePtr target = *link;
+    NodePtr changedFrom = nullptr; //lowest node whose height/size changed
+    if (target->left && target->right) {
+        //both children exist: move the NGE's entry up, then unlink the NGE node
+        NodePtr* ngeLink = &target->right;
+        while ((*ngeLink)->left)
+            ngeLink = &(*ngeLink)->left;
+        NodePtr nge = *ngeLink;
+        target->key = std::move(nge->key);
+        target->value = std::move(nge->value);
+        changedFrom = Storage::template Pool<BSTNode>::parentOf(rawNode(nge));
+        *ngeLink = nge->right;
+        if (*ngeLink)
+            (*ngeLink)->parent = nge->parent;
+        destroyNode(nge);
+    } else {
+        NodePtr child = target->left ? target->left : target->right;
+        if (target != node)
+            changedFrom = Storage::template Pool<BSTNode>::parentOf(rawNode(target));
+        *link = child;
+        if (child)
+            child->parent = target->parent;
+        destroyNode(target);
     }
-    else{ //node found
-        if (node->right == nullptr) //right doesnt exist
-        {
-            return node->left;
-        }
-        if (node->left == nullptr) //left doesnt exist
-            return node->right;
-        //both children exist, replace with Next greater element.
-        // change key value, then call remove on the NGE node
-        auto nge = (findMinHelper(node->right));
-        node->key = nge->key;
-        node->value = nge->value;
-        node->right = removeHelper(node->right,nge->key);
-    }
-    if (node->left)
-    node->left->parent = node;
-    if (node->right)
-    node->right->parent = node;
-    updateHeight(node);
+    refreshPath(changedFrom, node);
     return node;
 }
 
-template<typename K, typename V>
-V* BST<K, V>::find(const K& key) {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+void BST<K, V, Compare, Storage, Augment>::refreshPath(NodePtr from, const NodePtr& top) {
+    // recompute height/size/summary from `from` up through the parent links, ending at top
+    for (NodePtr node = from; node; node = Storage::template Pool<BSTNode>::parentOf(rawNode(node))) {
+        updateHeight(node);
+        if (node == top)
+            break;
+    }
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+V* BST<K, V, Compare, Storage, Augment>::find(const K& key) {
+    statsOperation();
     auto found = (findHelper(root,key));
     if (found==nullptr)
         return nullptr;
     return &(found->value);}
 
-template<typename K, typename V>
-const V* BST<K, V>::find(const K& key) const {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+const V* BST<K, V, Compare, Storage, Augment>::find(const K& key) const {
+    statsOperation();
     auto found = (findHelper(root,key));
     if (found==nullptr)
         return nullptr;
     return &(found->value);}
 
-template<typename K, typename V>
-shared_ptr<typename BST<K, V>::BSTNode> BST<K, V>::findHelper(shared_ptr<BSTNode> node, const K& key) const {
-    if (node==nullptr)
-        return nullptr;
-    if (comparator(node->key,key)) //node.key<key
-    return findHelper(node->right,key);
-
-    else if (comparator(key,node->key)) //node.key>key
-    return findHelper(node->left,key);
-    else return node;
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename BST<K, V, Compare, Storage, Augment>::NodePtr BST<K, V, Compare, Storage, Augment>::findHelper(NodePtr node, const K& key) const {
+    const NodePtr* link = &node;
+    while (*link) {
+        BSTNode* current = rawNode(*link);
+        statsVisit();
+        if (comparator(current->key,key)) //node.key<key
+            link = &current->right;
+        else if (comparator(key,current->key)) //node.key>key
+            link = &current->left;
+        else
+            return *link;
+    }
+    return nullptr;
 }
 
-template<typename K, typename V>
-pair<K, V> BST<K, V>::min() const {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+pair<K, V> BST<K, V, Compare, Storage, Augment>::min() const {
     
     auto minimum = findMinHelper(root);
     if (!minimum)
@@ -131,78 +232,139 @@ pair<K, V> BST<K, V>::min() const {
     return make_pair(minimum->key, minimum->value);
 }
 
-template<typename K, typename V>
-shared_ptr<typename BST<K, V>::BSTNode> BST<K, V>::findMinHelper(shared_ptr<BSTNode> node) const {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename BST<K, V, Compare, Storage, Augment>::NodePtr BST<K, V, Compare, Storage, Augment>::findMinHelper(NodePtr node) const {
     if (!node) return nullptr;
-    if (node->left)
-        return findMinHelper(node->left);
-    else return node ;
+    const NodePtr* link = &node;
+    while ((*link)->left)
+        link = &(*link)->left;
+    return *link;
 }
 
-template<typename K, typename V>
-pair<K, V> BST<K, V>::max() const {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+pair<K, V> BST<K, V, Compare, Storage, Augment>::max() const {
 
     auto maximum =  findMaxHelper(root);
         if (!maximum)
         throw std::runtime_error("the bst is empty, couldnt find max");
     return make_pair(maximum->key, maximum->value);}
 
-template<typename K, typename V>
-shared_ptr<typename BST<K, V>::BSTNode> BST<K, V>::findMaxHelper(shared_ptr<BSTNode> node) const {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename BST<K, V, Compare, Storage, Augment>::NodePtr BST<K, V, Compare, Storage, Augment>::findMaxHelper(NodePtr node) const {
     if (!node) return nullptr;
-    if (node->right)
-        return findMaxHelper(node->right);
-    else return node ;
+    const NodePtr* link = &node;
+    while ((*link)->right)
+        link = &(*link)->right;
+    return *link;
 }
 
-template<typename K, typename V>
-vector<pair<K, V>> BST<K, V>::findRange(const K& minKey, const K& maxKey) const {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+vector<pair<K, V>> BST<K, V, Compare, Storage, Augment>::findRange(const K& minKey, const K& maxKey) const {
     vector<pair<K,V>> result;
     rangeHelper(root,minKey,maxKey,result);
     return result;
 }
 
-template<typename K, typename V>
-void BST<K, V>::rangeHelper(shared_ptr<BSTNode> node, const K& minKey, const K& maxKey, vector<pair<K, V>>& result) const {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+void BST<K, V, Compare, Storage, Augment>::rangeHelper(NodePtr node, const K& minKey, const K& maxKey, vector<pair<K, V>>& result) const {
     //MUST be INCLUSIVE!!
-    if (node == nullptr)
-        return;
-    if (node->left && comparator(minKey,node->key)) //min<key go left
-    {
-        rangeHelper(node->left,minKey,maxKey,result);
-    }
-    
-    if (!(comparator(node->key,minKey) || comparator(maxKey,node->key))) //min< current key <max, push 
-    {
-        auto kv_pair = make_pair(node->key,node->value);
-        result.push_back(kv_pair);
-    }
-    if (node->right && comparator(node->key,maxKey))
-    {
-        rangeHelper(node->right,minKey,maxKey,result);
+    //in-order walk on an explicit stack, skipping subtrees that lie outside [min, max]
+    vector<BSTNode*> pending;
+    BSTNode* current = rawNode(node);
+    while (current || !pending.empty()) {
+        while (current) {
+            pending.push_back(current);
+            current = comparator(minKey,current->key) ? rawNode(current->left) : nullptr; //min<key go left
+        }
+        current = pending.back();
+        pending.pop_back();
+        if (!(comparator(current->key,minKey) || comparator(maxKey,current->key))) //min< current key <max, push
+            result.push_back(make_pair(current->key,current->value));
+        current = comparator(current->key,maxKey) ? rawNode(current->right) : nullptr;
     }
 }
 
-template<typename K, typename V>
-vector<pair<K, V>> BST<K, V>::inOrderTraversal() const {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+vector<pair<K, V>> BST<K, V, Compare, Storage, Augment>::inOrderTraversal() const {
     vector<pair<K,V>> result;
-    inOrderHelper(root,result);
+    if (root)
+        inOrderHelper(root,result);
     return result;
 }
 
-template<typename K, typename V>
-void BST<K, V>::inOrderHelper(shared_ptr<BSTNode> node, vector<pair<K, V>>& result) const {
-    if (node->left)
-    inOrderHelper(node->left,result);
-    result.push_back(make_pair(node->key,node->value));
-    
-    if (node->right)
-        inOrderHelper(node->right,result);
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+vector<pair<K, V>> BST<K, V, Compare, Storage, Augment>::inOrderTraversal(ThreadPool& threads) const {
+    vector<pair<K, V>> result(nodeCount);
+    vector<SubtreeTask> tasks, upper;
+    splitForTasks(threads.size(), tasks, upper);
+    for (const SubtreeTask& top : upper)
+        result[top.offset] = make_pair(top.node->key, top.node->value);
+    threads.parallelFor(tasks.size(), [&](size_t i) {
+        pair<K, V>* out = result.data() + tasks[i].offset;
+        forEachInOrder(rawNode(tasks[i].node), [&](BSTNode* node) {
+            out->first = node->key;
+            out->second = node->value;
+            ++out;
+        });
+    });
+    return result;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+void BST<K, V, Compare, Storage, Augment>::splitForTasks(size_t threads, vector<SubtreeTask>& tasks, vector<SubtreeTask>& upper) const {
+    // several tasks per thread even out lopsided subtrees; below ~1K nodes a
+    // task costs more to hand out than to run
+    const size_t grain = std::max<size_t>(nodeCount / (8 * threads), 1024);
+    vector<SubtreeTask> pending;
+    if (root)
+        pending.push_back(SubtreeTask{root, 0, 1});
+    while (!pending.empty()) {
+        SubtreeTask task = std::move(pending.back());
+        pending.pop_back();
+        if (task.node->subtreeSize <= grain) {
+            tasks.push_back(std::move(task));
+            continue;
+        }
+        size_t leftSize = getSize(task.node->left);
+        if (task.node->left)
+            pending.push_back(SubtreeTask{task.node->left, task.offset, task.depth + 1});
+        if (task.node->right)
+            pending.push_back(SubtreeTask{task.node->right, task.offset + leftSize + 1, task.depth + 1});
+        task.offset += leftSize;
+        upper.push_back(std::move(task));
+    }
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename Visit>
+void BST<K, V, Compare, Storage, Augment>::forEachInOrder(BSTNode* node, Visit visit) {
+    vector<BSTNode*> pending;
+    while (node || !pending.empty()) {
+        for (; node; node = rawNode(node->left))
+            pending.push_back(node);
+        node = pending.back();
+        pending.pop_back();
+        visit(node);
+        node = rawNode(node->right);
+    }
+}
 
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+void BST<K, V, Compare, Storage, Augment>::inOrderHelper(NodePtr node, vector<pair<K, V>>& result) const {
+    vector<BSTNode*> pending;
+    BSTNode* current = rawNode(node);
+    while (current || !pending.empty()) {
+        for (; current; current = rawNode(current->left))
+            pending.push_back(current);
+        current = pending.back();
+        pending.pop_back();
+        result.push_back(make_pair(current->key,current->value));
+        current = rawNode(current->right);
+    }
 }
 
-template<typename K, typename V>
-void BST<K, V>::displayTree() const {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+void BST<K, V, Compare, Storage, Augment>::displayTree() const {
     vector<pair<K,V>> result;
     result = inOrderTraversal();
     for (int i=0;i<result.size();i++)
@@ -211,12 +373,12 @@ void BST<K, V>::displayTree() const {
     }
 }
 
-template<typename K, typename V>
-void BST<K, V>::displayHelper(shared_ptr<BSTNode> node, int depth) const {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+void BST<K, V, Compare, Storage, Augment>::displayHelper(NodePtr node, int depth) const {
 }
 
-template<typename K, typename V>
-bool BST<K, V>::isValidBST() const {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+bool BST<K, V, Compare, Storage, Augment>::isValidBST() const {
     if (!root)
         return true;    //tree doesnt even exist
     // auto minptr = &((min()).first);
@@ -224,36 +386,423 @@ bool BST<K, V>::isValidBST() const {
     return isValidBSTHelper(root,nullptr,nullptr);
 }
 
-template<typename K, typename V>
-bool BST<K, V>::isValidBSTHelper(shared_ptr<BSTNode> node, const K* minVal, const K* maxVal) const {
-
-    if(minVal && comparator(node->key,*minVal))
-        return false;
-    if(maxVal && comparator(*maxVal,node->key))
-        return false;
-    if (node->left)
-        return isValidBSTHelper(node,minVal,&node->key);
-    if (node->right)
-        return isValidBSTHelper(node,&node->key,maxVal);
-
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+bool BST<K, V, Compare, Storage, Augment>::isValidBSTHelper(NodePtr node, const K* minVal, const K* maxVal) const {
+    //each pending node carries the bounds its key must respect
+    struct Bounded { BSTNode* node; const K* minVal; const K* maxVal; };
+    vector<Bounded> pending;
+    if (node)
+        pending.push_back({rawNode(node), minVal, maxVal});
+    while (!pending.empty()) {
+        Bounded current = pending.back();
+        pending.pop_back();
+        if(current.minVal && comparator(current.node->key,*current.minVal))
+            return false;
+        if(current.maxVal && comparator(*current.maxVal,current.node->key))
+            return false;
+        if (current.node->left)
+            pending.push_back({rawNode(current.node->left), current.minVal, &current.node->key});
+        if (current.node->right)
+            pending.push_back({rawNode(current.node->right), &current.node->key, current.maxVal});
+    }
     return true;
 }
 
-template<typename K, typename V>
-void BST<K, V>::updateHeight(shared_ptr<BSTNode> node) {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+void BST<K, V, Compare, Storage, Augment>::updateHeight(NodePtr node) {
     if (!node)
         node->height=0;
     node->height = 1+std::max(getHeight(node->left),getHeight(node->right));
+    node->subtreeSize = 1+getSize(node->left)+getSize(node->right);
+    node->summary = Augment::combine(Augment::combine(summaryOf(rawNode(node->left)), entrySummary(rawNode(node))),
+                                     summaryOf(rawNode(node->right)));
 }
 
-template<typename K, typename V>
-int BST<K, V>::getHeight(shared_ptr<BSTNode> node) const {
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+int BST<K, V, Compare, Storage, Augment>::getHeight(NodePtr node) const {
     if (!node)
         return 0;
     return node->height;
 }
 
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+size_t BST<K, V, Compare, Storage, Augment>::getSize(NodePtr node) const {
+    if (!node)
+        return 0;
+    return node->subtreeSize;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+size_t BST<K, V, Compare, Storage, Augment>::countLess(const K& key, bool inclusive) const {
+    // counts keys < key (or <= key when inclusive) along a single descent
+    size_t count = 0;
+    BSTNode* node = rawNode(root);
+    while (node) {
+        bool goRight = inclusive ? !comparator(key, node->key) : comparator(node->key, key);
+        if (goRight) {
+            count += getSize(node->left) + 1;
+            node = rawNode(node->right);
+        } else {
+            node = rawNode(node->left);
+        }
+    }
+    return count;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+size_t BST<K, V, Compare, Storage, Augment>::rank(const K& key) const {
+    return countLess(key, false);
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+pair<K, V> BST<K, V, Compare, Storage, Augment>::select(size_t index) const {
+    if (index >= getSize(root))
+        throw std::out_of_range("select index is past the end of the bst");
+    BSTNode* node = rawNode(root);
+    while (true) {
+        size_t leftSize = getSize(node->left);
+        if (index < leftSize) {
+            node = rawNode(node->left);
+        } else if (index == leftSize) {
+            return make_pair(node->key, node->value);
+        } else {
+            index -= leftSize + 1;
+            node = rawNode(node->right);
+        }
+    }
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+size_t BST<K, V, Compare, Storage, Augment>::countRange(const K& minKey, const K& maxKey) const {
+    if (comparator(maxKey, minKey))
+        return 0;
+    return countLess(maxKey, true) - countLess(minKey, false);
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename BST<K, V, Compare, Storage, Augment>::Summary BST<K, V, Compare, Storage, Augment>::aggregateRange(const K& minKey, const K& maxKey) const {
+    if (comparator(maxKey, minKey))
+        return Augment::identity();
+    // descend to the first node inside the range; every other match lies below it
+    BSTNode* split = rawNode(root);
+    while (split) {
+        if (comparator(split->key, minKey))
+            split = rawNode(split->right);
+        else if (comparator(maxKey, split->key))
+            split = rawNode(split->left);
+        else
+            break;
+    }
+    if (!split)
+        return Augment::identity();
+
+    // left boundary: a node >= minKey brings its whole right subtree (all <= maxKey)
+    Summary lower = Augment::identity();
+    for (BSTNode* node = rawNode(split->left); node;) {
+        if (comparator(node->key, minKey)) {
+            node = rawNode(node->right);
+        } else {
+            lower = Augment::combine(Augment::combine(entrySummary(node), summaryOf(rawNode(node->right))), lower);
+            node = rawNode(node->left);
+        }
+    }
+    // right boundary, mirrored
+    Summary upper = Augment::identity();
+    for (BSTNode* node = rawNode(split->right); node;) {
+        if (comparator(maxKey, node->key)) {
+            node = rawNode(node->left);
+        } else {
+            upper = Augment::combine(upper, Augment::combine(summaryOf(rawNode(node->left)), entrySummary(node)));
+            node = rawNode(node->right);
+        }
+    }
+    return Augment::combine(Augment::combine(lower, entrySummary(split)), upper);
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+bool BST<K, V, Compare, Storage, Augment>::refresh(const K& key) {
+    NodePtr node = findHelper(root, key);
+    if (!node)
+        return false;
+    valueChanged(node);
+    return true;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+vector<pair<K, V>> BST<K, V, Compare, Storage, Augment>::sliceByRank(size_t offset, size_t limit) const {
+    vector<pair<K, V>> result;
+    if (offset >= getSize(root) || limit == 0)
+        return result;
+    result.reserve(std::min(limit, getSize(root) - offset));
+
+    // descend to the offset-th node, stacking every ancestor still to be visited
+    vector<BSTNode*> pending;
+    BSTNode* node = rawNode(root);
+    while (node) {
+        size_t leftSize = getSize(node->left);
+        if (offset < leftSize) {
+            pending.push_back(node);
+            node = rawNode(node->left);
+        } else if (offset == leftSize) {
+            pending.push_back(node);
+            break;
+        } else {
+            offset -= leftSize + 1;
+            node = rawNode(node->right);
+        }
+    }
+
+    // then continue an ordinary in-order walk until the page is full
+    while (!pending.empty() && result.size() < limit) {
+        node = pending.back();
+        pending.pop_back();
+        result.push_back(make_pair(node->key, node->value));
+        for (BSTNode* next = rawNode(node->right); next; next = rawNode(next->left))
+            pending.push_back(next);
+    }
+    return result;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename BST<K, V, Compare, Storage, Augment>::BSTNode* BST<K, V, Compare, Storage, Augment>::parentNode(const BSTNode* node) {
+    return rawNode(Storage::template Pool<BSTNode>::parentOf(node));
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename Key>
+typename BST<K, V, Compare, Storage, Augment>::BSTNode* BST<K, V, Compare, Storage, Augment>::findNode(const Key& key) const {
+    BSTNode* node = rawNode(root);
+    while (node) {
+        statsVisit();
+        if (comparator(node->key, key))
+            node = rawNode(node->right);
+        else if (comparator(key, node->key))
+            node = rawNode(node->left);
+        else
+            return node;
+    }
+    return nullptr;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename Key>
+typename BST<K, V, Compare, Storage, Augment>::BSTNode* BST<K, V, Compare, Storage, Augment>::lowerBoundNode(const Key& key) const {
+    BSTNode* candidate = nullptr;
+    BSTNode* node = rawNode(root);
+    while (node) {
+        if (comparator(node->key, key)) { //node.key < key, answer is to the right
+            node = rawNode(node->right);
+        } else {
+            candidate = node;
+            node = rawNode(node->left);
+        }
+    }
+    return candidate;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename Key>
+typename BST<K, V, Compare, Storage, Augment>::BSTNode* BST<K, V, Compare, Storage, Augment>::upperBoundNode(const Key& key) const {
+    BSTNode* candidate = nullptr;
+    BSTNode* node = rawNode(root);
+    while (node) {
+        if (comparator(key, node->key)) { //key < node.key
+            candidate = node;
+            node = rawNode(node->left);
+        } else {
+            node = rawNode(node->right);
+        }
+    }
+    return candidate;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename BST<K, V, Compare, Storage, Augment>::const_iterator BST<K, V, Compare, Storage, Augment>::begin() const {
+    BSTNode* node = rawNode(root);
+    while (node && node->left)
+        node = rawNode(node->left);
+    return const_iterator(this, node);
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename BST<K, V, Compare, Storage, Augment>::const_iterator BST<K, V, Compare, Storage, Augment>::end() const {
+    return const_iterator(this, nullptr);
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename BST<K, V, Compare, Storage, Augment>::const_iterator BST<K, V, Compare, Storage, Augment>::lower_bound(const K& key) const {
+    return const_iterator(this, lowerBoundNode(key));
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename BST<K, V, Compare, Storage, Augment>::const_iterator BST<K, V, Compare, Storage, Augment>::upper_bound(const K& key) const {
+    return const_iterator(this, upperBoundNode(key));
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+pair<typename BST<K, V, Compare, Storage, Augment>::const_iterator, typename BST<K, V, Compare, Storage, Augment>::const_iterator>
+BST<K, V, Compare, Storage, Augment>::equal_range(const K& key) const {
+    return make_pair(lower_bound(key), upper_bound(key));
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename Key, typename>
+V* BST<K, V, Compare, Storage, Augment>::find(const Key& key) {
+    statsOperation();
+    BSTNode* node = findNode(key);
+    return node ? &node->value : nullptr;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename Key, typename>
+const V* BST<K, V, Compare, Storage, Augment>::find(const Key& key) const {
+    statsOperation();
+    BSTNode* node = findNode(key);
+    return node ? &node->value : nullptr;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename Key, typename>
+typename BST<K, V, Compare, Storage, Augment>::const_iterator BST<K, V, Compare, Storage, Augment>::lower_bound(const Key& key) const {
+    return const_iterator(this, lowerBoundNode(key));
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename Key, typename>
+typename BST<K, V, Compare, Storage, Augment>::const_iterator BST<K, V, Compare, Storage, Augment>::upper_bound(const Key& key) const {
+    return const_iterator(this, upperBoundNode(key));
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename Key, typename>
+vector<pair<K, V>> BST<K, V, Compare, Storage, Augment>::findRange(const Key& minKey, const Key& maxKey) const {
+    // probes are only ever compared with stored keys: two const char* would compare as pointers
+    vector<pair<K, V>> result;
+    for (const_iterator it = lower_bound(minKey); it != end() && !comparator(maxKey, it->key); ++it)
+        result.emplace_back(it->key, it->value);
+    return result;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename Visitor>
+void BST<K, V, Compare, Storage, Augment>::forEachInRange(const K& minKey, const K& maxKey, Visitor visit) const {
+    if (comparator(maxKey, minKey))
+        return;
+    for (const_iterator it = lower_bound(minKey); it != end() && !comparator(maxKey, it->key); ++it) {
+        if (!visit(it->key, it->value))
+            return;
+    }
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename BST<K, V, Compare, Storage, Augment>::const_iterator& BST<K, V, Compare, Storage, Augment>::const_iterator::operator++() {
+    if (!node)
+        return *this;
+    if (node->right) { //leftmost node of the right subtree
+        node = rawNode(node->right);
+        while (node->left)
+            node = rawNode(node->left);
+        return *this;
+    }
+    //climb until we arrive from a left child
+    BSTNode* parent = parentNode(node);
+    while (parent && rawNode(parent->right) == node) {
+        node = parent;
+        parent = parentNode(node);
+    }
+    node = parent;
+    return *this;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename BST<K, V, Compare, Storage, Augment>::const_iterator& BST<K, V, Compare, Storage, Augment>::const_iterator::operator--() {
+    if (!node) { //end() steps back to the maximum
+        node = rawNode(tree->root);
+        while (node && node->right)
+            node = rawNode(node->right);
+        return *this;
+    }
+    if (node->left) { //rightmost node of the left subtree
+        node = rawNode(node->left);
+        while (node->right)
+            node = rawNode(node->right);
+        return *this;
+    }
+    BSTNode* parent = parentNode(node);
+    while (parent && rawNode(parent->left) == node) {
+        node = parent;
+        parent = parentNode(node);
+    }
+    node = parent;
+    return *this;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename BST<K, V, Compare, Storage, Augment>::Cursor BST<K, V, Compare, Storage, Augment>::cursor() const {
+    return Cursor(*this);
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename Key>
+typename BST<K, V, Compare, Storage, Augment>::BSTNode* BST<K, V, Compare, Storage, Augment>::Cursor::climb(const Key& key) const {
+    BSTNode* node = finger ? finger : rawNode(tree->root);
+    if (!node)
+        return nullptr;
+    // node's subtree is bounded by its parent on one side. Heading up from the
+    // finger toward key, stop at the first node whose parent bounds it beyond key.
+    bool ascending = tree->comparator(node->key, key);
+    if (!ascending && !tree->comparator(key, node->key))
+        return node; //the finger holds key already
+    for (BSTNode* parent = parentNode(node); parent; node = parent, parent = parentNode(node)) {
+        tree->statsVisit();
+        bool fromLeft = rawNode(parent->left) == node;
+        if (ascending && fromLeft && !tree->comparator(parent->key, key))   //key <= parent.key
+            return tree->comparator(key, parent->key) ? node : parent;      //an equal parent is not in node's subtree
+        if (!ascending && !fromLeft && tree->comparator(parent->key, key))  //parent.key < key
+            break;
+    }
+    return node;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename Key>
+typename BST<K, V, Compare, Storage, Augment>::const_iterator BST<K, V, Compare, Storage, Augment>::Cursor::seekLowerBound(const Key& key) {
+    tree->statsOperation();
+    BSTNode* candidate = nullptr;
+    BSTNode* last = nullptr;
+    for (BSTNode* node = climb(key); node; ) {
+        tree->statsVisit();
+        last = node;
+        if (tree->comparator(node->key, key)) { //node.key < key, answer is to the right
+            node = rawNode(node->right);
+        } else {
+            candidate = node;
+            if (!tree->comparator(key, node->key)) //exact match, nothing below can be closer
+                break;
+            node = rawNode(node->left);
+        }
+    }
+    finger = candidate ? candidate : last;
+    if (candidate)
+        return const_iterator(tree, candidate);
+    // the whole subtree we descended is below key: its bound above (if any) is the answer
+    const_iterator next(tree, last);
+    return ++next;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename Key>
+const V* BST<K, V, Compare, Storage, Augment>::Cursor::seek(const Key& key) {
+    const_iterator it = seekLowerBound(key);
+    if (it == tree->end() || tree->comparator(key, it->key))
+        return nullptr;
+    return &it->value;
+}
+
 template class BST<int, string>;
 template class BST<string, string>;
 template class BST<int, int>;
-template class BST<string, void*>;
\ No newline at end of file
+template class BST<string, void*>;
+template class BST<int, string, DynamicCompare<int>>;
+template class BST<int, int, less<int>, ArenaNodeStorage>;
+template class BST<string, string, less<string>, ArenaNodeStorage>;
\ No newline at end of file
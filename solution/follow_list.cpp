@@ -20,6 +20,7 @@ void FollowList::addFollowing(User* u) {
     FollowNode* newNode = new FollowNode(u);
     newNode->next = head;
     head = newNode;
+    count++;
 }
 
 bool FollowList::removeFollowing(int userID) {
@@ -34,6 +35,7 @@ bool FollowList::removeFollowing(int userID) {
                 head = current->next;
             }
             delete current;
+            count--;
             return true;
         }
         prev = current;
@@ -0,0 +1,120 @@
+#include "../headers/frozen_index.h"
+#include <stdexcept>
+using namespace std;
+
+template<typename K, typename V, typename Compare>
+FrozenIndex<K, V, Compare>::FrozenIndex(const vector<pair<K, V>>& sortedEntries, Compare comp)
+    : ComparatorBase<Compare>(std::move(comp)) {
+    build(sortedEntries);
+}
+
+template<typename K, typename V, typename Compare>
+void FrozenIndex<K, V, Compare>::build(const vector<pair<K, V>>& sortedEntries) {
+    if (sortedEntries.size() > UINT32_MAX)
+        throw std::length_error("frozen index holds at most 2^32 - 1 entries");
+    mapping.reset();
+    mappedCount = 0;
+    entries.clear();
+    entries.reserve(sortedEntries.size());
+    for (const auto& entry : sortedEntries)
+        entries.push_back(Entry{entry.first, entry.second});
+    eytzinger.assign(entries.size() + 1, K());
+    rankAt.assign(entries.size() + 1, 0);
+    fillEytzinger(0, 1);
+}
+
+template<typename K, typename V, typename Compare>
+bool FrozenIndex<K, V, Compare>::mapFile(const string& path) {
+    if constexpr (!is_arithmetic<K>::value || !is_arithmetic<V>::value) {
+        return false;  // entries are not stored as IndexRecords
+    } else {
+        auto file = make_shared<const MappedFile>(path);
+        const IndexFileHeader* header = indexFileHeader<K, V>(*file);
+        if (!header || header->count > UINT32_MAX)
+            return false;
+        // the header (32 bytes) keeps the records aligned in the page-aligned mapping
+        const Entry* records = reinterpret_cast<const Entry*>(file->data() + sizeof(IndexFileHeader));
+        for (size_t i = 1; i < header->count; ++i) {
+            if (!comparator(records[i - 1].key, records[i].key))
+                return false;
+        }
+        entries.clear();
+        entries.shrink_to_fit();
+        mappedCount = header->count;
+        mapping = std::move(file);
+        eytzinger.assign(mappedCount + 1, K());
+        rankAt.assign(mappedCount + 1, 0);
+        fillEytzinger(0, 1);
+        return true;
+    }
+}
+
+template<typename K, typename V, typename Compare>
+size_t FrozenIndex<K, V, Compare>::fillEytzinger(size_t next, size_t slot) {
+    // in-order walk of the implicit tree hands out the sorted entries in turn
+    if (slot <= size()) {
+        next = fillEytzinger(next, 2 * slot);
+        eytzinger[slot] = sorted()[next].key;
+        rankAt[slot] = (uint32_t)next++;
+        next = fillEytzinger(next, 2 * slot + 1);
+    }
+    return next;
+}
+
+template<typename K, typename V, typename Compare>
+size_t FrozenIndex<K, V, Compare>::boundRank(const K& key, bool upper) const {
+    const size_t n = size();
+    const K* keys = eytzinger.data();
+    size_t slot = 1;
+    while (slot <= n) {
+#if defined(__GNUC__)
+        if (slot * KEYS_PER_LINE <= n)
+            __builtin_prefetch(keys + slot * KEYS_PER_LINE);
+#endif
+        // go right past every key that belongs before the answer; no branch on the outcome
+        bool right = upper ? !comparator(key, keys[slot]) : comparator(keys[slot], key);
+        slot = 2 * slot + right;
+    }
+    // the answer is the last node where the descent went left: drop the trailing
+    // right turns (1 bits) and that left turn
+#if defined(__GNUC__)
+    slot >>= __builtin_ffsll(~(long long)slot);
+#else
+    while (slot & 1)
+        slot >>= 1;
+    slot >>= 1;
+#endif
+    return slot ? rankAt[slot] : n;
+}
+
+template<typename K, typename V, typename Compare>
+const V* FrozenIndex<K, V, Compare>::find(const K& key) const {
+    size_t rank = boundRank(key, false);
+    if (rank == size() || comparator(key, sorted()[rank].key))
+        return nullptr;
+    return &sorted()[rank].value;
+}
+
+template<typename K, typename V, typename Compare>
+template<typename Visitor>
+void FrozenIndex<K, V, Compare>::forEachInRange(const K& minKey, const K& maxKey, Visitor visit) const {
+    const Entry* all = sorted();
+    for (size_t i = boundRank(minKey, false); i < size() && !comparator(maxKey, all[i].key); ++i) {
+        if (!visit(all[i].key, all[i].value))
+            return;
+    }
+}
+
+template<typename K, typename V, typename Compare>
+vector<pair<K, V>> FrozenIndex<K, V, Compare>::findRange(const K& minKey, const K& maxKey) const {
+    vector<pair<K, V>> result;
+    forEachInRange(minKey, maxKey, [&](const K& key, const V& value) {
+        result.emplace_back(key, value);
+        return true;
+    });
+    return result;
+}
+
+template class FrozenIndex<int, string>;
+template class FrozenIndex<string, string>;
+template class FrozenIndex<int, int>;
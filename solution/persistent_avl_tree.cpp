@@ -0,0 +1,293 @@
+#include "../headers/persistent_avl_tree.h"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+using namespace std;
+
+template<typename K, typename V, typename Compare>
+AVLSnapshot<K, V, Compare>::Node::Node(K key, V value, NodePtr left, NodePtr right)
+    : key(std::move(key)), value(std::move(value)), left(std::move(left)), right(std::move(right)) {
+    height = 1 + std::max(heightOf(this->left.get()), heightOf(this->right.get()));
+    subtreeSize = 1 + sizeOf(this->left.get()) + sizeOf(this->right.get());
+}
+
+template<typename K, typename V, typename Compare>
+AVLSnapshot<K, V, Compare>::AVLSnapshot(NodePtr root, Compare comp)
+    : ComparatorBase<Compare>(std::move(comp)), root(std::move(root)) {
+}
+
+template<typename K, typename V, typename Compare>
+const V* AVLSnapshot<K, V, Compare>::find(const K& key) const {
+    const Node* node = root.get();
+    while (node) {
+        if (comparator(key, node->key))
+            node = node->left.get();
+        else if (comparator(node->key, key))
+            node = node->right.get();
+        else
+            return &node->value;
+    }
+    return nullptr;
+}
+
+template<typename K, typename V, typename Compare>
+vector<pair<K, V>> AVLSnapshot<K, V, Compare>::findRange(const K& minKey, const K& maxKey) const {
+    vector<pair<K, V>> result;
+    forEachInRange(minKey, maxKey, [&](const K& key, const V& value) {
+        result.emplace_back(key, value);
+        return true;
+    });
+    return result;
+}
+
+template<typename K, typename V, typename Compare>
+vector<pair<K, V>> AVLSnapshot<K, V, Compare>::inOrderTraversal() const {
+    vector<pair<K, V>> result;
+    result.reserve(size());
+    // explicit stack: a snapshot has no parent links to climb
+    vector<const Node*> stack;
+    const Node* node = root.get();
+    while (node || !stack.empty()) {
+        for (; node; node = node->left.get())
+            stack.push_back(node);
+        node = stack.back();
+        stack.pop_back();
+        result.emplace_back(node->key, node->value);
+        node = node->right.get();
+    }
+    return result;
+}
+
+template<typename K, typename V, typename Compare>
+template<typename Visitor>
+void AVLSnapshot<K, V, Compare>::forEachInRange(const K& minKey, const K& maxKey, Visitor visit) const {
+    rangeHelper(root.get(), minKey, maxKey, visit);
+}
+
+template<typename K, typename V, typename Compare>
+template<typename Visitor>
+bool AVLSnapshot<K, V, Compare>::rangeHelper(const Node* node, const K& minKey, const K& maxKey, Visitor& visit) const {
+    // false once the visitor asked to stop
+    if (!node)
+        return true;
+    bool aboveMin = comparator(minKey, node->key);
+    bool belowMax = comparator(node->key, maxKey);
+    if (aboveMin && !rangeHelper(node->left.get(), minKey, maxKey, visit))
+        return false;
+    if (!comparator(node->key, minKey) && !comparator(maxKey, node->key) && !visit(node->key, node->value))
+        return false;
+    if (belowMax)
+        return rangeHelper(node->right.get(), minKey, maxKey, visit);
+    return true;
+}
+
+template<typename K, typename V, typename Compare>
+size_t AVLSnapshot<K, V, Compare>::countLess(const K& key, bool inclusive) const {
+    size_t count = 0;
+    const Node* node = root.get();
+    while (node) {
+        bool goRight = inclusive ? !comparator(key, node->key) : comparator(node->key, key);
+        if (goRight) {
+            count += sizeOf(node->left.get()) + 1;
+            node = node->right.get();
+        } else {
+            node = node->left.get();
+        }
+    }
+    return count;
+}
+
+template<typename K, typename V, typename Compare>
+size_t AVLSnapshot<K, V, Compare>::rank(const K& key) const {
+    return countLess(key, false);
+}
+
+template<typename K, typename V, typename Compare>
+pair<K, V> AVLSnapshot<K, V, Compare>::select(size_t index) const {
+    if (index >= size())
+        throw std::out_of_range("select index is past the end of the snapshot");
+    const Node* node = root.get();
+    while (true) {
+        size_t leftSize = sizeOf(node->left.get());
+        if (index < leftSize) {
+            node = node->left.get();
+        } else if (index == leftSize) {
+            return make_pair(node->key, node->value);
+        } else {
+            index -= leftSize + 1;
+            node = node->right.get();
+        }
+    }
+}
+
+template<typename K, typename V, typename Compare>
+size_t AVLSnapshot<K, V, Compare>::countRange(const K& minKey, const K& maxKey) const {
+    if (comparator(maxKey, minKey))
+        return 0;
+    return countLess(maxKey, true) - countLess(minKey, false);
+}
+
+template<typename K, typename V, typename Compare>
+bool AVLSnapshot<K, V, Compare>::isValidAVL() const {
+    return isValidHelper(root.get(), nullptr, nullptr);
+}
+
+template<typename K, typename V, typename Compare>
+bool AVLSnapshot<K, V, Compare>::isValidHelper(const Node* node, const K* lower, const K* upper) const {
+    // every key must satisfy lower < key < upper
+    if (!node)
+        return true;
+    if ((lower && !comparator(*lower, node->key)) || (upper && !comparator(node->key, *upper)))
+        return false;
+    int leftHeight = heightOf(node->left.get()), rightHeight = heightOf(node->right.get());
+    if (node->height != 1 + std::max(leftHeight, rightHeight) || std::abs(leftHeight - rightHeight) > 1)
+        return false;
+    if (node->subtreeSize != 1 + sizeOf(node->left.get()) + sizeOf(node->right.get()))
+        return false;
+    return isValidHelper(node->left.get(), lower, &node->key) && isValidHelper(node->right.get(), &node->key, upper);
+}
+
+template<typename K, typename V, typename Compare>
+PersistentAVLTree<K, V, Compare>::PersistentAVLTree(Compare comp) : Snapshot(nullptr, std::move(comp)) {
+}
+
+template<typename K, typename V, typename Compare>
+typename PersistentAVLTree<K, V, Compare>::Snapshot PersistentAVLTree<K, V, Compare>::snapshot() const {
+    return Snapshot(std::atomic_load(&this->root), this->keyCompare());
+}
+
+template<typename K, typename V, typename Compare>
+void PersistentAVLTree<K, V, Compare>::publish(NodePtr newRoot) {
+    // readers load the root atomically, so they see either version, never a torn pointer
+    std::atomic_store(&this->root, std::move(newRoot));
+}
+
+template<typename K, typename V, typename Compare>
+bool PersistentAVLTree<K, V, Compare>::insert(const K& key, const V& value) {
+    bool inserted = false;
+    NodePtr newRoot = insertPath(this->root, key, value, false, inserted);
+    if (inserted)
+        publish(std::move(newRoot));
+    return inserted;
+}
+
+template<typename K, typename V, typename Compare>
+template<typename M>
+bool PersistentAVLTree<K, V, Compare>::insert_or_assign(const K& key, M&& value) {
+    bool inserted = false;
+    publish(insertPath(this->root, key, V(std::forward<M>(value)), true, inserted));
+    return inserted;
+}
+
+template<typename K, typename V, typename Compare>
+bool PersistentAVLTree<K, V, Compare>::remove(const K& key) {
+    bool removed = false;
+    NodePtr newRoot = removePath(this->root, key, removed);
+    if (removed)
+        publish(std::move(newRoot));
+    return removed;
+}
+
+template<typename K, typename V, typename Compare>
+void PersistentAVLTree<K, V, Compare>::clear() {
+    publish(nullptr);
+}
+
+template<typename K, typename V, typename Compare>
+typename PersistentAVLTree<K, V, Compare>::NodePtr PersistentAVLTree<K, V, Compare>::makeNode(const K& key, const V& value, NodePtr left, NodePtr right) {
+    return make_shared<const Node>(key, value, std::move(left), std::move(right));
+}
+
+template<typename K, typename V, typename Compare>
+typename PersistentAVLTree<K, V, Compare>::NodePtr PersistentAVLTree<K, V, Compare>::balance(const K& key, const V& value, NodePtr left, NodePtr right) {
+    // Builds the node (key, value, left, right), rotating if the two sides
+    // differ in height by two. Rotations allocate new nodes instead of relinking.
+    int leftHeight = Snapshot::heightOf(left.get()), rightHeight = Snapshot::heightOf(right.get());
+    if (leftHeight > rightHeight + 1) {
+        const Node* l = left.get();
+        if (Snapshot::heightOf(l->left.get()) >= Snapshot::heightOf(l->right.get()))
+            return makeNode(l->key, l->value, l->left, makeNode(key, value, l->right, std::move(right)));
+        const Node* lr = l->right.get();
+        return makeNode(lr->key, lr->value,
+                        makeNode(l->key, l->value, l->left, lr->left),
+                        makeNode(key, value, lr->right, std::move(right)));
+    }
+    if (rightHeight > leftHeight + 1) {
+        const Node* r = right.get();
+        if (Snapshot::heightOf(r->right.get()) >= Snapshot::heightOf(r->left.get()))
+            return makeNode(r->key, r->value, makeNode(key, value, std::move(left), r->left), r->right);
+        const Node* rl = r->left.get();
+        return makeNode(rl->key, rl->value,
+                        makeNode(key, value, std::move(left), rl->left),
+                        makeNode(r->key, r->value, rl->right, r->right));
+    }
+    return makeNode(key, value, std::move(left), std::move(right));
+}
+
+template<typename K, typename V, typename Compare>
+typename PersistentAVLTree<K, V, Compare>::NodePtr PersistentAVLTree<K, V, Compare>::insertPath(const NodePtr& node, const K& key, const V& value, bool assign, bool& inserted) {
+    if (!node) {
+        inserted = true;
+        return makeNode(key, value, nullptr, nullptr);
+    }
+    if (this->comparator(key, node->key)) {
+        NodePtr left = insertPath(node->left, key, value, assign, inserted);
+        if (left == node->left)
+            return node;
+        return balance(node->key, node->value, std::move(left), node->right);
+    }
+    if (this->comparator(node->key, key)) {
+        NodePtr right = insertPath(node->right, key, value, assign, inserted);
+        if (right == node->right)
+            return node;
+        return balance(node->key, node->value, node->left, std::move(right));
+    }
+    if (!assign)
+        return node;
+    return makeNode(node->key, value, node->left, node->right);
+}
+
+template<typename K, typename V, typename Compare>
+typename PersistentAVLTree<K, V, Compare>::NodePtr PersistentAVLTree<K, V, Compare>::removePath(const NodePtr& node, const K& key, bool& removed) {
+    if (!node)
+        return nullptr;
+    if (this->comparator(key, node->key)) {
+        NodePtr left = removePath(node->left, key, removed);
+        if (!removed)
+            return node;
+        return balance(node->key, node->value, std::move(left), node->right);
+    }
+    if (this->comparator(node->key, key)) {
+        NodePtr right = removePath(node->right, key, removed);
+        if (!removed)
+            return node;
+        return balance(node->key, node->value, node->left, std::move(right));
+    }
+    removed = true;
+    if (!node->left)
+        return node->right;
+    if (!node->right)
+        return node->left;
+    // the in-order successor takes this node's place
+    const Node* successor = nullptr;
+    NodePtr right = removeMinPath(node->right, successor);
+    return balance(successor->key, successor->value, node->left, std::move(right));
+}
+
+template<typename K, typename V, typename Compare>
+typename PersistentAVLTree<K, V, Compare>::NodePtr PersistentAVLTree<K, V, Compare>::removeMinPath(const NodePtr& node, const Node*& minNode) {
+    // minNode stays alive through the old version, which the caller still holds
+    if (!node->left) {
+        minNode = node.get();
+        return node->right;
+    }
+    NodePtr left = removeMinPath(node->left, minNode);
+    return balance(node->key, node->value, std::move(left), node->right);
+}
+
+template class AVLSnapshot<int, string>;
+template class AVLSnapshot<string, string>;
+template class AVLSnapshot<int, int>;
+template class PersistentAVLTree<int, string>;
+template class PersistentAVLTree<string, string>;
+template class PersistentAVLTree<int, int>;
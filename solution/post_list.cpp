@@ -15,6 +15,7 @@ void PostList::addPost(const Post& p) {
     PostNode* newNode = new PostNode(newPost);
     newNode->next = head;
     head = newNode;
+    count++;
 }
 
 bool PostList::removePost(int postID) {
@@ -30,6 +31,7 @@ bool PostList::removePost(int postID) {
             }
             delete current->post;  // Free the Post object
             delete current;        // Free the PostNode
+            count--;
             return true;
         }
         prev = current;
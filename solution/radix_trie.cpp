@@ -0,0 +1,344 @@
+#include "../headers/radix_trie.h"
+#include <algorithm>
+using namespace std;
+
+template<typename V>
+unique_ptr<typename RadixTrie<V>::Node>* RadixTrie<V>::Node::slot(unsigned char byte) {
+    if (wide)
+        return (*wide)[byte] ? &(*wide)[byte] : nullptr;
+    for (size_t i = 0; i < fanout; ++i) {
+        if (bytes[i] == byte)
+            return &small[i];
+    }
+    return nullptr;
+}
+
+template<typename V>
+typename RadixTrie<V>::Node* RadixTrie<V>::Node::child(unsigned char byte) const {
+    if (wide)
+        return (*wide)[byte].get();
+    for (size_t i = 0; i < fanout; ++i) {
+        if (bytes[i] == byte)
+            return small[i].get();
+    }
+    return nullptr;
+}
+
+template<typename V>
+void RadixTrie<V>::Node::addChild(unique_ptr<Node> node) {
+    unsigned char byte = node->label[0];
+    if (wide) {
+        (*wide)[byte] = std::move(node);
+        fanout++;
+        return;
+    }
+    if (fanout == SMALL_FANOUT) { //grow into the table form
+        wide = make_unique<array<unique_ptr<Node>, 256>>();
+        for (size_t i = 0; i < fanout; ++i)
+            (*wide)[bytes[i]] = std::move(small[i]);
+        small.clear();
+        small.shrink_to_fit();
+        (*wide)[byte] = std::move(node);
+        fanout++;
+        return;
+    }
+    size_t i = lower_bound(bytes, bytes + fanout, byte) - bytes;
+    copy_backward(bytes + i, bytes + fanout, bytes + fanout + 1);
+    bytes[i] = byte;
+    small.insert(small.begin() + i, std::move(node));
+    fanout++;
+}
+
+template<typename V>
+unique_ptr<typename RadixTrie<V>::Node> RadixTrie<V>::Node::takeChild(unsigned char byte) {
+    unique_ptr<Node> taken;
+    if (wide) {
+        taken = std::move((*wide)[byte]);
+        if (taken)
+            fanout--;
+        if (fanout <= SMALL_FANOUT / 2) { //shrink back; the gap avoids flapping at the boundary
+            for (size_t b = 0; b < 256; ++b) {
+                if ((*wide)[b]) {
+                    bytes[small.size()] = (unsigned char)b;
+                    small.push_back(std::move((*wide)[b]));
+                }
+            }
+            wide.reset();
+        }
+        return taken;
+    }
+    for (size_t i = 0; i < fanout; ++i) {
+        if (bytes[i] == byte) {
+            taken = std::move(small[i]);
+            copy(bytes + i + 1, bytes + fanout, bytes + i);
+            small.erase(small.begin() + i);
+            fanout--;
+            break;
+        }
+    }
+    return taken;
+}
+
+template<typename V>
+template<typename Visit>
+void RadixTrie<V>::Node::forEachChild(Visit visit) const {
+    if (wide) {
+        for (const unique_ptr<Node>& node : *wide) {
+            if (node && !visit(node.get()))
+                return;
+        }
+        return;
+    }
+    for (const unique_ptr<Node>& node : small) {
+        if (!visit(node.get()))
+            return;
+    }
+}
+
+template<typename V>
+RadixTrie<V>::RadixTrie() : root(make_unique<Node>(string_view())), nodes(1) {
+}
+
+template<typename V>
+void RadixTrie<V>::clear() {
+    root = make_unique<Node>(string_view());
+    nodes = 1;
+}
+
+template<typename V>
+const typename RadixTrie<V>::Node* RadixTrie<V>::findNode(string_view key) const {
+    const Node* node = root.get();
+    size_t pos = 0;
+    while (pos < key.size()) {
+        node = node->child(key[pos]);
+        if (!node || key.compare(pos, node->label.size(), node->label) != 0)
+            return nullptr;
+        pos += node->label.size();
+    }
+    return node;
+}
+
+template<typename V>
+const typename RadixTrie<V>::Node* RadixTrie<V>::prefixNode(string_view prefix) const {
+    // like findNode, except the prefix may end partway along an edge
+    const Node* node = root.get();
+    size_t pos = 0;
+    while (pos < prefix.size()) {
+        node = node->child(prefix[pos]);
+        if (!node)
+            return nullptr;
+        size_t length = std::min(node->label.size(), prefix.size() - pos);
+        if (prefix.compare(pos, length, string_view(node->label).substr(0, length)) != 0)
+            return nullptr;
+        pos += length;
+    }
+    return node;
+}
+
+template<typename V>
+const V* RadixTrie<V>::find(string_view key) const {
+    const Node* node = findNode(key);
+    return node && node->terminal ? &node->value : nullptr;
+}
+
+template<typename V>
+V* RadixTrie<V>::find(string_view key) {
+    return const_cast<V*>(static_cast<const RadixTrie&>(*this).find(key));
+}
+
+template<typename V>
+bool RadixTrie<V>::insert(string_view key, const V& value) {
+    if (find(key))
+        return false;
+    // the key is new, so every node on its path gains one
+    Node* node = root.get();
+    node->count++;
+    size_t pos = 0;
+    while (pos < key.size()) {
+        Node* next = node->child(key[pos]);
+        if (!next) { //no edge starts with this byte: hang the rest of the key off node
+            auto leaf = make_unique<Node>(key.substr(pos));
+            leaf->terminal = true;
+            leaf->value = value;
+            leaf->count = 1;
+            node->addChild(std::move(leaf));
+            nodes++;
+            return true;
+        }
+        string_view rest = key.substr(pos);
+        size_t common = mismatch(next->label.begin(), next->label.begin() + std::min(next->label.size(), rest.size()), rest.begin()).first -
+                        next->label.begin();
+        if (common == next->label.size()) { //whole edge matches, keep descending
+            next->count++;
+            node = next;
+            pos += common;
+            continue;
+        }
+        // the key leaves this edge partway: split it at the divergence
+        auto middle = make_unique<Node>(rest.substr(0, common));
+        middle->count = next->count + 1;
+        unique_ptr<Node>& link = *node->slot(key[pos]);
+        unique_ptr<Node> lower = std::move(link);
+        lower->label.erase(0, common);
+        middle->addChild(std::move(lower));
+        nodes++;
+        if (common == rest.size()) {
+            middle->terminal = true;
+            middle->value = value;
+        } else {
+            auto leaf = make_unique<Node>(rest.substr(common));
+            leaf->terminal = true;
+            leaf->value = value;
+            leaf->count = 1;
+            middle->addChild(std::move(leaf));
+            nodes++;
+        }
+        link = std::move(middle);
+        return true;
+    }
+    // key ends exactly at an existing branch point
+    node->terminal = true;
+    node->value = value;
+    return true;
+}
+
+template<typename V>
+bool RadixTrie<V>::remove(string_view key) {
+    if (!find(key))
+        return false;
+    vector<Node*> path = {root.get()};
+    for (size_t pos = 0; pos < key.size(); pos += path.back()->label.size())
+        path.push_back(path.back()->child(key[pos]));
+    for (Node* node : path)
+        node->count--;
+    Node* node = path.back();
+    node->terminal = false;
+    node->value = V();
+    if (path.size() == 1) //the empty key lives in the root, which always stays
+        return true;
+
+    Node* parent = path[path.size() - 2];
+    if (node->fanout == 0) {
+        parent->takeChild(node->label[0]);
+        nodes--;
+        // the parent may now be a keyless pass-through with one child
+        if (path.size() > 2 && !parent->terminal && parent->fanout == 1)
+            mergeWithChild(path[path.size() - 3], parent);
+    } else if (node->fanout == 1) {
+        mergeWithChild(parent, node);
+    }
+    return true;
+}
+
+template<typename V>
+void RadixTrie<V>::mergeWithChild(Node* parent, Node* node) {
+    unsigned char onlyByte = 0;
+    node->forEachChild([&](const Node* only) {
+        onlyByte = only->label[0];
+        return false;
+    });
+    unique_ptr<Node> child = node->takeChild(onlyByte);
+    child->label.insert(0, node->label);
+    *parent->slot(node->label[0]) = std::move(child);  // frees node
+    nodes--;
+}
+
+template<typename V>
+size_t RadixTrie<V>::countWithPrefix(string_view prefix) const {
+    const Node* node = prefixNode(prefix);
+    return node ? node->count : 0;
+}
+
+template<typename V>
+vector<V> RadixTrie<V>::withPrefix(string_view prefix, size_t offset, size_t limit) const {
+    vector<V> result;
+    const Node* node = prefixNode(prefix);
+    if (!node || offset >= node->count || limit == 0)
+        return result;
+    result.reserve(std::min(limit, node->count - offset));
+    collect(node, offset, limit, result);
+    return result;
+}
+
+template<typename V>
+void RadixTrie<V>::collect(const Node* node, size_t& skip, size_t& limit, vector<V>& result) const {
+    // a subtree that lies wholly before the offset is passed over by its count
+    if (skip >= node->count) {
+        skip -= node->count;
+        return;
+    }
+    if (node->terminal) {
+        if (skip > 0) {
+            skip--;
+        } else {
+            result.push_back(node->value);
+            limit--;
+        }
+    }
+    node->forEachChild([&](const Node* child) {
+        if (limit == 0)
+            return false;
+        collect(child, skip, limit, result);
+        return true;
+    });
+}
+
+template<typename V>
+template<typename Visitor>
+void RadixTrie<V>::forEachWithPrefix(string_view prefix, Visitor visit) const {
+    if (const Node* node = prefixNode(prefix))
+        visitSubtree(node, visit);
+}
+
+template<typename V>
+template<typename Visitor>
+bool RadixTrie<V>::visitSubtree(const Node* node, Visitor& visit) const {
+    if (node->terminal && !visit(node->value))
+        return false;
+    bool going = true;
+    node->forEachChild([&](const Node* child) {
+        going = visitSubtree(child, visit);
+        return going;
+    });
+    return going;
+}
+
+template<typename V>
+bool RadixTrie<V>::isValid() const {
+    bool ok = true;
+    size_t counted = validNode(root.get(), true, ok);
+    return ok && counted == nodes;
+}
+
+template<typename V>
+size_t RadixTrie<V>::validNode(const Node* node, bool isRoot, bool& ok) const {
+    // only the root may have an empty label or be a keyless node with one child;
+    // the small form stays sorted, the table form only holds large fanouts
+    if (isRoot != node->label.empty() || (!isRoot && !node->terminal && node->fanout < 2))
+        ok = false;
+    if (node->wide ? node->fanout <= SMALL_FANOUT / 2 || !node->small.empty() : node->fanout > SMALL_FANOUT)
+        ok = false;
+    if (!node->wide && (node->small.size() != node->fanout || !is_sorted(node->bytes, node->bytes + node->fanout) ||
+                        adjacent_find(node->bytes, node->bytes + node->fanout) != node->bytes + node->fanout))
+        ok = false;
+    size_t count = node->terminal ? 1 : 0;
+    size_t below = 1;
+    size_t children = 0;
+    int lastByte = -1;
+    node->forEachChild([&](const Node* child) {
+        unsigned char byte = child->label.empty() ? 0 : child->label[0];
+        if (child->label.empty() || (int)byte <= lastByte || node->child(byte) != child)
+            ok = false;
+        lastByte = byte;
+        children++;
+        count += child->count;
+        below += validNode(child, false, ok);
+        return ok;
+    });
+    if (children != node->fanout || count != node->count)
+        ok = false;
+    return below;
+}
+
+template class RadixTrie<int>;
+template class RadixTrie<string>;
@@ -0,0 +1,319 @@
+#include "../headers/rb_tree.h"
+#include <algorithm>
+using namespace std;
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+RBTree<K, V, Compare, Storage, Augment>::RBTree() : BST<K, V, Compare, Storage, Augment>() {
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+RBTree<K, V, Compare, Storage, Augment>::RBTree(Compare comp) : BST<K, V, Compare, Storage, Augment>(std::move(comp)) {
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+bool RBTree<K, V, Compare, Storage, Augment>::insert(const K& key, const V& value) {
+    return insertWith(key,
+        [&]() { return this->createNode(key, value); },
+        [](NodePtr) {});
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+bool RBTree<K, V, Compare, Storage, Augment>::insert(K&& key, V&& value) {
+    // key is only read during the descent; it is moved into the leaf at the end
+    return insertWith(key,
+        [&]() { return this->createNode(std::move(key), std::move(value)); },
+        [](NodePtr) {});
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename M>
+bool RBTree<K, V, Compare, Storage, Augment>::insert_or_assign(const K& key, M&& value) {
+    return insertWith(key,
+        [&]() { return this->createNode(key, std::forward<M>(value)); },
+        [&](NodePtr node) { node->value = std::forward<M>(value); this->valueChanged(node); });
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename M>
+bool RBTree<K, V, Compare, Storage, Augment>::insert_or_assign(K&& key, M&& value) {
+    return insertWith(key,
+        [&]() { return this->createNode(std::move(key), std::forward<M>(value)); },
+        [&](NodePtr node) { node->value = std::forward<M>(value); this->valueChanged(node); });
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename... Args>
+bool RBTree<K, V, Compare, Storage, Augment>::try_emplace(const K& key, Args&&... args) {
+    return insertWith(key,
+        [&]() { return this->createNode(key, V(std::forward<Args>(args)...)); },
+        [](NodePtr) {});
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename... Args>
+bool RBTree<K, V, Compare, Storage, Augment>::try_emplace(K&& key, Args&&... args) {
+    return insertWith(key,
+        [&]() { return this->createNode(std::move(key), V(std::forward<Args>(args)...)); },
+        [](NodePtr) {});
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+template<typename MakeNode, typename OnExisting>
+bool RBTree<K, V, Compare, Storage, Augment>::insertWith(const K& key, MakeNode makeNode, OnExisting onExisting) {
+    NodePtr* link = &this->root;
+    NodePtr* parentLink = nullptr;
+    while (*link) {
+        BSTNode* current = this->rawNode(*link);
+        if (this->comparator(key, current->key)) { //key<node.key -- go left
+            parentLink = link;
+            link = &current->left;
+        } else if (this->comparator(current->key, key)) { //key>node.key -- go right
+            parentLink = link;
+            link = &current->right;
+        } else { //already present, nothing changes shape
+            onExisting(*link);
+            return false;
+        }
+    }
+    NodePtr node = makeNode();
+    node->red = true;
+    *link = node;
+    if (parentLink) {
+        node->parent = ParentPtr(*parentLink);
+        // sizes and summaries first: rotations keep a subtree's contents, so
+        // afterwards only heights above the last rotation need redoing
+        this->refreshPath(*parentLink, this->root);
+    }
+    this->nodeCount++;
+    NodePtr rotated = insertFixup(node);
+    if (rotated)
+        this->refreshPath(parentOf(rotated), this->root);
+    this->root->red = false;
+    return true;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename RBTree<K, V, Compare, Storage, Augment>::NodePtr RBTree<K, V, Compare, Storage, Augment>::insertFixup(NodePtr node) {
+    // node is red; while its parent is red too (so not the root), either
+    // recolor and move the conflict two levels up, or rotate once or twice and stop
+    for (NodePtr parent = parentOf(node); isRed(parent); parent = parentOf(node)) {
+        NodePtr grand = parentOf(parent);
+        bool parentIsLeft = this->rawNode(grand->left) == this->rawNode(parent);
+        NodePtr uncle = parentIsLeft ? grand->right : grand->left;
+        if (isRed(uncle)) {
+            parent->red = false;
+            uncle->red = false;
+            grand->red = true;
+            node = grand;
+            continue;
+        }
+        if (parentIsLeft) {
+            if (this->rawNode(parent->right) == this->rawNode(node)) { //LR: turn into LL first
+                rotateLeft(parent);
+                parent = node;
+            }
+            rotateRight(grand);
+        } else {
+            if (this->rawNode(parent->left) == this->rawNode(node)) { //RL: turn into RR first
+                rotateRight(parent);
+                parent = node;
+            }
+            rotateLeft(grand);
+        }
+        parent->red = false;
+        grand->red = true;
+        return parent;
+    }
+    return nullptr;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+bool RBTree<K, V, Compare, Storage, Augment>::remove(const K& key) {
+    NodePtr* link = &this->root;
+    while (*link) {
+        BSTNode* current = this->rawNode(*link);
+        if (this->comparator(current->key, key)) //node.key is less than key to find. move right
+            link = &current->right;
+        else if (this->comparator(key, current->key)) //key<node.key
+            link = &current->left;
+        else
+            break;
+    }
+    if (!*link)
+        return false;
+
+    if ((*link)->left && (*link)->right) {
+        //both children exist: the NGE has no left child, so move its entry up and unlink it instead
+        BSTNode* target = this->rawNode(*link);
+        link = &target->right;
+        while ((*link)->left)
+            link = &(*link)->left;
+        target->key = std::move((*link)->key);
+        target->value = std::move((*link)->value);
+    }
+    NodePtr removed = *link;
+    NodePtr child = removed->left ? removed->left : removed->right;
+    NodePtr parent = parentOf(removed);
+    bool removedBlack = !removed->red;
+    *link = child;
+    if (child)
+        child->parent = removed->parent;
+    this->destroyNode(std::move(removed));
+    this->nodeCount--;
+
+    this->refreshPath(parent, this->root);
+    if (removedBlack) {
+        NodePtr rotated = removeFixup(child, parent);
+        if (rotated)
+            this->refreshPath(parentOf(rotated), this->root);
+    }
+    if (this->root)
+        this->root->red = false;
+    return true;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename RBTree<K, V, Compare, Storage, Augment>::NodePtr RBTree<K, V, Compare, Storage, Augment>::removeFixup(NodePtr node, NodePtr parent) {
+    // paths through node are one black short. A red node just turns black;
+    // otherwise borrow from the sibling's side (rotations, then stop) or, when
+    // the sibling has no red child, make it red and move the shortfall up.
+    NodePtr rotated = nullptr;
+    while (this->rawNode(node) != this->rawNode(this->root) && !isRed(node)) {
+        // the sibling exists: its side holds at least one more black node
+        bool nodeIsLeft = this->rawNode(parent->left) == this->rawNode(node);
+        NodePtr sibling = nodeIsLeft ? parent->right : parent->left;
+        if (isRed(sibling)) { //make the sibling black, parent stays above node
+            sibling->red = false;
+            parent->red = true;
+            if (nodeIsLeft)
+                rotateLeft(parent);
+            else
+                rotateRight(parent);
+            rotated = sibling;
+            sibling = nodeIsLeft ? parent->right : parent->left;
+        }
+        if (!isRed(sibling->left) && !isRed(sibling->right)) {
+            sibling->red = true;
+            node = parent;
+            parent = parentOf(node);
+            continue;
+        }
+        if (nodeIsLeft) {
+            if (!isRed(sibling->right)) { //near nephew is the red one: rotate it outward
+                sibling->left->red = false;
+                sibling->red = true;
+                rotateRight(sibling);
+                sibling = parent->right;
+            }
+            sibling->red = parent->red;
+            parent->red = false;
+            sibling->right->red = false;
+            rotateLeft(parent);
+        } else {
+            if (!isRed(sibling->left)) {
+                sibling->right->red = false;
+                sibling->red = true;
+                rotateLeft(sibling);
+                sibling = parent->left;
+            }
+            sibling->red = parent->red;
+            parent->red = false;
+            sibling->left->red = false;
+            rotateRight(parent);
+        }
+        return sibling;
+    }
+    if (node)
+        node->red = false;
+    return rotated;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename RBTree<K, V, Compare, Storage, Augment>::NodePtr RBTree<K, V, Compare, Storage, Augment>::parentOf(const NodePtr& node) {
+    return Storage::template Pool<BSTNode>::parentOf(BST<K, V, Compare, Storage, Augment>::rawNode(node));
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+typename RBTree<K, V, Compare, Storage, Augment>::NodePtr& RBTree<K, V, Compare, Storage, Augment>::linkTo(const NodePtr& node) {
+    BSTNode* parent = this->parentNode(this->rawNode(node));
+    if (!parent)
+        return this->root;
+    return this->rawNode(parent->left) == this->rawNode(node) ? parent->left : parent->right;
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+void RBTree<K, V, Compare, Storage, Augment>::rotateLeft(NodePtr node) {
+    NodePtr child = node->right;
+    NodePtr& link = linkTo(node);
+    node->right = child->left;
+    if (node->right)
+        node->right->parent = node;
+    child->parent = node->parent;
+    link = child;
+    child->left = node;
+    node->parent = child;
+    this->updateHeight(node);
+    this->updateHeight(child);
+    this->statsRotation();
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+void RBTree<K, V, Compare, Storage, Augment>::rotateRight(NodePtr node) {
+    NodePtr child = node->left;
+    NodePtr& link = linkTo(node);
+    node->left = child->right;
+    if (node->left)
+        node->left->parent = node;
+    child->parent = node->parent;
+    link = child;
+    child->right = node;
+    node->parent = child;
+    this->updateHeight(node);
+    this->updateHeight(child);
+    this->statsRotation();
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+int RBTree<K, V, Compare, Storage, Augment>::blackHeight(NodePtr node) const {
+    // stored height/size must match the children, every child points back at
+    // its parent, no red node has a red child, and both sides count the same blacks
+    if (!node)
+        return 1;
+    for (const NodePtr& child : {node->left, node->right}) {
+        if (child && this->parentNode(this->rawNode(child)) != this->rawNode(node))
+            return -1;
+        if (node->red && isRed(child))
+            return -1;
+    }
+    int left = blackHeight(node->left);
+    int right = blackHeight(node->right);
+    if (left < 0 || left != right)
+        return -1;
+    if (node->height != 1 + std::max(this->getHeight(node->left), this->getHeight(node->right)))
+        return -1;
+    if (node->subtreeSize != 1 + this->getSize(node->left) + this->getSize(node->right))
+        return -1;
+    return left + (node->red ? 0 : 1);
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+bool RBTree<K, V, Compare, Storage, Augment>::isValidRB() const {
+    if (this->root && (this->root->red || this->parentNode(this->rawNode(this->root))))
+        return false;
+    if (this->getSize(this->root) != this->nodeCount || blackHeight(this->root) < 0)
+        return false;
+    //keys must come out of the in-order walk strictly ascending
+    auto it = this->begin();
+    if (it == this->end())
+        return true;
+    for (auto prev = it++; it != this->end(); prev = it++) {
+        if (!this->comparator(prev->key, it->key))
+            return false;
+    }
+    return true;
+}
+
+template class RBTree<int, string>;
+template class RBTree<string, string>;
+template class RBTree<int, int>;
+template class RBTree<int, int, less<int>, ArenaNodeStorage>;
@@ -1,55 +1,638 @@
 #include "../headers/user_search_engine.h"
 #include "../headers/user_manager.h"
 #include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 using namespace std;
 
-UserSearchEngine::UserSearchEngine() 
-    : usersByID([](const int& a, const int& b) { return a < b; }),
-      usersByName([](const string& a, const string& b) { return a < b; }) {
+namespace {
+// Bytes a std::string copy of name costs: the object, plus a heap block once
+// the name outgrows the small-string buffer (allocator overhead not counted)
+size_t stringCopyBytes(const string& name) {
+    static const size_t inlineCapacity = string().capacity();
+    return sizeof(string) + (name.size() > inlineCapacity ? name.size() + 1 : 0);
+}
+
+// How usersByName turns usernames into keys, per NameKey type: a string copy
+// in every node, or an InternedString whose bytes live in the engine's arena.
+template<typename Key>
+struct NameKeys;
+
+template<>
+struct NameKeys<string> {
+    static less<string> compare(const StringArena&) { return {}; }
+    static string make(StringArena&, const string& name) { return name; }
+    static void release(StringArena&, const string&) {}
+    static const string& text(const StringArena&, const string& key) { return key; }
+    static bool equals(const StringArena&, const string& key, const string& name) { return key == name; }
+    template<typename Index>
+    static bool insert(Index& index, StringArena&, const string& name, User* user) {
+        return index.try_emplace(name, user);  // the name is copied once, into its node
+    }
+    template<typename Index>
+    static bool erase(Index& index, StringArena&, const string& name) { return index.remove(name); }
+    template<typename Index>
+    static string stored(const Index&, const string& name) { return name; }
+    template<typename Index>
+    static size_t footprint(const Index& index, const StringArena&) {
+        size_t total = 0;
+        for (const auto& entry : index)
+            total += stringCopyBytes(entry.key);
+        return total;
+    }
+};
+
+template<>
+struct NameKeys<InternedString> {
+    static InternedStringCompare compare(const StringArena& arena) { return {&arena}; }
+    static InternedString make(StringArena& arena, const string& name) { return arena.intern(name); }
+    static void release(StringArena& arena, InternedString key) { arena.release(key); }
+    static string text(const StringArena& arena, InternedString key) { return arena.str(key); }
+    static bool equals(const StringArena& arena, InternedString key, const string& name) {
+        return arena.compare(key, name) == 0;
+    }
+    template<typename Index>
+    static bool insert(Index& index, StringArena& arena, const string& name, User* user) {
+        InternedString key = arena.intern(name);
+        if (index.try_emplace(key, user))
+            return true;
+        arena.release(key);
+        return false;
+    }
+    template<typename Index>
+    static bool erase(Index& index, StringArena& arena, string_view name) {
+        auto it = index.lower_bound(name);
+        if (it == index.end() || arena.compare(it->key, name) != 0)
+            return false;
+        InternedString key = it->key;
+        index.remove(key);
+        arena.release(key);
+        return true;
+    }
+    // the handle usersByName holds for a name known to be indexed
+    template<typename Index>
+    static InternedString stored(const Index& index, const string& name) { return index.lower_bound(name)->key; }
+    template<typename Index>
+    static size_t footprint(const Index& index, const StringArena& arena) {
+        return index.size() * sizeof(InternedString) + arena.memoryUsage();
+    }
+};
+
+using Names = NameKeys<NameKey>;
+
+// One line of shape and search-cost figures for an index. The counters
+// behind the bracketed part are only kept in -DTREE_STATS builds.
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+void printIndexStats(const char* label, const AVLTree<K, V, Compare, Storage, Augment>& index) {
+    cout << label << ": height " << index.getTreeHeight() << ", average depth " << index.getAverageDepth();
+    if constexpr (treeStatsEnabled) {
+        const TreeStats& stats = index.getStats();
+        cout << ", " << stats.rotations << " rotations (" << stats.singleRotations << " single, " << stats.doubleRotations << " double, "
+             << stats.rebalanceCalls << " rebalance calls), " << stats.comparisonsPerOperation()
+             << " comparisons/op, max descent " << stats.maxDescentDepth;
+    }
+    cout << endl;
+}
+
+template<typename K, typename V, typename Compare>
+void printIndexStats(const char* label, const BPlusTree<K, V, Compare>& index) {
+    cout << label << ": height " << index.getTreeHeight() << endl;
+}
+
+// Whole-index walks for isConsistent: AVL indexes split across the pool,
+// B+ indexes (no parallel forms) run on the calling thread
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+bool indexIsValid(const AVLTree<K, V, Compare, Storage, Augment>& index, ThreadPool& threads) {
+    return index.isValidAVL(threads);
+}
+
+template<typename K, typename V, typename Compare>
+bool indexIsValid(const BPlusTree<K, V, Compare>& index, ThreadPool&) {
+    return index.isValid();
+}
+
+template<typename K, typename V, typename Compare, typename Storage, typename Augment>
+vector<pair<K, V>> indexEntries(const AVLTree<K, V, Compare, Storage, Augment>& index, ThreadPool& threads) {
+    return index.inOrderTraversal(threads);
+}
+
+template<typename K, typename V, typename Compare>
+vector<pair<K, V>> indexEntries(const BPlusTree<K, V, Compare>& index, ThreadPool&) {
+    return index.inOrderTraversal();
+}
+
+// Appends the users with IDs in [minID, maxID], seeking from wherever cursor was left
+template<typename Index, typename Cursor>
+void collectIDRange(const Index& index, Cursor& cursor, int minID, int maxID, vector<User*>& results) {
+    for (auto it = cursor.seekLowerBound(minID); it != index.end() && it->key <= maxID; ++it)
+        results.push_back(it->value);
+}
+}
+
+UserSearchEngine::UserSearchEngine() : usersByName(Names::compare(nameArena)), idIndexFrozen(false) {
 }
 
 UserSearchEngine::~UserSearchEngine() {
 }
 
 void UserSearchEngine::migrateFromLinkedList(const LinkedList<User>& userList) {
+    vector<User*> users;
+    for (auto node = userList.head(); node; node = node->next)
+        users.push_back(&node->data);
+    addUsers(users);
+}
+
+vector<bool> UserSearchEngine::addUsers(const vector<User*>& users) {
+    // Accept users in batch order; a user whose ID or name is already taken
+    // (by the engine or an earlier batch entry) is skipped, as addUser would.
+    vector<bool> added(users.size(), false);
+    vector<pair<int, User*>> newByID;
+    vector<pair<NameKey, User*>> newByName;
+    unordered_set<int> seenIDs;
+    unordered_set<string_view> seenNames;
+    auto idCursor = usersByID.cursor();  // imports tend to arrive in ID order
+    for (size_t i = 0; i < users.size(); ++i) {
+        User* user = users[i];
+        if (!user || seenIDs.count(user->userID) || seenNames.count(user->userName))
+            continue;
+        if (idCursor.seek(user->userID) || usersByName.find(user->userName))
+            continue;
+        seenIDs.insert(user->userID);
+        seenNames.insert(user->userName);
+        newByID.emplace_back(user->userID, user);
+        newByName.emplace_back(Names::make(nameArena, user->userName), user);
+        added[i] = true;
+    }
+    if (newByID.empty())
+        return added;
+
+    // every entry is known to be new, so each batch applies in full
+    usersByID.insertBatch(newByID);
+    usersByName.insertBatch(std::move(newByName));
+    for (const auto& entry : newByID) {
+        namesTrie.insert(entry.second->userName, entry.second);
+        namesFuzzy.insert(entry.second->userName, entry.second);
+        namesTrigrams.insert(entry.first, entry.second->userName);
+    }
+    if (idIndexFrozen && newByID.size() > frozenByID.size() / 8) {
+        freezeIDIndex();  // the delta would outgrow the snapshot anyway
+    } else {
+        for (const auto& entry : newByID)
+            recordIDChange(entry.first, entry.second);
+    }
+    return added;
+}
+
+vector<bool> UserSearchEngine::removeUsers(const vector<int>& userIDs) {
+    vector<User*> found = searchByIDs(userIDs);
+    vector<bool> removed = usersByID.removeBatch(userIDs);
+    vector<NameKey> names;
+    for (size_t i = 0; i < userIDs.size(); ++i) {
+        if (removed[i]) {
+            names.push_back(Names::stored(usersByName, found[i]->userName));
+            namesTrie.remove(found[i]->userName);
+            namesFuzzy.remove(found[i]->userName);
+            namesTrigrams.remove(userIDs[i], found[i]->userName);
+        }
+    }
+    size_t removedCount = names.size();
+    for (const NameKey& name : names)
+        Names::release(nameArena, name);  // only counts bytes, the keys stay readable
+    usersByName.removeBatch(std::move(names));
+    compactNameKeys();
+    if (idIndexFrozen && removedCount > frozenByID.size() / 8) {
+        freezeIDIndex();
+    } else {
+        for (size_t i = 0; i < userIDs.size(); ++i) {
+            if (removed[i])
+                recordIDChange(userIDs[i], nullptr);
+        }
+    }
+    return removed;
 }
 
 bool UserSearchEngine::addUser(User* user) {
+    if (!user)
+        return false;
+    // try_emplace reports a duplicate from the same descent that would insert
+    if (!usersByID.try_emplace(user->userID, user))
+        return false;
+    if (!Names::insert(usersByName, nameArena, user->userName, user)) {
+        usersByID.remove(user->userID);
+        return false;
+    }
+    namesTrie.insert(user->userName, user);
+    namesFuzzy.insert(user->userName, user);
+    namesTrigrams.insert(user->userID, user->userName);
+    recordIDChange(user->userID, user);
+    return true;
 }
 
 bool UserSearchEngine::removeUser(int userID) {
+    User* const* found = usersByID.find(userID);
+    if (!found)
+        return false;
+    User* user = *found;
+    Names::erase(usersByName, nameArena, user->userName);
+    namesTrie.remove(user->userName);
+    namesFuzzy.remove(user->userName);
+    namesTrigrams.remove(userID, user->userName);
+    usersByID.remove(userID);
+    recordIDChange(userID, nullptr);
+    compactNameKeys();
+    return true;
 }
 
 bool UserSearchEngine::removeUser(const string& username) {
+    User* const* found = usersByName.find(username);
+    if (!found)
+        return false;
+    User* user = *found;
+    int userID = user->userID;
+    usersByID.remove(userID);
+    Names::erase(usersByName, nameArena, username);
+    namesTrie.remove(username);
+    namesFuzzy.remove(username);
+    namesTrigrams.remove(userID, username);
+    recordIDChange(userID, nullptr);
+    compactNameKeys();
+    return true;
 }
 
 User* UserSearchEngine::searchByID(int userID) const {
+    if (idIndexFrozen) {
+        // the delta holds everything newer than the snapshot, so it wins
+        if (User* const* added = idDelta.find(userID))
+            return *added;
+        if (idTombstones.count(userID))
+            return nullptr;
+        User* const* frozen = frozenByID.find(userID);
+        return frozen ? *frozen : nullptr;
+    }
+    User* const* found = usersByID.find(userID);
+    return found ? *found : nullptr;
 }
 
-User* UserSearchEngine::searchByUsername(const std::string& username) const {
+User* UserSearchEngine::searchByUsername(string_view username) const {
+    User* const* found = usersByName.find(username);
+    return found ? *found : nullptr;
 }
 
-std::vector<User*> UserSearchEngine::searchByUsernamePrefix(const string& prefix) const {
+std::vector<User*> UserSearchEngine::searchByUsernamePrefix(string_view prefix) const {
+    return namesTrie.withPrefix(prefix);
+}
+
+vector<User*> UserSearchEngine::getUsernameCompletions(string_view prefix, size_t limit, size_t offset) const {
+    return namesTrie.withPrefix(prefix, offset, limit);
+}
+
+size_t UserSearchEngine::countUsersWithPrefix(string_view prefix) const {
+    return namesTrie.countWithPrefix(prefix);
 }
 
 std::vector<User*> UserSearchEngine::getUsersInIDRange(int minID, int maxID) const {
+    vector<User*> results;
+    auto cursor = usersByID.cursor();
+    collectIDRange(usersByID, cursor, minID, maxID, results);
+    return results;
+}
+
+vector<User*> UserSearchEngine::searchByIDs(const vector<int>& userIDs) const {
+    // usersByID is kept current even while the ID index is frozen
+    vector<User*> results(userIDs.size(), nullptr);
+    auto cursor = usersByID.cursor();
+    for (size_t i = 0; i < userIDs.size(); ++i) {
+        if (User* const* found = cursor.seek(userIDs[i]))
+            results[i] = *found;
+    }
+    return results;
+}
+
+vector<vector<User*>> UserSearchEngine::getUsersInIDRanges(const vector<pair<int, int>>& ranges) const {
+    vector<vector<User*>> results(ranges.size());
+    auto cursor = usersByID.cursor();
+    for (size_t i = 0; i < ranges.size(); ++i)
+        collectIDRange(usersByID, cursor, ranges[i].first, ranges[i].second, results[i]);
+    return results;
 }
 
-std::vector<User*> UserSearchEngine::fuzzyUsernameSearch(const string& username, int maxEditDistance) const {
+std::vector<User*> UserSearchEngine::fuzzyUsernameSearch(string_view username, int maxEditDistance) const {
+    // the BK-tree computes distances for the names its edges cannot rule out,
+    // and finds exactly the names a full calculateEditDistance scan would
+    vector<User*> results;
+    namesFuzzy.forEachWithin(username, maxEditDistance, [&](User* user, int) { results.push_back(user); });
+    return results;
+}
+
+vector<User*> UserSearchEngine::fuzzyTopK(string_view query, size_t k, int maxEditDistance) const {
+    struct Ranked {
+        int distance;
+        size_t sharedPrefix;  // leading bytes in common with query
+        size_t posts;         // popularity
+        User* user;
+    };
+    auto better = [](const Ranked& a, const Ranked& b) {
+        if (a.distance != b.distance)
+            return a.distance < b.distance;
+        if (a.sharedPrefix != b.sharedPrefix)
+            return a.sharedPrefix > b.sharedPrefix;
+        if (a.posts != b.posts)
+            return a.posts > b.posts;
+        return a.user->userID < b.user->userID;
+    };
+    vector<User*> results;
+    if (k == 0)
+        return results;
+    // heap of the best k so far, the worst of them on top; once it is full a
+    // user further away than that one cannot get in, so the search radius
+    // shrinks to its distance (ties may still win on the later criteria)
+    vector<Ranked> best;
+    namesFuzzy.forEachNearest(query, maxEditDistance, [&](User* user, int distance) {
+        string_view name = user->userName;
+        size_t shared = mismatch(query.begin(), query.begin() + std::min(query.size(), name.size()), name.begin()).first - query.begin();
+        Ranked candidate{distance, shared, user->posts.size(), user};
+        if (best.size() < k) {
+            best.push_back(candidate);
+            push_heap(best.begin(), best.end(), better);
+        } else if (better(candidate, best.front())) {
+            pop_heap(best.begin(), best.end(), better);
+            best.back() = candidate;
+            push_heap(best.begin(), best.end(), better);
+        }
+        return best.size() < k ? maxEditDistance : best.front().distance;
+    });
+    sort_heap(best.begin(), best.end(), better);
+    for (const Ranked& ranked : best)
+        results.push_back(ranked.user);
+    return results;
+}
+
+vector<User*> UserSearchEngine::searchByUsernameSubstring(string_view pattern) const {
+    vector<User*> results;
+    auto contains = [&](const User* user) { return string_view(user->userName).find(pattern) != string_view::npos; };
+    if (pattern.size() < TrigramIndex::GRAM) { //too short to hold a trigram: scan every name
+        for (const auto& entry : usersByID) {
+            if (contains(entry.value))
+                results.push_back(entry.value);
+        }
+        return results;
+    }
+    // a name holding every trigram of the pattern may still not contain it
+    for (User* user : searchByIDs(namesTrigrams.candidates(pattern))) {
+        if (user && contains(user))
+            results.push_back(user);
+    }
+    return results;
 }
 
 int UserSearchEngine::calculateEditDistance(const string& str1, const string& str2) const {
+    return LevenshteinDistance()(str1, str2);
 }
 
 vector<User*> UserSearchEngine::getAllUsersSorted(bool byID) const {
+    return getUsersSortedPage(0, getTotalUsers(), byID);
+}
+
+vector<User*> UserSearchEngine::getUsersSortedPage(size_t offset, size_t limit, bool byID) const {
+    // sliceByRank walks O(log n + limit) nodes instead of the whole index
+    vector<User*> result;
+    if (byID) {
+        for (const auto& entry : usersByID.sliceByRank(offset, limit))
+            result.push_back(entry.second);
+    } else {
+        for (const auto& entry : usersByName.sliceByRank(offset, limit))
+            result.push_back(entry.second);
+    }
+    return result;
+}
+
+size_t UserSearchEngine::countUsersInIDRange(int minID, int maxID) const {
+    return usersByID.countRange(minID, maxID);
+}
+
+UserActivity UserSearchEngine::getActivityInIDRange(int minID, int maxID) const {
+#ifdef USER_SEARCH_BPLUS_INDEX
+    UserActivity total = UserActivityAugment::identity();
+    auto cursor = usersByID.cursor();
+    for (auto it = cursor.seekLowerBound(minID); it != usersByID.end() && it->key <= maxID; ++it)
+        total = UserActivityAugment::combine(total, UserActivityAugment::fromEntry(it->key, it->value));
+    return total;
+#else
+    return usersByID.aggregateRange(minID, maxID);
+#endif
+}
+
+bool UserSearchEngine::refreshUserActivity(int userID) {
+#ifdef USER_SEARCH_BPLUS_INDEX
+    return usersByID.find(userID) != nullptr;  // the scan reads the counts live
+#else
+    return usersByID.refresh(userID);
+#endif
+}
+
+bool UserSearchEngine::addPost(int userID, int postID, const string& category) {
+    User* user = searchByID(userID);
+    if (!user)
+        return false;
+    user->addPost(postID, category);
+    refreshUserActivity(userID);
+    return true;
+}
+
+bool UserSearchEngine::followUser(int followerID, int followeeID) {
+    User* follower = searchByID(followerID);
+    User* followee = searchByID(followeeID);
+    if (!follower || !followee || follower == followee)
+        return false;
+    follower->followUser(followee);
+    refreshUserActivity(followerID);
+    return true;
+}
+
+bool UserSearchEngine::unfollowUser(int followerID, int followeeID) {
+    User* follower = searchByID(followerID);
+    if (!follower || !follower->following || !follower->following->removeFollowing(followeeID))
+        return false;
+    refreshUserActivity(followerID);
+    return true;
+}
+
+void UserSearchEngine::freezeIDIndex() {
+    frozenByID.build(usersByID.inOrderTraversal());
+    idDelta.clear();
+    idTombstones.clear();
+    idIndexFrozen = true;
+}
+
+bool UserSearchEngine::saveIndexes(const string& pathPrefix) const {
+    auto userID = [](User* user) { return user->userID; };
+    auto nameText = [this](const NameKey& key) -> decltype(auto) { return Names::text(nameArena, key); };
+    return usersByID.saveBinary(pathPrefix + ".ids", userID) &&
+           usersByName.saveBinary(pathPrefix + ".names", userID, nameText);
+}
+
+bool UserSearchEngine::loadIndexes(const string& pathPrefix, const LinkedList<User>& userList) {
+    clearIndexes();
+    // userID -> (user, already taken by the ID index)
+    unordered_map<int, pair<User*, bool>> users;
+    for (auto node = userList.head(); node; node = node->next)
+        users.emplace(node->data.userID, make_pair(&node->data, false));
+    auto resolveID = [&](int userID, User*& user) {
+        auto found = users.find(userID);
+        if (found == users.end())
+            return false;
+        found->second.second = true;
+        user = found->second.first;
+        return true;
+    };
+    // a name may only point at a user the ID index holds
+    auto resolveName = [&](int userID, User*& user) {
+        auto found = users.find(userID);
+        if (found == users.end() || !found->second.second)
+            return false;
+        user = found->second.first;
+        return true;
+    };
+    auto makeKey = [this](string&& name, NameKey& key) {
+        key = Names::make(nameArena, name);
+        return true;
+    };
+
+    bool ok = usersByID.loadBinary<int>(pathPrefix + ".ids", resolveID) &&
+              usersByName.loadBinary<int, string>(pathPrefix + ".names", resolveName, makeKey) &&
+              usersByName.size() == usersByID.size();
+    // both files are keyed in order and without repeats; the keys must still
+    // be each user's current ID and name
+    for (auto it = usersByID.begin(); ok && it != usersByID.end(); ++it)
+        ok = it->key == it->value->userID;
+    for (auto it = usersByName.begin(); ok && it != usersByName.end(); ++it)
+        ok = Names::equals(nameArena, it->key, it->value->userName);
+    if (!ok) {
+        clearIndexes();
+        return false;
+    }
+    for (const auto& entry : usersByID)
+        namesTrigrams.insert(entry.key, entry.value->userName);  // ascending IDs only append to each list
+    for (const auto& entry : usersByName) {
+        namesTrie.insert(entry.value->userName, entry.value);
+        namesFuzzy.insert(entry.value->userName, entry.value);
+    }
+    return true;
+}
+
+void UserSearchEngine::clearIndexes() {
+    usersByID.clear();
+    usersByName.clear();
+    nameArena.clear();
+    namesTrie.clear();
+    namesFuzzy.clear();
+    namesTrigrams.clear();
+    frozenByID.build({});
+    idDelta.clear();
+    idTombstones.clear();
+    idIndexFrozen = false;
+}
+
+void UserSearchEngine::compactNameKeys() {
+    // released names only ever leave dead bytes behind in nameArena
+    if (nameArena.deadBytes() < 64 * 1024 || nameArena.deadBytes() < nameArena.liveBytes())
+        return;
+    vector<pair<NameKey, User*>> entries;
+    entries.reserve(usersByName.size());
+    StringArena fresh;
+    for (const auto& entry : usersByName)
+        entries.emplace_back(Names::make(fresh, entry.value->userName), entry.value);
+    usersByName.clear();
+    nameArena = std::move(fresh);  // same object, so usersByName's comparator stays valid
+    usersByName.insertBatch(std::move(entries));
+}
+
+void UserSearchEngine::recordIDChange(int userID, User* addedUser) {
+    if (!idIndexFrozen)
+        return;
+    if (addedUser) {
+        idDelta.insert(userID, addedUser);
+    } else {
+        idDelta.remove(userID);
+        if (frozenByID.find(userID))
+            idTombstones.insert(userID);
+    }
+    // refreeze before the delta lookups start to dominate searchByID
+    if (idDelta.size() + idTombstones.size() > frozenByID.size() / 8 + 64)
+        freezeIDIndex();
 }
 
 size_t UserSearchEngine::getTotalUsers() const {
+    return usersByID.size();
 }
 
 void UserSearchEngine::displaySearchStats() const {
+    size_t copied = 0;
+    for (const auto& entry : usersByName)
+        copied += stringCopyBytes(entry.value->userName);
+    size_t footprint = Names::footprint(usersByName, nameArena);
+
+    cout << "=== User Search Engine Stats ===" << endl;
+    cout << "Users: " << getTotalUsers() << endl;
+    cout << "Name keys: " << footprint << " bytes";
+    if (is_same<NameKey, InternedString>::value) {
+        long long saved = (long long)copied - (long long)footprint;
+        cout << " interned (" << nameArena.prefixCount() << " shared prefixes, " << nameArena.deadBytes()
+             << " dead bytes), " << saved << " bytes saved vs string copies (" << copied << ")";
+    }
+    cout << endl;
+    printIndexStats("ID index", usersByID);
+    printIndexStats("Name index", usersByName);
+    cout << "Prefix trie: " << namesTrie.nodeCount() << " nodes" << endl;
+    cout << "Fuzzy BK-tree: " << namesFuzzy.nodeCount() << " nodes (" << namesFuzzy.nodeCount() - namesFuzzy.size() << " dead)" << endl;
+    cout << "Substring index: " << namesTrigrams.trigramCount() << " trigrams, " << namesTrigrams.byteCount() << " posting bytes" << endl;
+    if (!treeStatsEnabled)
+        cout << "(build with -DTREE_STATS for rotation, comparison and descent counters)" << endl;
 }
 
 bool UserSearchEngine::isConsistent() const {
+    ThreadPool callerOnly(1);
+    return isConsistent(callerOnly);
+}
+
+bool UserSearchEngine::isConsistent(ThreadPool& threads) const {
+    if (!indexIsValid(usersByID, threads) || !indexIsValid(usersByName, threads))
+        return false;
+    vector<pair<int, User*>> byID = indexEntries(usersByID, threads);
+    vector<pair<NameKey, User*>> byName = indexEntries(usersByName, threads);
+    if (byName.size() != byID.size() || namesTrie.size() != byID.size() || !namesTrie.isValid() ||
+        namesFuzzy.size() != byID.size() || namesTrigrams.size() != byID.size() || !namesTrigrams.isValid())
+        return false;
+
+    // Slices of the sorted copies are checked in parallel: each key must still
+    // be its user's ID / name, the prefix trie must map each name to the same user, and each named
+    // user must be the one byID holds for that ID (found by binary search,
+    // the copy being sorted and only read).
+    const size_t slices = threads.size() * 4;
+    atomic<bool> consistent(true);
+    threads.parallelFor(slices, [&](size_t slice) {
+        size_t end = byID.size() * (slice + 1) / slices;
+        for (size_t i = byID.size() * slice / slices; i < end && consistent.load(memory_order_relaxed); ++i) {
+            User* user = byID[i].second;
+            User* named = byName[i].second;
+            if (!user || user->userID != byID[i].first || !named ||
+                !Names::equals(nameArena, byName[i].first, named->userName)) {
+                consistent = false;
+                break;
+            }
+            User* const* inTrie = namesTrie.find(named->userName);
+            if (!inTrie || *inTrie != named) {
+                consistent = false;
+                break;
+            }
+            auto found = lower_bound(byID.begin(), byID.end(), named->userID,
+                                     [](const pair<int, User*>& entry, int userID) { return entry.first < userID; });
+            if (found == byID.end() || found->second != named)
+                consistent = false;
+        }
+    });
+    return consistent;
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <functional>
 #include <memory>
 #include <algorithm>
@@ -11,8 +12,16 @@
 #include <random>
 #include <cmath>
 #include <set>
+#include <map>
+#include <cstdio>
+#include <filesystem>
 
 #include "avl_tree.h"
+#include "rb_tree.h"
+#include "bplus_tree.h"
+#include "frozen_index.h"
+#include "string_arena.h"
+#include "range_stats.h"
 
 using namespace std;
 
@@ -22,10 +31,10 @@ long long comparison_steps = 0;
  * @class AVLTester
  * @brief Inherits from AVLTree to provide robust, self-contained validation.
  */
-template<typename K, typename V>
-class AVLTester : public AVLTree<K, V> {
+template<typename K, typename V, typename Compare = less<K>>
+class AVLTester : public AVLTree<K, V, Compare> {
 public:
-    using AVLTree<K, V>::AVLTree;
+    using AVLTree<K, V, Compare>::AVLTree;
 
     bool run_findRange_test(K minKey, K maxKey, const vector<K>& expected_keys_in_range) {
         vector<pair<K,V>> result = this->findRange(minKey, maxKey);
@@ -66,7 +75,7 @@ protected:
     };
     
     // The AVL balance check function you requested to keep unchanged.
-    BalanceInfo is_avl_balanced_recursive(const shared_ptr<typename BST<K, V>::BSTNode>& node) const {
+    BalanceInfo is_avl_balanced_recursive(const shared_ptr<typename BST<K, V, Compare>::BSTNode>& node) const {
         if (!node) return {true, 0};
         BalanceInfo left_info = is_avl_balanced_recursive(node->left);
         if (!left_info.is_balanced) return {false, -1};
@@ -263,6 +272,493 @@ private:
             }
             return avl.isBSTValid(current_keys) && avl.isTreeBalanced();
         });
+
+        execute_correctness_test("insert_or_assign / try_emplace / move insert", 10, "Duplicate handling and size bookkeeping of the single-descent API.", []() {
+            AVLTester<string, string> avl;
+            string key = "alice", value = "first";
+            if (!avl.insert(std::move(key), std::move(value))) return false;
+            if (avl.insert("alice", "again") || avl.size() != 1) return false;
+            if (avl.try_emplace(string("alice"), 3, 'x') || *avl.find("alice") != "first") return false;
+            if (!avl.try_emplace(string("bob"), 3, 'x') || *avl.find("bob") != "xxx") return false;
+            if (avl.insert_or_assign("alice", string("second")) || *avl.find("alice") != "second") return false;
+            if (!avl.insert_or_assign(string("carol"), "third") || avl.size() != 3) return false;
+            if (avl.remove("dave") || avl.size() != 3) return false;
+            if (!avl.remove("alice") || avl.remove("alice") || avl.size() != 2) return false;
+            return avl.isBSTValid({"bob", "carol"}) && avl.isTreeBalanced();
+        });
+
+        execute_correctness_test("Order Statistics after Mixed Updates", 10, "rank/select/countRange/sliceByRank against a sorted reference.", []() {
+            AVLTester<int, string> avl;
+            std::mt19937 rng(77);
+            set<int> current_keys;
+            for (int i = 0; i < 2000; ++i) {
+                int key = rng() % 600;
+                if (rng() % 4 == 0) { avl.remove(key); current_keys.erase(key); }
+                else { avl.insert(key, to_string(key)); current_keys.insert(key); }
+            }
+            vector<int> sorted(current_keys.begin(), current_keys.end());
+            for (size_t i = 0; i < sorted.size(); ++i) {
+                if (avl.select(i).first != sorted[i] || avl.rank(sorted[i]) != i) return false;
+            }
+            for (int lo = -5; lo < 610; lo += 37) {
+                for (int hi = lo - 10; hi < 620; hi += 53) {
+                    size_t expected = 0;
+                    for (int k : sorted) expected += (k >= lo && k <= hi);
+                    if (avl.countRange(lo, hi) != expected) return false;
+                }
+            }
+            vector<pair<int, string>> page = avl.sliceByRank(100, 25);
+            if (page.size() != 25) return false;
+            for (size_t i = 0; i < page.size(); ++i) if (page[i].first != sorted[100 + i]) return false;
+            if (avl.sliceByRank(sorted.size() - 3, 10).size() != 3 || !avl.sliceByRank(sorted.size(), 5).empty()) return false;
+            try { avl.select(sorted.size()); return false; } catch (const out_of_range&) {}
+            return avl.isTreeBalanced();
+        });
+
+        execute_correctness_test("Bulk Build from Sorted and Unsorted Input", 10, "buildFromSorted / buildFrom give a minimal-height tree that stays valid under updates.", []() {
+            vector<pair<int, string>> sorted_items;
+            for (int i = 0; i < 1000; ++i) sorted_items.push_back({i * 2, to_string(i)});
+            sorted_items.push_back({1998, "duplicate"});
+            AVLTester<int, string> avl;
+            avl.insert(-1, "replaced");
+            avl.buildFromSorted(sorted_items.begin(), sorted_items.end());
+            set<int> keys;
+            for (int i = 0; i < 1000; ++i) keys.insert(i * 2);
+            if (avl.getTreeHeight() != 10 || *avl.find(1998) != "999" || avl.find(-1)) return false;
+            if (!avl.isBSTValid(keys) || !avl.isTreeBalanced() || avl.select(500).first != 1000) return false;
+            vector<pair<int, string>> descending = {{3, "c"}, {2, "b"}, {1, "a"}};
+            try { avl.buildFromSorted(descending.begin(), descending.end()); return false; } catch (const invalid_argument&) {}
+            if (avl.size() != 1000 || avl.find(3)) return false;  // rejected before the old contents were cleared
+
+            std::mt19937 rng(9);
+            vector<pair<int, string>> shuffled(sorted_items.begin(), sorted_items.end() - 1);
+            std::shuffle(shuffled.begin(), shuffled.end(), rng);
+            AVLTester<int, string> rebuilt;
+            rebuilt.buildFrom(shuffled.begin(), shuffled.end());
+            if (rebuilt.getTreeHeight() != 10 || !rebuilt.isBSTValid(keys)) return false;
+            for (int i = 0; i < 500; ++i) {
+                rebuilt.remove(i * 4);
+                keys.erase(i * 4);
+                rebuilt.insert(i * 4 + 1, "");
+                keys.insert(i * 4 + 1);
+            }
+            return rebuilt.isBSTValid(keys) && rebuilt.isTreeBalanced();
+        });
+
+        execute_correctness_test("Split / Join / removeRange", 15, "isValidAVL and contents checked after every operation (shared and arena storage).", [this]() {
+            return run_split_join_scenario<AVLTree<int, string>>() &&
+                   run_split_join_scenario<AVLTree<int, string, less<int>, ArenaNodeStorage>>();
+        });
+
+        execute_correctness_test("Arena Storage Mixed Stress", 10, "Same mix on ArenaNodeStorage; contents, height and parent links checked.", []() {
+            AVLTree<int, string, less<int>, ArenaNodeStorage> avl;
+            std::mt19937 rng(321);
+            set<int> current_keys;
+            for (int i = 0; i < 3000; ++i) {
+                int key = rng() % 1000;
+                if (rng() % 3 == 0) {
+                    if (avl.remove(key) != (current_keys.erase(key) == 1)) return false;
+                } else {
+                    if (avl.insert(key, "v") != current_keys.insert(key).second) return false;
+                }
+            }
+            vector<pair<int, string>> items = avl.inOrderTraversal();
+            if (items.size() != current_keys.size() || avl.size() != current_keys.size()) return false;
+            auto it = current_keys.begin();
+            for (const auto& p : items) if (p.first != *it++) return false;
+            if (avl.getTreeHeight() > 1.45 * log2(current_keys.size() + 2)) return false;
+
+            // Every child must point back at its parent, and the root at nothing.
+            vector<BST<int, string, less<int>, ArenaNodeStorage>::BSTNode*> stack = {avl.getRoot()};
+            if (avl.getRoot()->parent != nullptr) return false;
+            while (!stack.empty()) {
+                auto node = stack.back();
+                stack.pop_back();
+                for (auto child : {node->left, node->right}) {
+                    if (!child) continue;
+                    if (child->parent != node) return false;
+                    stack.push_back(child);
+                }
+            }
+            return true;
+        });
+
+        execute_correctness_test("Augmented AVL aggregateRange", 10, "Range summaries match brute force through every mutation path, both storage policies.", []() {
+            return run_augmented_scenario<AVLTree<int, int, less<int>, SharedNodeStorage, RangeStats>>() &&
+                   run_augmented_scenario<AVLTree<int, int, less<int>, ArenaNodeStorage, RangeStats>>();
+        });
+
+        execute_correctness_test("Batch insert/remove", 10, "insertBatch/removeBatch per-key results and contents match one-by-one updates, small and large batches.", []() {
+            auto valid_avl = [](const auto& tree) { return tree.isValidAVL(); };
+            auto valid_summed = [](const auto& tree) {
+                RangeStats::Summary total = RangeStats::identity();
+                for (auto& e : tree.inOrderTraversal()) total = RangeStats::combine(total, RangeStats::fromEntry(e.first, e.second));
+                return tree.isValidAVL() && tree.aggregate() == total;
+            };
+            return run_batch_scenario<AVLTree<int, int>>(valid_avl) &&
+                   run_batch_scenario<AVLTree<int, int, less<int>, ArenaNodeStorage, RangeStats>>(valid_summed) &&
+                   run_batch_scenario<BPlusTree<int, int>>([](const BPlusTree<int, int>& tree) { return tree.isValid(); });
+        });
+
+        execute_correctness_test("Depth Stats and TreeStats Counters", 5, "getMaxDepth/getAverageDepth on a perfect tree; rotation, rebalance and descent counters when built with TREE_STATS.", []() {
+            AVLTree<int, int> tree;
+            if (tree.getMaxDepth() != 0 || tree.getAverageDepth() != 0.0) return false;
+            // 1023 ascending keys leave AVL with a perfect tree of 10 levels
+            for (int i = 1; i <= 1023; ++i) tree.insert(i, i);
+            if (tree.getMaxDepth() != 10 || tree.getMaxDepth() != tree.getTreeHeight()) return false;
+            if (std::abs(tree.getAverageDepth() - 9217.0 / 1023) > 1e-9) return false;
+
+            const TreeStats& stats = tree.getStats();
+            if (!treeStatsEnabled)
+                return stats.operations == 0 && stats.comparisons == 0 && stats.rebalanceCalls == 0;
+            // every AVL rotation comes from rebalance: one per single, two per double
+            if (stats.operations != 1023 || stats.singleRotations + 2 * stats.doubleRotations != stats.rotations) return false;
+            if (stats.rebalanceCalls < 1023 || stats.maxDescentDepth > 10) return false;
+            tree.resetStats();
+            for (int i = 1; i <= 1023; ++i) tree.find(i);
+            if (stats.operations != 1023 || stats.maxDescentDepth != 10 || stats.rebalanceCalls != 0) return false;
+            // a successful find compares twice at each node but the last, where it matches
+            return stats.comparisons <= 2 * 9217 && stats.comparisonsPerOperation() >= 9217.0 / 1023;
+        });
+
+        execute_correctness_test("Heterogeneous string_view Lookups", 5, "find / lower_bound / upper_bound / findRange with string_view and const char* probes match string probes.", []() {
+            return run_heterogeneous_scenario<AVLTree<string, int>>() &&
+                   run_heterogeneous_scenario<AVLTree<string, int, less<>, ArenaNodeStorage>>() &&
+                   run_heterogeneous_scenario<BPlusTree<string, int>>();
+        });
+
+        execute_correctness_test("Interned String Keys", 5, "AVL/B+ trees keyed by StringArena handles order, find and remove like string-keyed ones.", []() {
+            return run_interned_scenario<AVLTree<InternedString, int, InternedStringCompare, ArenaNodeStorage>>() &&
+                   run_interned_scenario<BPlusTree<InternedString, int, InternedStringCompare>>();
+        });
+
+        execute_correctness_test("Parallel Traversal and Validation", 10, "inOrderTraversal / isValidAVL / depth stats on 1, 3 and 8 threads match the serial walks and catch broken keys and heights.", []() {
+            for (size_t threadCount : {1, 3, 8}) {
+                ThreadPool threads(threadCount);
+                for (int n : {0, 1, 700, 5000, 60000}) {
+                    AVLTree<int, string, less<int>, ArenaNodeStorage> tree;
+                    std::mt19937 rng(n);
+                    for (int i = 0; i < n; ++i) tree.insert(rng() % (4 * n), to_string(i));
+                    if (tree.inOrderTraversal(threads) != tree.inOrderTraversal() || !tree.isValidAVL(threads)) return false;
+                    if (tree.getMaxDepth(threads) != tree.getMaxDepth() || tree.getAverageDepth(threads) != tree.getAverageDepth()) return false;
+                }
+                // keys entered in order leave a plain BST a single chain
+                BST<int, int> chain;
+                for (int i = 0; i < 3000; ++i) chain.insert(i, -i);
+                if (chain.inOrderTraversal(threads) != chain.inOrderTraversal()) return false;
+
+                AVLTree<int, int> tree;
+                for (int i = 0; i < 60000; ++i) tree.insert(i * 2, i);
+                auto root = tree.getRoot();
+                auto successor = root->right;
+                while (successor->left) successor = successor->left;
+                int key = successor->key;
+                successor->key = root->key - 1;  // now smaller than the root it follows
+                if (tree.isValidAVL(threads)) return false;
+                successor->key = key;
+                root->left->height++;
+                if (tree.isValidAVL(threads)) return false;
+                root->left->height--;
+                if (!tree.isValidAVL(threads)) return false;
+            }
+            return true;
+        });
+
+        execute_correctness_test("Finger Search Cursor", 5, "Cursor seek / seekLowerBound match find / lower_bound over nearby and far probe runs (AVL, RB, plain BST, B+).", []() {
+            if (!run_cursor_scenario<AVLTree<int, int>>() || !run_cursor_scenario<AVLTree<int, int, less<int>, ArenaNodeStorage>>() ||
+                !run_cursor_scenario<RBTree<int, int>>() || !run_cursor_scenario<BST<int, int>>() || !run_cursor_scenario<BPlusTree<int, int>>())
+                return false;
+            if (!treeStatsEnabled)
+                return true;
+            // consecutive keys: the cursor climbs and descends a few levels, find walks ~log2(n) every time
+            AVLTree<int, int> tree;
+            for (int i = 0; i < 1 << 16; ++i) tree.insert(i, i);
+            const TreeStats& stats = tree.getStats();
+            tree.resetStats();
+            for (int i = 0; i < 1 << 16; ++i) tree.find(i);
+            size_t findComparisons = stats.comparisons;
+            tree.resetStats();
+            auto cursor = tree.cursor();
+            for (int i = 0; i < 1 << 16; ++i) cursor.seek(i);
+            if (stats.operations != 1 << 16 || stats.comparisons * 2 >= findComparisons) return false;
+            // seeking the key the finger holds again stays on that node instead of climbing
+            for (int i = 0; i < 1 << 16; i += 251) {
+                cursor.seek(i);
+                tree.resetStats();
+                if (!cursor.seek(i) || stats.maxDescentDepth != 1) return false;
+            }
+            return true;
+        });
+
+        execute_correctness_test("Binary Snapshots and Mapped Frozen Index", 10, "saveBinary/loadBinary round trips, mapFile serves the same entries in place, bad files are rejected.", []() {
+            const string path = (std::filesystem::temp_directory_path() / "avl_test_snapshot.bin").string();
+            bool ok = run_snapshot_scenario(path);
+            std::remove(path.c_str());
+            return ok;
+        });
+    }
+
+    static bool run_snapshot_scenario(const string& path) {
+        AVLTree<string, string> names;
+        for (int i = 0; i < 2000; ++i) names.insert("user" + to_string(i * 7 % 2000), to_string(i));
+        AVLTree<string, string, less<string>, ArenaNodeStorage> loadedNames;
+        if (!names.saveBinary(path) || !loadedNames.loadBinary(path)) return false;
+        if (loadedNames.inOrderTraversal() != names.inOrderTraversal() || !loadedNames.isValidAVL()) return false;
+        BPlusTree<string, string> namesBPlus;
+        if (!namesBPlus.loadBinary(path) || namesBPlus.inOrderTraversal() != names.inOrderTraversal()) return false;
+
+        // values mapped to a storable form: each string saved as its length
+        AVLTree<string, int> lengths;
+        auto length = [](const string& value) { return (uint32_t)value.size(); };
+        auto widen = [](uint32_t stored, int& value) { value = (int)stored; return true; };
+        if (!names.saveBinary(path, length) || !lengths.loadBinary<uint32_t>(path, widen)) return false;
+        if (lengths.size() != names.size() || *lengths.find("user1999") != (int)names.find("user1999")->size()) return false;
+
+        AVLTree<int, int> ids;
+        for (int i = 0; i < 5000; ++i) ids.insert(i * 3, i);
+        if (!ids.saveBinary(path)) return false;
+        AVLTree<int, int> loadedIDs;
+        if (!loadedIDs.loadBinary(path) || loadedIDs.inOrderTraversal() != ids.inOrderTraversal()) return false;
+        // loadBinary builds the same perfectly balanced shape as buildFromSorted
+        if (loadedIDs.getTreeHeight() != (int)std::ceil(std::log2(5000 + 1))) return false;
+
+        FrozenIndex<int, int> mapped;
+        if (!mapped.mapFile(path) || !mapped.isMapped() || mapped.size() != ids.size()) return false;
+        FrozenIndex<int, int> shared = mapped;  // copies read the same mapping
+        for (int key = -1; key <= 15001; key += 2) {
+            const int* hit = shared.find(key);
+            if ((hit == nullptr) != (ids.find(key) == nullptr) || (hit && *hit != *ids.find(key))) return false;
+            auto lb = mapped.lower_bound(key);
+            if (lb != mapped.end() && lb->key != ids.lower_bound(key)->key) return false;
+        }
+        if (mapped.findRange(100, 200) != ids.findRange(100, 200)) return false;
+
+        // the wrong key/value types, or a truncated file, leave the target untouched
+        FrozenIndex<int, string> frozenStrings;
+        if (frozenStrings.mapFile(path) || loadedNames.loadBinary(path) || loadedNames.size() != 2000) return false;
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+        if (loadedIDs.loadBinary(path) || mapped.mapFile(path) || loadedIDs.size() != 5000) return false;
+        return mapped.isMapped() && mapped.size() == 5000 && !AVLTree<int, int>().loadBinary(path + ".missing");
+    }
+
+    template<typename Tree>
+    static bool same_keys(const Tree& tree, const set<int>& expected) {
+        if (tree.size() != expected.size()) return false;
+        auto it = expected.begin();
+        for (auto node = tree.begin(); node != tree.end(); ++node) if (node->key != *it++) return false;
+        return true;
+    }
+
+    template<typename Tree>
+    static bool run_split_join_scenario() {
+        std::mt19937 rng(2024);
+        for (int round = 0; round < 20; ++round) {
+            Tree tree;
+            set<int> keys;
+            int n = 1 + rng() % 400;
+            for (int i = 0; i < n; ++i) { int k = rng() % 1000; tree.insert(k, ""); keys.insert(k); }
+
+            int cut = rng() % 1000;
+            Tree right = tree.split(cut);
+            set<int> left_keys(keys.begin(), keys.lower_bound(cut)), right_keys(keys.lower_bound(cut), keys.end());
+            if (!tree.isValidAVL() || !right.isValidAVL()) return false;
+            if (!same_keys(tree, left_keys) || !same_keys(right, right_keys)) return false;
+
+            // both halves stay usable on their own before being glued back
+            right.insert(1000 + round, "");
+            right_keys.insert(1000 + round);
+            tree.join(right);
+            if (!tree.isValidAVL() || !right.empty() || !right.isValidAVL()) return false;
+            keys = left_keys;
+            keys.insert(right_keys.begin(), right_keys.end());
+            if (!same_keys(tree, keys)) return false;
+
+            int lo = rng() % 1000, hi = lo + rng() % 300;
+            size_t expected_removed = distance(keys.lower_bound(lo), keys.upper_bound(hi));
+            if (tree.removeRange(lo, hi) != expected_removed) return false;
+            keys.erase(keys.lower_bound(lo), keys.upper_bound(hi));
+            if (!tree.isValidAVL() || !same_keys(tree, keys)) return false;
+            if (tree.removeRange(hi, lo) != 0) return false;
+        }
+        return true;
+    }
+
+    // Every mutation path (insert, remove, overwrite, in-place edit + refresh,
+    // split/join, removeRange, bulk load) must leave the summaries exact.
+    template<typename Tree>
+    static bool run_augmented_scenario() {
+        std::mt19937 rng(4242);
+        Tree tree;
+        map<int, int> entries;
+        auto check = [&]() {
+            if (!tree.isValidAVL() || !(tree.aggregate() == brute_force_stats(entries, INT32_MIN, INT32_MAX))) return false;
+            for (int q = 0; q < 50; ++q) {
+                int lo = (int)(rng() % 2200) - 100, hi = lo + (int)(rng() % 600) - 50;
+                if (!(tree.aggregateRange(lo, hi) == brute_force_stats(entries, lo, hi))) return false;
+            }
+            return true;
+        };
+        for (int round = 0; round < 40; ++round) {
+            for (int i = 0; i < 200; ++i) {
+                int k = rng() % 2000, v = rng() % 1000;
+                switch (rng() % 4) {
+                case 0: if (tree.insert(k, v) != entries.emplace(k, v).second) return false; break;
+                case 1: if (tree.remove(k) != (entries.erase(k) == 1)) return false; break;
+                case 2: tree.insert_or_assign(k, v); entries[k] = v; break;
+                default:
+                    if (int* value = tree.find(k)) {
+                        *value = v;
+                        entries[k] = v;
+                        if (!tree.refresh(k)) return false;
+                    } else if (tree.refresh(k)) {
+                        return false;
+                    }
+                }
+            }
+            if (!check()) return false;
+            int cut = rng() % 2000;
+            Tree right = tree.split(cut);
+            if (!(right.aggregate() == brute_force_stats(entries, cut, INT32_MAX))) return false;
+            tree.join(right);
+            int lo = rng() % 2000, hi = lo + rng() % 100;
+            tree.removeRange(lo, hi);
+            entries.erase(entries.lower_bound(lo), entries.upper_bound(hi));
+            if (!check()) return false;
+        }
+        vector<pair<int, int>> items(entries.begin(), entries.end());
+        tree.buildFromSorted(items.begin(), items.end());
+        return check() && tree.aggregateRange(5, 4) == RangeStats::identity();
+    }
+
+    // One cursor follows ascending, descending, strided and random probe runs;
+    // every seek must agree with a fresh find / lower_bound from the root.
+    template<typename Tree>
+    static bool run_cursor_scenario() {
+        Tree tree;
+        mt19937 rng(29);
+        vector<int> keys;
+        for (int i = 0; i < 3000; ++i) keys.push_back(i * 3);
+        shuffle(keys.begin(), keys.end(), rng);
+        for (int key : keys) tree.insert(key, -key);
+
+        vector<int> probes;
+        for (int key = -2; key <= 9002; ++key) probes.push_back(key);
+        for (int key = 9002; key >= -2; --key) probes.push_back(key);
+        for (int key = 0; key <= 9000; key += 97) probes.push_back(key);
+        for (int i = 0; i < 3000; ++i) probes.push_back((int)(rng() % 9010) - 4);
+        auto agrees = [&](auto& cursor, int key) {
+            const int* found = cursor.seek(key);
+            if ((found == nullptr) != (tree.find(key) == nullptr) || (found && *found != -key)) return false;
+            auto lb = cursor.seekLowerBound(key);
+            auto expected = tree.lower_bound(key);
+            return (lb == tree.end()) == (expected == tree.end()) && (lb == tree.end() || lb->key == expected->key);
+        };
+        auto cursor = tree.cursor();
+        for (int key : probes)
+            if (!agrees(cursor, key)) return false;
+
+        // after updates a cursor must be reset before its next seek
+        for (int key = 0; key < 9000; key += 6) tree.remove(key);
+        cursor.reset();
+        for (int key = -2; key <= 9002; key += 2)
+            if (!agrees(cursor, key)) return false;
+        Tree empty;
+        auto none = empty.cursor();
+        return !none.seek(1) && none.seekLowerBound(1) == empty.end();
+    }
+
+    // Probes are slices of one buffer, so none of them is null-terminated
+    // and each must be compared by length, never turned into a string first.
+    template<typename Tree>
+    static bool run_heterogeneous_scenario() {
+        Tree tree;
+        for (int i = 0; i < 2000; i += 2) tree.insert("name" + to_string(i), i);
+        const string buffer = "name1000|name1001|name19|name2|name|zzz";
+        vector<string_view> probes;
+        for (size_t start = 0, bar; start < buffer.size(); start = bar + 1) {
+            bar = buffer.find('|', start);
+            if (bar == string::npos) bar = buffer.size();
+            probes.push_back(string_view(buffer).substr(start, bar - start));
+        }
+        for (string_view probe : probes) {
+            string key(probe);
+            const int* found = tree.find(probe);
+            if ((found == nullptr) != (tree.find(key) == nullptr) || (found && *found != *tree.find(key))) return false;
+            auto lb = tree.lower_bound(probe), ub = tree.upper_bound(probe);
+            if (lb != tree.lower_bound(key) || ub != tree.upper_bound(key)) return false;
+        }
+        if (tree.findRange(probes[0], probes[2]) != tree.findRange(string(probes[0]), string(probes[2]))) return false;
+        if (!tree.findRange(probes[2], probes[0]).empty()) return false;
+        return tree.find("name100") && !tree.find("name101") && tree.findRange("name10", "name12").size() == 112;  // name10, name12, even name100..name118 and name1000..name1198
+    }
+
+    // Names mix shared prefixes, digit segments (never shared) and prefixes of
+    // each other, so handles with different splits get compared.
+    template<typename Tree>
+    static bool run_interned_scenario() {
+        StringArena arena;
+        Tree tree(InternedStringCompare{&arena});
+        map<string, int> expected;
+        const vector<string> stems = {"team_", "team", "team_a", "bot_", "bot-", "x1_", "a.b", "", "zz_"};
+        mt19937 rng(41);
+        for (int round = 0; round < 4000; ++round) {
+            string name = stems[rng() % stems.size()] + to_string(rng() % 300);
+            auto found = tree.lower_bound(name);
+            bool present = found != tree.end() && arena.compare(found->key, name) == 0;
+            if (present != (expected.count(name) > 0)) return false;
+            if (rng() % 3 == 0) {
+                if (!present) continue;
+                InternedString key = found->key;
+                if (!tree.remove(key)) return false;
+                arena.release(key);
+                expected.erase(name);
+            } else if (!present) {
+                if (!tree.insert(arena.intern(name), round)) return false;
+                expected[name] = round;
+            }
+        }
+        if (tree.size() != expected.size() || arena.size() != expected.size()) return false;
+        auto it = tree.begin();
+        for (const auto& entry : expected) {
+            if (it == tree.end() || arena.str(it->key) != entry.first || it->value != entry.second) return false;
+            if (!tree.find(entry.first) || *tree.find(string_view(entry.first)) != entry.second) return false;
+            ++it;
+        }
+        // prefix scans stop at the first name that no longer starts with it
+        size_t matches = 0;
+        for (auto at = tree.lower_bound("team_"); at != tree.end() && arena.startsWith(at->key, "team_"); ++at) matches++;
+        size_t expectedMatches = 0;
+        for (const auto& entry : expected) expectedMatches += entry.first.compare(0, 5, "team_") == 0;
+        return it == tree.end() && matches == expectedMatches && arena.prefixCount() == 5;  // team_ bot_ bot- a. zz_
+    }
+
+    // Batches of every size relative to the tree, so both the per-key and the
+    // merge-and-rebuild paths run, checked against applying them one by one.
+    template<typename Tree, typename Validate>
+    static bool run_batch_scenario(Validate is_valid) {
+        std::mt19937 rng(77);
+        Tree tree;
+        map<int, int> reference;
+        for (int round = 0; round < 60; ++round) {
+            size_t batch_size = round % 3 == 0 ? rng() % 8 : rng() % (reference.size() + 50) * 2;
+            vector<pair<int, int>> entries;
+            for (size_t i = 0; i < batch_size; ++i) entries.emplace_back(rng() % 3000, round * 10000 + (int)i);
+            vector<bool> expected;
+            for (auto& e : entries) expected.push_back(reference.emplace(e.first, e.second).second);
+            if (tree.insertBatch(entries) != expected) return false;
+
+            vector<int> keys;
+            for (size_t i = 0; i < batch_size / 2 + rng() % 4; ++i) keys.push_back(rng() % 3000);
+            expected.clear();
+            for (int k : keys) expected.push_back(reference.erase(k) == 1);
+            if (tree.removeBatch(keys) != expected) return false;
+
+            if (!is_valid(tree) || tree.size() != reference.size()) return false;
+            if (tree.inOrderTraversal() != vector<pair<int, int>>(reference.begin(), reference.end())) return false;
+        }
+        vector<int> all;
+        for (auto& e : reference) all.push_back(e.first);
+        return tree.removeBatch(all) == vector<bool>(all.size(), true) && tree.empty() && tree.insertBatch({}).empty();
     }
 
     void plot_graph(const string& title, const string& y_axis_label, const vector<double>& y_values, const vector<int>& x_values) {
@@ -292,7 +788,7 @@ private:
 
         for (int n : sizes) {
             cout << "\n  Testing insert performance with n = " << n << "..." << endl;
-            AVLTester<int, string> avl(counting_comparator);
+            AVLTester<int, string, DynamicCompare<int>> avl(counting_comparator);
             vector<int> data(n * 2);
             for(size_t i = 0; i < data.size(); ++i) data[i] = i;
             std::shuffle(data.begin(), data.end(), rng);
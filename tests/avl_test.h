@@ -21,11 +21,12 @@ long long comparison_steps = 0;
 /**
  * @class AVLTester
  * @brief Inherits from AVLTree to provide robust, self-contained validation.
+ * Storage and Augment match the tree under test, so its root can be handed over with setRoot.
  */
-template<typename K, typename V>
-class AVLTester : public AVLTree<K, V> {
+template<typename K, typename V, typename Compare = less<K>, typename Storage = SharedNodeStorage, typename Augment = NoAugmentation>
+class AVLTester : public AVLTree<K, V, Compare, Storage, Augment> {
 public:
-    using AVLTree<K, V>::AVLTree;
+    using AVLTree<K, V, Compare, Storage, Augment>::AVLTree;
 
     // Public entry point for the AVL balance check.
     bool isTreeBalanced() const {
@@ -48,7 +49,7 @@ public:
     };
     
     // The AVL balance check function you requested to keep unchanged.
-    BalanceInfo is_avl_balanced_recursive(const shared_ptr<typename BST<K, V>::BSTNode>& node) const {
+    BalanceInfo is_avl_balanced_recursive(const typename BST<K, V, Compare, Storage, Augment>::NodePtr& node) const {
         if (!node) return {true, 0};
         BalanceInfo left_info = is_avl_balanced_recursive(node->left);
         if (!left_info.is_balanced) return {false, -1};
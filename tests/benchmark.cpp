@@ -0,0 +1,951 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <filesystem>
+#include <set>
+#include <memory>
+
+#include "avl_tree.h"
+#include "rb_tree.h"
+#include "bplus_tree.h"
+#include "frozen_index.h"
+#include "radix_trie.h"
+#include "bk_tree.h"
+#include "trigram_index.h"
+#include "string_arena.h"
+#include "user_search_engine.h"
+#include "user.h"
+
+using namespace std;
+
+// Sum of values, the augmentation timed by bench_range_aggregate
+struct ValueSum {
+    using Summary = long long;
+    static Summary identity() { return 0; }
+    static Summary fromEntry(const int&, const int& value) { return value; }
+    static Summary combine(Summary a, Summary b) { return a + b; }
+};
+
+/**
+ * Throughput benchmarks for the search tree indexes.
+ * Build and run with `make bench`; each section prints its own table.
+ */
+class BenchmarkRunner {
+public:
+    void run_all() {
+        cout << "=======================================================================" << endl;
+        cout << "                 Search Tree Benchmarks" << endl;
+        cout << "=======================================================================" << endl;
+
+        bench_node_storage();
+        bench_comparator();
+        bench_bplus_tree();
+        bench_frozen_index();
+        bench_sequential_keys();
+        bench_balancing();
+        bench_range_aggregate();
+        bench_batch_updates();
+        bench_name_keys();
+        bench_name_key_engine();
+        bench_cold_start();
+        bench_parallel_walks();
+        bench_finger_search();
+        bench_prefix_search();
+        bench_fuzzy_search();
+        bench_edit_distance();
+        bench_substring_search();
+        bench_fuzzy_top_k();
+
+        cout << "=======================================================================" << endl;
+    }
+
+    // Only the populated-engine name key report, for `make bench-names`
+    void run_name_keys() {
+        bench_name_key_engine();
+    }
+
+private:
+    using Clock = chrono::high_resolution_clock;
+
+    static double elapsed_ms(Clock::time_point start) {
+        return chrono::duration<double, milli>(Clock::now() - start).count();
+    }
+
+    static vector<int> shuffled_keys(int n, unsigned seed) {
+        vector<int> keys(n);
+        for (int i = 0; i < n; ++i) keys[i] = i;
+        shuffle(keys.begin(), keys.end(), mt19937(seed));
+        return keys;
+    }
+
+    static void print_header(const string& title, const vector<string>& columns) {
+        cout << "\n--- " << title << " ---" << endl;
+        for (size_t i = 0; i < columns.size(); ++i)
+            cout << left << setw(i == 0 ? 28 : 16) << columns[i];
+        cout << endl;
+        cout << string(28 + 16 * (columns.size() - 1), '-') << endl;
+    }
+
+    static void print_row(const string& label, const vector<double>& values) {
+        cout << left << setw(28) << label;
+        for (double v : values) cout << left << setw(16) << fixed << setprecision(2) << v;
+        cout << endl;
+    }
+
+    // Million operations per second for `ops` operations in `ms` milliseconds.
+    static double mops(size_t ops, double ms) {
+        return ms > 0 ? ops / ms / 1000.0 : 0.0;
+    }
+
+    // --- Node storage: shared_ptr layout vs per-tree arena ---
+
+    template<typename Tree>
+    static vector<double> time_insert_find_remove(const vector<int>& keys, const vector<int>& probes) {
+        Tree tree;
+        auto start = Clock::now();
+        for (int k : keys) tree.insert(k, k);
+        double insert_ms = elapsed_ms(start);
+
+        start = Clock::now();
+        long long found = 0;
+        for (int k : probes) found += tree.find(k) != nullptr;
+        double find_ms = elapsed_ms(start);
+        if (found != (long long)probes.size()) cout << "  [warn] lookups missed keys" << endl;
+
+        start = Clock::now();
+        for (int k : probes) tree.remove(k);
+        double remove_ms = elapsed_ms(start);
+
+        return {mops(keys.size(), insert_ms), mops(probes.size(), find_ms), mops(probes.size(), remove_ms)};
+    }
+
+    void bench_node_storage() {
+        for (int n : {100000, 1000000}) {
+            vector<int> keys = shuffled_keys(n, 1);
+            vector<int> probes = shuffled_keys(n, 2);
+            print_header("Node storage, n = " + to_string(n) + " (Mops/s)", {"Tree", "insert", "find", "remove"});
+            print_row("BST<shared_ptr>", time_insert_find_remove<BST<int, int>>(keys, probes));
+            print_row("BST<arena>", time_insert_find_remove<BST<int, int, less<int>, ArenaNodeStorage>>(keys, probes));
+            print_row("AVLTree<shared_ptr>", time_insert_find_remove<AVLTree<int, int>>(keys, probes));
+            print_row("AVLTree<arena>", time_insert_find_remove<AVLTree<int, int, less<int>, ArenaNodeStorage>>(keys, probes));
+        }
+    }
+
+    // --- Comparator policy: inlined less<K> vs runtime DynamicCompare<K> ---
+
+    template<typename Tree, typename Key>
+    static double time_lookups(const vector<Key>& keys, const vector<Key>& probes, int rounds) {
+        Tree tree;
+        for (size_t i = 0; i < keys.size(); ++i) tree.insert(keys[i], (int)i);
+        long long found = 0;
+        auto start = Clock::now();
+        for (int r = 0; r < rounds; ++r)
+            for (const Key& k : probes) found += tree.find(k) != nullptr;
+        double ms = elapsed_ms(start);
+        if (found != (long long)probes.size() * rounds) cout << "  [warn] lookups missed keys" << endl;
+        return mops(probes.size() * rounds, ms);
+    }
+
+    void bench_comparator() {
+        const int n = 200000, rounds = 5;
+        vector<int> int_keys = shuffled_keys(n, 3), int_probes = shuffled_keys(n, 4);
+        vector<string> str_keys, str_probes;
+        for (int k : int_keys) str_keys.push_back("user_" + to_string(k));
+        for (int k : int_probes) str_probes.push_back("user_" + to_string(k));
+
+        print_header("Comparator policy, n = " + to_string(n) + " (find Mops/s)", {"Key type", "less<K>", "DynamicCompare", "speedup"});
+        double static_int = time_lookups<AVLTree<int, int>>(int_keys, int_probes, rounds);
+        double dynamic_int = time_lookups<AVLTree<int, int, DynamicCompare<int>>>(int_keys, int_probes, rounds);
+        print_row("int", {static_int, dynamic_int, static_int / dynamic_int});
+        double static_str = time_lookups<AVLTree<string, int>>(str_keys, str_probes, rounds);
+        double dynamic_str = time_lookups<AVLTree<string, int, DynamicCompare<string>>>(str_keys, str_probes, rounds);
+        print_row("string", {static_str, dynamic_str, static_str / dynamic_str});
+    }
+
+    // --- B+ tree vs AVL tree: point lookups and range scans ---
+
+    template<typename Tree>
+    static vector<double> time_lookups_and_scans(const vector<int>& keys, const vector<int>& probes, int window) {
+        Tree tree;
+        for (int k : keys) tree.insert(k, k);
+
+        auto start = Clock::now();
+        long long found = 0;
+        for (int k : probes) found += tree.find(k) != nullptr;
+        double find_ms = elapsed_ms(start);
+        if (found != (long long)probes.size()) cout << "  [warn] lookups missed keys" << endl;
+
+        // one range scan of `window` consecutive keys per probe
+        start = Clock::now();
+        long long visited = 0;
+        for (int k : probes) {
+            tree.forEachInRange(k, k + window - 1, [&](const int&, const int& value) {
+                visited += value >= 0;
+                return true;
+            });
+        }
+        double scan_ms = elapsed_ms(start);
+
+        start = Clock::now();
+        long long sum = 0;
+        for (auto it = tree.begin(); it != tree.end(); ++it) sum += it->value;
+        double iterate_ms = elapsed_ms(start);
+        if (sum < 0) cout << "  [warn] unexpected sum" << endl;
+
+        return {mops(probes.size(), find_ms), mops(visited, scan_ms), mops(keys.size(), iterate_ms)};
+    }
+
+    void bench_bplus_tree() {
+        const int window = 100;
+        for (int n : {100000, 1000000}) {
+            vector<int> keys = shuffled_keys(n, 5);
+            vector<int> probes = shuffled_keys(n, 6);
+            print_header("B+ tree vs AVL, n = " + to_string(n) + " (Mops/s)", {"Tree", "find", "scan x100", "full iterate"});
+            print_row("AVLTree<shared_ptr>", time_lookups_and_scans<AVLTree<int, int>>(keys, probes, window));
+            print_row("AVLTree<arena>", time_lookups_and_scans<AVLTree<int, int, less<int>, ArenaNodeStorage>>(keys, probes, window));
+            print_row("BPlusTree", time_lookups_and_scans<BPlusTree<int, int>>(keys, probes, window));
+        }
+    }
+
+    // --- Frozen Eytzinger snapshot vs the live trees: point lookups ---
+
+    template<typename Index>
+    static double time_index_lookups(const Index& index, const vector<int>& probes) {
+        long long found = 0;
+        auto start = Clock::now();
+        for (int k : probes) found += index.find(k) != nullptr;
+        double ms = elapsed_ms(start);
+        if (found != (long long)probes.size()) cout << "  [warn] lookups missed keys" << endl;
+        return mops(probes.size(), ms);
+    }
+
+    void bench_frozen_index() {
+        for (int n : {100000, 1000000}) {
+            vector<int> keys = shuffled_keys(n, 7);
+            vector<int> probes = shuffled_keys(n, 8);
+            AVLTree<int, int, less<int>, ArenaNodeStorage> avl;
+            BPlusTree<int, int> bpt;
+            auto start = Clock::now();
+            for (int k : keys) avl.insert(k, k);
+            double avl_ms = elapsed_ms(start);
+            start = Clock::now();
+            for (int k : keys) bpt.insert(k, k);
+            double bpt_ms = elapsed_ms(start);
+            start = Clock::now();
+            FrozenIndex<int, int> frozen(avl.inOrderTraversal());
+            double freeze_ms = elapsed_ms(start);
+
+            print_header("Frozen index, n = " + to_string(n), {"Index", "find Mops/s", "build ms"});
+            print_row("AVLTree<arena>", {time_index_lookups(avl, probes), avl_ms});
+            print_row("BPlusTree", {time_index_lookups(bpt, probes), bpt_ms});
+            print_row("FrozenIndex (from AVL)", {time_index_lookups(frozen, probes), freeze_ms});
+        }
+    }
+
+    // --- Sequential keys: the issue order of user IDs, worst case for the plain BST ---
+
+    template<typename Tree>
+    static vector<double> time_sequential(int n) {
+        // milliseconds per phase: the chain makes per-op rates meaningless for the BST
+        vector<double> row;
+        Tree tree;
+        auto start = Clock::now();
+        for (int k = 0; k < n; ++k) tree.insert(k, k);
+        row.push_back(elapsed_ms(start));
+
+        start = Clock::now();
+        long long found = 0;
+        for (int k = 0; k < n; ++k) found += tree.find(k) != nullptr;
+        row.push_back(elapsed_ms(start));
+        if (found != n) cout << "  [warn] lookups missed keys" << endl;
+
+        start = Clock::now();
+        size_t total = tree.inOrderTraversal().size() + tree.findRange(0, n).size();
+        row.push_back(elapsed_ms(start));
+        if (total != 2 * (size_t)n) cout << "  [warn] traversal missed keys" << endl;
+
+        start = Clock::now();
+        tree.clear();
+        row.push_back(elapsed_ms(start));
+        return row;
+    }
+
+    void bench_sequential_keys() {
+        // The unbalanced BST degenerates into a chain and is O(n) per operation,
+        // so it gets a smaller n. Its old recursive helpers overflowed the stack
+        // at this depth.
+        const vector<string> columns = {"Tree", "insert ms", "find ms", "traverse ms", "clear ms"};
+        const int chain_n = 100000;
+        print_header("Sequential keys, n = " + to_string(chain_n), columns);
+        print_row("BST<shared_ptr>", time_sequential<BST<int, int>>(chain_n));
+        print_row("BST<arena>", time_sequential<BST<int, int, less<int>, ArenaNodeStorage>>(chain_n));
+        print_row("AVLTree<arena>", time_sequential<AVLTree<int, int, less<int>, ArenaNodeStorage>>(chain_n));
+
+        const int n = 10000000;
+        print_header("Sequential keys, n = " + to_string(n), columns);
+        print_row("AVLTree<shared_ptr>", time_sequential<AVLTree<int, int>>(n));
+        print_row("AVLTree<arena>", time_sequential<AVLTree<int, int, less<int>, ArenaNodeStorage>>(n));
+    }
+
+    // --- Balancing schemes: one recorded operation mix replayed on BST, AVL and RB ---
+
+    struct TreeOp {
+        enum Kind { Insert, Remove, Find } kind;
+        int key;
+    };
+
+    // Write-heavy churn: 40% inserts, 40% removes, 20% lookups. With
+    // sequentialInserts the new keys keep increasing, like freshly issued user IDs.
+    static vector<TreeOp> churn_mix(int initial, int ops, bool sequentialInserts, unsigned seed) {
+        mt19937 rng(seed);
+        vector<TreeOp> mix;
+        mix.reserve(ops);
+        int nextKey = initial;
+        for (int i = 0; i < ops; ++i) {
+            unsigned roll = rng() % 10;
+            int existing = rng() % nextKey;
+            if (roll < 4)
+                mix.push_back({TreeOp::Insert, sequentialInserts ? nextKey++ : (int)(rng() % (4 * initial))});
+            else if (roll < 8)
+                mix.push_back({TreeOp::Remove, existing});
+            else
+                mix.push_back({TreeOp::Find, existing});
+        }
+        return mix;
+    }
+
+    template<typename Tree>
+    static vector<double> replay_mix(const vector<int>& initialKeys, const vector<TreeOp>& mix) {
+        Tree tree;
+        for (int k : initialKeys) tree.insert(k, k);
+        size_t rotationsBefore = tree.getStats().rotations;
+        size_t updates = 0;
+        long long found = 0;
+        auto start = Clock::now();
+        for (const TreeOp& op : mix) {
+            switch (op.kind) {
+            case TreeOp::Insert: tree.insert(op.key, op.key); updates++; break;
+            case TreeOp::Remove: tree.remove(op.key); updates++; break;
+            case TreeOp::Find: found += tree.find(op.key) != nullptr; break;
+            }
+        }
+        double ms = elapsed_ms(start);
+        if (found < 0) cout << "  [warn] impossible lookup count" << endl;
+        double rotationsPerUpdate = updates ? (double)(tree.getStats().rotations - rotationsBefore) / updates : 0.0;
+        return {mops(mix.size(), ms), rotationsPerUpdate, (double)tree.getTreeHeight()};
+    }
+
+    void bench_balancing() {
+        const int initial = 100000, ops = 1000000;
+        vector<int> initialKeys = shuffled_keys(initial, 14);
+        const vector<string> columns = {"Tree", "Mops/s", "rot/update", "final height"};
+        if (!treeStatsEnabled)
+            cout << "\n(rot/update reads TreeStats and stays 0 here; `make bench-stats` builds with -DTREE_STATS)" << endl;
+
+        vector<TreeOp> random = churn_mix(initial, ops, false, 15);
+        print_header("Random churn, " + to_string(initial) + " keys + " + to_string(ops) + " ops", columns);
+        print_row("BST<arena>", replay_mix<BST<int, int, less<int>, ArenaNodeStorage>>(initialKeys, random));
+        print_row("AVLTree<arena>", replay_mix<AVLTree<int, int, less<int>, ArenaNodeStorage>>(initialKeys, random));
+        print_row("RBTree<arena>", replay_mix<RBTree<int, int, less<int>, ArenaNodeStorage>>(initialKeys, random));
+
+        // the plain BST turns the increasing inserts into a chain (O(n) per op), so it sits this one out
+        vector<TreeOp> sequential = churn_mix(initial, ops, true, 16);
+        print_header("Sequential-ID churn, " + to_string(initial) + " keys + " + to_string(ops) + " ops", columns);
+        print_row("AVLTree<arena>", replay_mix<AVLTree<int, int, less<int>, ArenaNodeStorage>>(initialKeys, sequential));
+        print_row("RBTree<arena>", replay_mix<RBTree<int, int, less<int>, ArenaNodeStorage>>(initialKeys, sequential));
+    }
+
+    // --- Augmented AVL: range sums from subtree summaries vs visiting every entry ---
+
+    void bench_range_aggregate() {
+        const int n = 1000000, queries = 2000;
+        vector<int> keys = shuffled_keys(n, 9);
+        AVLTree<int, int, less<int>, ArenaNodeStorage> plain;
+        AVLTree<int, int, less<int>, ArenaNodeStorage, ValueSum> summed;
+        auto start = Clock::now();
+        for (int k : keys) plain.insert(k, k);
+        double plain_ms = elapsed_ms(start);
+        start = Clock::now();
+        for (int k : keys) summed.insert(k, k);
+        double summed_ms = elapsed_ms(start);
+        print_header("Augmented AVL insert, n = " + to_string(n), {"Tree", "insert Mops/s"});
+        print_row("AVLTree<arena>", {mops(n, plain_ms)});
+        print_row("AVLTree<arena, ValueSum>", {mops(n, summed_ms)});
+
+        print_header("Range sum, " + to_string(queries) + " queries (us/query)", {"Range width", "scan", "aggregateRange"});
+        mt19937 rng(10);
+        for (int width : {100, 1000, 10000}) {
+            vector<int> lows(queries);
+            for (int& lo : lows) lo = rng() % (n - width);
+            long long scanned = 0, aggregated = 0;
+            start = Clock::now();
+            for (int lo : lows)
+                plain.forEachInRange(lo, lo + width - 1, [&](const int&, const int& value) { scanned += value; return true; });
+            double scan_ms = elapsed_ms(start);
+            start = Clock::now();
+            for (int lo : lows) aggregated += summed.aggregateRange(lo, lo + width - 1);
+            double aggregate_ms = elapsed_ms(start);
+            if (scanned != aggregated) cout << "  [warn] range sums disagree" << endl;
+            print_row(to_string(width), {scan_ms * 1000 / queries, aggregate_ms * 1000 / queries});
+        }
+    }
+
+    // --- Batch updates: one insertBatch/removeBatch call vs a loop of single updates ---
+
+    template<typename Tree>
+    static vector<double> time_batch_vs_loop(const vector<pair<int, int>>& base, const vector<pair<int, int>>& batch) {
+        vector<int> keys;
+        for (const auto& entry : batch) keys.push_back(entry.first);
+        vector<double> row;
+        for (bool batched : {false, true}) {
+            Tree tree;
+            tree.buildFromSorted(base.begin(), base.end());
+            auto start = Clock::now();
+            if (batched) tree.insertBatch(batch);
+            else for (const auto& entry : batch) tree.insert(entry.first, entry.second);
+            row.push_back(elapsed_ms(start));
+            start = Clock::now();
+            if (batched) tree.removeBatch(keys);
+            else for (int k : keys) tree.remove(k);
+            row.push_back(elapsed_ms(start));
+            if (tree.size() != base.size()) cout << "  [warn] batch left the tree at the wrong size" << endl;
+        }
+        return row;
+    }
+
+    void bench_batch_updates() {
+        // even keys are already in the tree, the batch brings odd ones
+        const int n = 200000;
+        vector<pair<int, int>> base;
+        for (int i = 0; i < n; ++i) base.emplace_back(2 * i, i);
+        const vector<string> columns = {"Batch size", "loop insert", "insertBatch", "loop remove", "removeBatch"};
+        for (const string& name : {string("AVLTree<arena>"), string("BPlusTree")}) {
+            print_header(name + ", n = " + to_string(n) + " (ms)", columns);
+            for (int m : {1000, 20000, 200000}) {
+                vector<pair<int, int>> batch;
+                for (int k : shuffled_keys(n, 11)) {
+                    if ((int)batch.size() == m) break;
+                    batch.emplace_back(2 * k + 1, k);
+                }
+                vector<double> row = name == "BPlusTree"
+                    ? time_batch_vs_loop<BPlusTree<int, int>>(base, batch)
+                    : time_batch_vs_loop<AVLTree<int, int, less<int>, ArenaNodeStorage>>(base, batch);
+                print_row(to_string(m), {row[0], row[2], row[1], row[3]});
+            }
+        }
+    }
+
+    // --- Username keys: a string copy per node vs an InternedString handle ---
+
+    // Mostly team_/bot_/official_-style names sharing a prefix, the rest bare handles
+    static vector<string> usernames(int n, unsigned seed) {
+        static const char* prefixes[] = {"team_", "bot_", "official_", "support_", "dev_", "news_", "fan_", "store_"};
+        static const char* words[] = {"alpha", "nova", "river", "pixel", "atlas", "ember", "orbit", "cedar"};
+        mt19937 rng(seed);
+        vector<string> names;
+        names.reserve(n);
+        for (int i = 0; i < n; ++i) {
+            string name = rng() % 10 < 7 ? prefixes[rng() % 8] : "";
+            name += words[rng() % 8];
+            name += to_string(i);
+            names.push_back(std::move(name));
+        }
+        return names;
+    }
+
+    template<typename Tree>
+    static double time_name_lookups(const Tree& tree, const vector<string_view>& probes) {
+        auto start = Clock::now();
+        long long found = 0;
+        for (string_view probe : probes) found += tree.find(probe) != nullptr;
+        double ms = elapsed_ms(start);
+        if (found != (long long)probes.size()) cout << "  [warn] lookups missed keys" << endl;
+        return mops(probes.size(), ms);
+    }
+
+    void bench_name_keys() {
+        using StringTree = AVLTree<string, int, less<string>, ArenaNodeStorage>;
+        using InternedTree = AVLTree<InternedString, int, InternedStringCompare, ArenaNodeStorage>;
+        const size_t stringNode = sizeof(BST<string, int, less<string>, ArenaNodeStorage>::BSTNode);
+        const size_t internedNode = sizeof(BST<InternedString, int, InternedStringCompare, ArenaNodeStorage>::BSTNode);
+        const int n = 5000000;
+        vector<string> names = usernames(n, 12);
+
+        // footprint only: what each index would hold for all n names
+        size_t copied = 0;
+        for (const string& name : names)
+            copied += name.size() > string().capacity() ? name.size() + 1 : 0;
+        StringArena arena;
+        for (const string& name : names) arena.intern(name);
+        print_header("Name keys, n = " + to_string(n), {"Key", "node bytes", "key heap MB", "total MB"});
+        const double MB = 1024.0 * 1024.0;
+        print_row("string", {(double)stringNode, copied / MB, (n * stringNode + copied) / MB});
+        print_row("InternedString", {(double)internedNode, arena.memoryUsage() / MB, (n * internedNode + arena.memoryUsage()) / MB});
+
+        // lookups: every comparison of the interned tree reads through the arena
+        const int m = 500000;
+        vector<string> sorted(names.begin(), names.begin() + m);
+        sort(sorted.begin(), sorted.end());
+        vector<pair<string, int>> stringEntries;
+        StringArena treeArena;
+        vector<pair<InternedString, int>> internedEntries;
+        for (const string& name : sorted) {
+            stringEntries.emplace_back(name, 0);
+            internedEntries.emplace_back(treeArena.intern(name), 0);
+        }
+        StringTree byString;
+        byString.buildFromSorted(stringEntries.begin(), stringEntries.end());
+        InternedTree byHandle(InternedStringCompare{&treeArena});
+        byHandle.buildFromSorted(internedEntries.begin(), internedEntries.end());
+        vector<string_view> probes(names.begin(), names.begin() + m);
+        shuffle(probes.begin(), probes.end(), mt19937(13));
+        print_header("Name lookups, n = " + to_string(m), {"Key", "find Mops/s"});
+        print_row("string", {time_name_lookups(byString, probes)});
+        print_row("InternedString", {time_name_lookups(byHandle, probes)});
+    }
+
+    // The engine's own report for 5M users, in the name key mode this binary
+    // was built with; `make bench-names` runs it for both modes
+    void bench_name_key_engine() {
+        const int n = 5000000;
+        vector<string> names = usernames(n, 12);
+        vector<unique_ptr<User>> users;
+        vector<User*> members;
+        users.reserve(n);
+        members.reserve(n);
+        for (int i = 0; i < n; ++i) {
+            users.push_back(make_unique<User>(i, names[i]));
+            members.push_back(users.back().get());
+        }
+        names = vector<string>();
+
+        cout << "\n--- Populated engine, n = " << n << ", "
+             << (is_same<NameKey, InternedString>::value ? "interned" : "string") << " name keys ---" << endl;
+        auto start = Clock::now();
+        UserSearchEngine engine;
+        engine.addUsers(members);
+        cout << "addUsers: " << fixed << setprecision(0) << elapsed_ms(start) << " ms" << endl;
+        cout << defaultfloat << setprecision(6);  // the stats print in the stream's default format
+        engine.displaySearchStats();
+    }
+
+    // --- Cold start: rebuilding an index vs loading its saveBinary snapshot ---
+
+    // ms to fill a fresh tree from unsorted entries one insert at a time, with
+    // one insertBatch, and from the snapshot at path (read through the page cache)
+    template<typename Tree, typename K, typename V>
+    static vector<double> time_cold_start(const vector<pair<K, V>>& entries, const string& path) {
+        auto start = Clock::now();
+        Tree byInsert;
+        for (const auto& entry : entries) byInsert.insert(entry.first, entry.second);
+        double insertMs = elapsed_ms(start);
+
+        start = Clock::now();
+        Tree byBatch;
+        byBatch.insertBatch(entries);
+        double batchMs = elapsed_ms(start);
+
+        byBatch.saveBinary(path);
+        start = Clock::now();
+        Tree byLoad;
+        bool loaded = byLoad.loadBinary(path);
+        double loadMs = elapsed_ms(start);
+        if (!loaded || byLoad.size() != byInsert.size()) cout << "  (snapshot load failed)" << endl;
+        return {insertMs, batchMs, loadMs, std::filesystem::file_size(path) / (1024.0 * 1024.0)};
+    }
+
+    void bench_cold_start() {
+        const int n = 1000000;
+        const string path = (std::filesystem::temp_directory_path() / "benchmark_snapshot.bin").string();
+        vector<pair<int, int>> ids;
+        for (int key : shuffled_keys(n, 17)) ids.emplace_back(key, key);
+        vector<pair<string, int>> names;
+        for (string& name : usernames(n, 18)) names.emplace_back(std::move(name), (int)names.size());
+
+        print_header("Cold start, n = " + to_string(n) + " (ms)", {"Index", "insert", "insertBatch", "loadBinary", "file MB"});
+        print_row("AVLTree<int, int>", time_cold_start<AVLTree<int, int, less<int>, ArenaNodeStorage>>(ids, path));
+        print_row("AVLTree<string, int>", time_cold_start<AVLTree<string, int, less<string>, ArenaNodeStorage>>(names, path));
+        print_row("BPlusTree<int, int>", time_cold_start<BPlusTree<int, int>>(ids, path));
+
+        // the ID snapshot again, served in place: only the Eytzinger keys are built
+        AVLTree<int, int, less<int>, ArenaNodeStorage> source;
+        source.buildFrom(ids.begin(), ids.end());
+        source.saveBinary(path);
+        auto start = Clock::now();
+        FrozenIndex<int, int> mapped;
+        bool ok = mapped.mapFile(path);
+        double mapMs = elapsed_ms(start);
+        print_header("Read-only start, n = " + to_string(n) + " (ms)", {"Index", "mapFile"});
+        print_row(ok ? "FrozenIndex<int, int>" : "FrozenIndex (map failed)", {mapMs});
+        std::remove(path.c_str());
+    }
+
+    // --- Whole-tree walks split into subtree tasks on a thread pool ---
+
+    // ms for each whole-tree walk, through the given pool (nullptr: the serial forms)
+    template<typename Tree>
+    static vector<double> time_walks(const Tree& tree, ThreadPool* threads, bool& matches) {
+        auto start = Clock::now();
+        vector<pair<int, int>> entries = threads ? tree.inOrderTraversal(*threads) : tree.inOrderTraversal();
+        double traverseMs = elapsed_ms(start);
+        start = Clock::now();
+        bool valid = threads ? tree.isValidAVL(*threads) : tree.isValidAVL();
+        double validateMs = elapsed_ms(start);
+        start = Clock::now();
+        int maxDepth = threads ? tree.getMaxDepth(*threads) : tree.getMaxDepth();
+        double depthMs = elapsed_ms(start);
+        matches = matches && valid && entries.size() == tree.size() && maxDepth == tree.getTreeHeight();
+        return {traverseMs, validateMs, depthMs};
+    }
+
+    void bench_parallel_walks() {
+        const int n = 4000000;
+        AVLTree<int, int, less<int>, ArenaNodeStorage> tree;
+        vector<pair<int, int>> entries;
+        for (int key : shuffled_keys(n, 19)) entries.emplace_back(key, key);
+        tree.buildFrom(entries.begin(), entries.end());
+
+        print_header("Parallel walks, n = " + to_string(n) + ", " + to_string(thread::hardware_concurrency()) + " cores (ms)",
+                     {"Threads", "traversal", "isValidAVL", "getMaxDepth"});
+        bool matches = true;
+        print_row("serial", time_walks(tree, nullptr, matches));
+        for (size_t threadCount : {1, 2, 4, 8, 16, 32}) {
+            ThreadPool threads(threadCount);
+            print_row(to_string(threadCount), time_walks(tree, &threads, matches));
+        }
+        if (!matches) cout << "  (a walk returned a wrong result)" << endl;
+    }
+
+    // --- Finger search: a cursor resuming from its last position vs find from the root ---
+
+    // Mops for probes through find, or through one cursor when byCursor
+    template<typename Index>
+    static double time_seeks(const Index& index, const vector<int>& probes, bool byCursor) {
+        long long found = 0;
+        auto cursor = index.cursor();
+        auto start = Clock::now();
+        for (int k : probes) found += (byCursor ? cursor.seek(k) : index.find(k)) != nullptr;
+        double ms = elapsed_ms(start);
+        if (found != (long long)probes.size()) cout << "  [warn] lookups missed keys" << endl;
+        return mops(probes.size(), ms);
+    }
+
+    void bench_finger_search() {
+        const int n = 1000000;
+        // bulk loaded, as migrateFromLinkedList / addUsers build the engine's indexes
+        vector<pair<int, int>> entries;
+        for (int i = 0; i < n; ++i) entries.emplace_back(i, i);
+        AVLTree<int, int, less<int>, ArenaNodeStorage> avl;
+        avl.buildFrom(entries.begin(), entries.end());
+        BPlusTree<int, int> bpt;
+        bpt.buildFromSorted(entries.begin(), entries.end());
+        vector<int> ascending(n);
+        for (int i = 0; i < n; ++i) ascending[i] = i;
+        vector<int> nearlySorted = ascending;  // shuffled within windows of 64
+        mt19937 rng(24);
+        for (int i = 0; i < n; i += 64) shuffle(nearlySorted.begin() + i, nearlySorted.begin() + std::min(n, i + 64), rng);
+        vector<int> strided;  // every 97th ID, wrapping around
+        for (long long i = 0; i < n; ++i) strided.push_back((int)(i * 97 % n));
+
+        print_header("Finger search, n = " + to_string(n) + " (Mops/s)", {"Probe order", "AVL find", "AVL cursor", "B+ find", "B+ cursor"});
+        vector<pair<string, vector<int>>> orders = {{"ascending", ascending}, {"nearly sorted", nearlySorted},
+                                                    {"stride 97", strided}, {"random", shuffled_keys(n, 25)}};
+        for (const auto& order : orders)
+            print_row(order.first, {time_seeks(avl, order.second, false), time_seeks(avl, order.second, true),
+                                    time_seeks(bpt, order.second, false), time_seeks(bpt, order.second, true)});
+    }
+
+    // --- Prefix search: ordered name tree vs compressed radix trie ---
+
+    // k queries/s for the first 10 completions, the match count, and every match
+    // of each prefix. The tree answers all three from lower_bound plus a walk,
+    // as the engine's name index did; total feeds a cross-check.
+    template<typename Query>
+    static vector<double> time_prefix_queries(const vector<string>& prefixes, Query query, size_t& total) {
+        vector<double> rates;
+        for (int kind = 0; kind < 3; ++kind) {
+            auto start = Clock::now();
+            for (const string& prefix : prefixes) total += query(kind, prefix);
+            rates.push_back(mops(prefixes.size(), elapsed_ms(start)) * 1000.0);
+        }
+        return rates;
+    }
+
+    void bench_prefix_search() {
+        const int n = 1000000;
+        vector<string> names = usernames(n, 26);
+        AVLTree<string, int, less<string>, ArenaNodeStorage> tree;
+        RadixTrie<int> trie;
+        for (int i = 0; i < n; ++i) {
+            tree.insert(names[i], i);
+            trie.insert(names[i], i);
+        }
+        // autocomplete-style prefixes: 2 to 7 leading bytes of existing names
+        mt19937 rng(27);
+        vector<string> prefixes;
+        for (int i = 0; i < 2000; ++i) {
+            const string& name = names[rng() % n];
+            prefixes.push_back(name.substr(0, 2 + rng() % 6));
+        }
+
+        auto treeQuery = [&](int kind, const string& prefix) {
+            size_t found = 0;
+            for (auto it = tree.lower_bound(prefix); it != tree.end() && it->key.compare(0, prefix.size(), prefix) == 0; ++it) {
+                if (kind == 0 && found == 10) break;
+                found += kind == 2 ? it->value >= 0 : 1;
+            }
+            return found;
+        };
+        auto trieQuery = [&](int kind, const string& prefix) -> size_t {
+            if (kind == 1) return trie.countWithPrefix(prefix);
+            return trie.withPrefix(prefix, 0, kind == 0 ? 10 : SIZE_MAX).size();
+        };
+        size_t treeTotal = 0, trieTotal = 0;
+        print_header("Prefix search, n = " + to_string(n) + " names (k queries/s)", {"Index", "first 10", "count", "all matches"});
+        print_row("AVLTree<string>", time_prefix_queries(prefixes, treeQuery, treeTotal));
+        print_row("RadixTrie", time_prefix_queries(prefixes, trieQuery, trieTotal));
+        if (treeTotal != trieTotal) cout << "  [warn] the indexes disagree" << endl;
+    }
+
+    // --- Fuzzy search: Levenshtein scan over every name vs BK-tree ---
+
+    void bench_fuzzy_search() {
+        const int n = 200000;
+        vector<string> names = usernames(n, 28);
+        BKTree<int> tree;
+        auto start = Clock::now();
+        for (int i = 0; i < n; ++i) tree.insert(names[i], i);
+        double buildMs = elapsed_ms(start);
+        // queries are existing names with one byte changed, as a typo would
+        mt19937 rng(29);
+        vector<string> queries;
+        for (int i = 0; i < 40; ++i) {
+            string query = names[rng() % n];
+            query[rng() % query.size()] = 'a' + rng() % 26;
+            queries.push_back(query);
+        }
+
+        LevenshteinDistance distance;
+        print_header("Fuzzy search, n = " + to_string(n) + " names, BK-tree built in " + to_string((int)buildMs) + " ms (per query)",
+                     {"maxDistance", "scan ms", "BK-tree ms", "distances", "matches"});
+        for (int maxDistance = 1; maxDistance <= 3; ++maxDistance) {
+            size_t scanMatches = 0, treeMatches = 0, computed = 0;
+            start = Clock::now();
+            for (const string& query : queries)
+                for (const string& name : names) scanMatches += distance(query, name) <= maxDistance;
+            double scanMs = elapsed_ms(start);
+            start = Clock::now();
+            for (const string& query : queries)
+                computed += tree.forEachWithin(query, maxDistance, [&](int, int) { treeMatches++; });
+            double treeMs = elapsed_ms(start);
+            double perQuery = 1.0 / queries.size();
+            print_row(to_string(maxDistance), {scanMs * perQuery, treeMs * perQuery, computed * perQuery, treeMatches * perQuery});
+            if (scanMatches != treeMatches) cout << "  [warn] the BK-tree and the scan disagree" << endl;
+        }
+    }
+
+    // --- Edit distance kernels: classic DP vs Myers bit-vector ---
+
+    // M pairs/s for score(query index, name) over every query x name pair;
+    // sum feeds a cross-check between the kernels
+    template<typename Score>
+    static double time_pairs(size_t queries, const vector<string>& names, Score score, long long& sum) {
+        auto start = Clock::now();
+        for (size_t q = 0; q < queries; ++q)
+            for (const string& name : names) sum += score(q, name);
+        return mops(queries * names.size(), elapsed_ms(start));
+    }
+
+    void bench_edit_distance() {
+        const int n = 20000;
+        vector<string> names = usernames(n, 30);
+        vector<string> longNames;  // past one 64-bit word
+        for (int i = 0; i + 4 <= n; i += 4) longNames.push_back(names[i] + names[i + 1] + names[i + 2] + names[i + 3] + names[i] + names[i + 1]);
+        mt19937 rng(31);
+        vector<string> queries, longQueries;
+        for (int i = 0; i < 50; ++i) {
+            string query = names[rng() % n];
+            query[rng() % query.size()] = 'a' + rng() % 26;
+            queries.push_back(query);
+            longQueries.push_back(longNames[rng() % longNames.size()]);
+            longQueries.back()[rng() % longQueries.back().size()] = 'a' + rng() % 26;
+        }
+        vector<MyersPattern> patterns, longPatterns;
+        for (size_t q = 0; q < queries.size(); ++q) {
+            patterns.emplace_back(queries[q]);
+            longPatterns.emplace_back(longQueries[q]);
+        }
+
+        LevenshteinDistance distance;
+        auto classic = [&](const vector<string>& qs) { return [&](size_t q, const string& name) { return classicEditDistance(qs[q], name); }; };
+        auto perPair = [&](const vector<string>& qs) { return [&](size_t q, const string& name) { return distance(qs[q], name); }; };
+        auto prepared = [](const vector<MyersPattern>& ps) { return [&](size_t q, const string& name) { return ps[q].distance(name); }; };
+        auto banded = [](const vector<MyersPattern>& ps) { return [&](size_t q, const string& name) { return std::min(ps[q].distance(name, 2), 3); }; };
+
+        print_header("Edit distance kernels, " + to_string(queries.size()) + " queries x names (M pairs/s)",
+                     {"Kernel", "names <= 30 B", "names ~ 120 B"});
+        long long sum = 0, longSum = 0, check = 0, longCheck = 0;
+        print_row("classic DP", {time_pairs(queries.size(), names, classic(queries), sum),
+                                 time_pairs(longQueries.size(), longNames, classic(longQueries), longSum)});
+        print_row("Myers, per pair", {time_pairs(queries.size(), names, perPair(queries), check),
+                                      time_pairs(longQueries.size(), longNames, perPair(longQueries), longCheck)});
+        if (check != sum || longCheck != longSum) cout << "  [warn] Myers and the DP disagree" << endl;
+        check = longCheck = 0;
+        print_row("Myers, prepared query", {time_pairs(queries.size(), names, prepared(patterns), check),
+                                            time_pairs(longQueries.size(), longNames, prepared(longPatterns), longCheck)});
+        if (check != sum || longCheck != longSum) cout << "  [warn] Myers and the DP disagree" << endl;
+        check = longCheck = 0;
+        print_row("Myers, banded at 2", {time_pairs(queries.size(), names, banded(patterns), check),
+                                         time_pairs(longQueries.size(), longNames, banded(longPatterns), longCheck)});
+
+        // one query against 8 names per step, as the BK-tree scores its frontier
+        vector<string_view> views(names.begin(), names.end());
+        vector<int> scores(views.size());
+        check = 0;
+        auto start = Clock::now();
+        for (const MyersPattern& pattern : patterns) {
+            pattern.distances(views.data(), views.size(), scores.data());
+            for (int score : scores) check += score;
+        }
+        string label = patterns[0].batchWidth() > 1 ? "Myers, AVX2 x" + to_string(patterns[0].batchWidth()) : "Myers, batch (scalar)";
+        print_row(label, {mops(patterns.size() * views.size(), elapsed_ms(start))});
+        if (check != sum) cout << "  [warn] the batch and the DP disagree" << endl;
+    }
+
+    // --- Substring search: scan over every name vs trigram posting lists ---
+
+    void bench_substring_search() {
+        const int n = 200000;
+        vector<string> names = usernames(n, 37);
+        TrigramIndex index;
+        auto start = Clock::now();
+        for (int i = 0; i < n; ++i) index.insert(i, names[i]);
+        double buildMs = elapsed_ms(start);
+        size_t postings = 0;
+        for (const string& name : names) postings += name.size() >= 3 ? name.size() - 2 : 0;  // upper bound, repeats counted
+
+        // slices of existing names: 3 bytes match many names, 6 bytes a few
+        mt19937 rng(38);
+        print_header("Substring search, n = " + to_string(n) + " names, " + to_string(index.trigramCount()) + " trigrams, " +
+                         to_string(index.byteCount() / 1024) + " KiB of postings (" + to_string(postings * 4 / 1024) +
+                         " KiB as int arrays), built in " + to_string((int)buildMs) + " ms (per query)",
+                     {"Pattern length", "scan ms", "trigram ms", "candidates", "matches"});
+        for (size_t length = 3; length <= 6; ++length) {
+            vector<string> patterns;
+            while (patterns.size() < 50) {
+                const string& name = names[rng() % n];
+                if (name.size() >= length) patterns.push_back(name.substr(rng() % (name.size() - length + 1), length));
+            }
+            size_t scanMatches = 0, indexMatches = 0, candidates = 0;
+            start = Clock::now();
+            for (const string& pattern : patterns)
+                for (const string& name : names) scanMatches += name.find(pattern) != string::npos;
+            double scanMs = elapsed_ms(start);
+            start = Clock::now();
+            for (const string& pattern : patterns) {
+                vector<int> ids = index.candidates(pattern);
+                candidates += ids.size();
+                for (int id : ids) indexMatches += names[id].find(pattern) != string::npos;
+            }
+            double indexMs = elapsed_ms(start);
+            double perQuery = 1.0 / patterns.size();
+            print_row(to_string(length), {scanMs * perQuery, indexMs * perQuery, candidates * perQuery, indexMatches * perQuery});
+            if (scanMatches != indexMatches) cout << "  [warn] the index and the scan disagree" << endl;
+        }
+    }
+
+    // --- Ranked fuzzy search: every match then sort vs bounded best-first walk ---
+
+    void bench_fuzzy_top_k() {
+        const int n = 200000;
+        const size_t k = 10;
+        mt19937 rng(42);
+        vector<int> popularity(n);
+        for (int& posts : popularity) posts = rng() % 1000;
+        // Full names with one byte changed have a few dozen matches within 3;
+        // short handles built from a few syllables and 3-4 byte queries have
+        // thousands, most of which a top-k search never needs to score
+        vector<string> typos, handles, shortQueries;
+        vector<string> names = usernames(n, 41);
+        for (int i = 0; i < 40; ++i) {
+            string query = names[rng() % n];
+            query[rng() % query.size()] = 'a' + rng() % 26;
+            typos.push_back(query);
+        }
+        static const char* syllables[] = {"ka", "to", "ri", "mo", "na", "le", "su", "ji", "ba", "po", "ne", "vi", "da", "xo", "fe", "gu"};
+        set<string> distinct;
+        while (distinct.size() < (size_t)n) {
+            string handle;
+            for (int s = 2 + rng() % 4; s > 0; --s) handle += syllables[rng() % 16];
+            distinct.insert(handle);
+        }
+        handles.assign(distinct.begin(), distinct.end());
+        shuffle(handles.begin(), handles.end(), rng);
+        for (int i = 0; i < 40; ++i) shortQueries.push_back(syllables[rng() % 16] + string(syllables[rng() % 16]).substr(0, 1 + i % 2));
+        time_fuzzy_top_k("full names, one-byte typos", names, typos, popularity, k);
+        time_fuzzy_top_k("short handles, 3-4 byte queries", handles, shortQueries, popularity, k);
+    }
+
+    static void time_fuzzy_top_k(const string& workload, const vector<string>& names, const vector<string>& queries,
+                                 const vector<int>& popularity, size_t k) {
+        BKTree<int> tree;
+        for (size_t i = 0; i < names.size(); ++i) tree.insert(names[i], (int)i);
+        auto better = [&](const pair<int, int>& a, const pair<int, int>& b) {  // (distance, name index)
+            return a.first != b.first ? a.first < b.first : popularity[a.second] != popularity[b.second] ? popularity[a.second] > popularity[b.second] : a.second < b.second;
+        };
+
+        print_header("Fuzzy top-" + to_string(k) + ", " + to_string(names.size()) + " " + workload + " (per query)",
+                     {"maxDistance", "all+sort ms", "top-k ms", "all distances", "top-k distances"});
+        for (int maxDistance = 1; maxDistance <= 3; ++maxDistance) {
+            size_t allComputed = 0, topComputed = 0, mismatches = 0;
+            vector<vector<pair<int, int>>> sorted;
+            auto start = Clock::now();
+            for (const string& query : queries) {
+                vector<pair<int, int>> matches;
+                allComputed += tree.forEachWithin(query, maxDistance, [&](int i, int d) { matches.emplace_back(d, i); });
+                size_t keep = std::min(k, matches.size());
+                partial_sort(matches.begin(), matches.begin() + keep, matches.end(), better);
+                matches.resize(keep);
+                sorted.push_back(std::move(matches));
+            }
+            double allMs = elapsed_ms(start);
+            start = Clock::now();
+            for (size_t q = 0; q < queries.size(); ++q) {
+                vector<pair<int, int>> best;
+                topComputed += tree.forEachNearest(queries[q], maxDistance, [&](int i, int d) {
+                    pair<int, int> candidate(d, i);
+                    if (best.size() < k) {
+                        best.push_back(candidate);
+                        push_heap(best.begin(), best.end(), better);
+                    } else if (better(candidate, best.front())) {
+                        pop_heap(best.begin(), best.end(), better);
+                        best.back() = candidate;
+                        push_heap(best.begin(), best.end(), better);
+                    }
+                    return best.size() < k ? maxDistance : best.front().first;
+                });
+                sort_heap(best.begin(), best.end(), better);
+                mismatches += best != sorted[q];
+            }
+            double topMs = elapsed_ms(start);
+            double perQuery = 1.0 / queries.size();
+            print_row(to_string(maxDistance), {allMs * perQuery, topMs * perQuery, allComputed * perQuery, topComputed * perQuery});
+            if (mismatches) cout << "  [warn] the bounded search and the full sort disagree" << endl;
+        }
+    }
+};
+
+int main(int argc, char* argv[]) {
+    BenchmarkRunner runner;
+    if (argc > 1 && string(argv[1]) == "name-keys")
+        runner.run_name_keys();
+    else
+        runner.run_all();
+    return 0;
+}
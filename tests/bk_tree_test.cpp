@@ -0,0 +1,136 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <random>
+#include <map>
+#include <climits>
+
+#include "bk_tree.h"
+
+using namespace std;
+
+/**
+ * @class TestRunner
+ * @brief Checks BKTree searches against a Levenshtein scan over every live key.
+ */
+class TestRunner {
+public:
+    TestRunner() : total_score(0), max_score(0) {}
+
+    void run_all_tests() {
+        cout << "=======================================================================" << endl;
+        cout << "                 BK-Tree Fuzzy Index Tester" << endl;
+        cout << "=======================================================================" << endl;
+
+        test_correctness();
+
+        cout << "\n-----------------------------------------------------------------------" << endl;
+        cout << "                           TESTING SUMMARY" << endl;
+        cout << "-----------------------------------------------------------------------" << endl;
+        cout << "  FINAL SCORE: " << total_score << " / " << max_score << endl;
+        if (total_score == max_score) {
+            cout << "  RESULT: All correctness tests passed!" << endl;
+        } else {
+            cout << "  RESULT: Some correctness tests failed." << endl;
+        }
+        cout << "=======================================================================" << endl;
+    }
+
+private:
+    int total_score;
+    int max_score;
+
+    void execute_correctness_test(const string& name, int points, const string& desc, const function<bool()>& test_func) {
+        max_score += points;
+        cout << "\n  - " << name << " [" << points << " pts]" << endl;
+        cout << "    " << desc << endl;
+        cout << "    Running test... ";
+        if (test_func()) {
+            cout << "PASSED" << endl;
+            total_score += points;
+        } else {
+            cout << "FAILED" << endl;
+        }
+    }
+
+    void test_correctness() {
+        cout << "\n--- Fuzzy Searches against a Full Scan ---" << endl;
+
+        execute_correctness_test("BK-Tree Fuzzy Index", 10, "forEachWithin finds exactly the keys within distance 0-3 that a Levenshtein scan finds, and forEachNearest the closest three, under random churn.", []() {
+            return run_bk_tree_scenario();
+        });
+    }
+
+    // Keys over five letters sit at every small distance from each other.
+    // Each search must return exactly the keys a scan with the metric finds.
+    static bool run_bk_tree_scenario() {
+        LevenshteinDistance distance;
+        if (distance("kitten", "sitting") != 3 || distance("", "abc") != 3 || distance("flaw", "lawn") != 2 || distance("same", "same") != 0)
+            return false;
+        BKTree<int> tree;
+        map<string, int> expected;
+        mt19937 rng(43);
+        auto random_key = [&]() {
+            string key;
+            for (int i = rng() % 8; i > 0; --i) key += "abcde"[rng() % 5];
+            return key;
+        };
+        for (int step = 0; step < 12000; ++step) {
+            string key = random_key();
+            if (rng() % 3 < 2) {
+                if (tree.insert(key, step) != expected.emplace(key, step).second) return false;
+            } else if (tree.remove(key) != (expected.erase(key) == 1)) {
+                return false;
+            }
+            if (step % 400 != 0) continue;
+            if (!tree.isValid() || tree.size() != expected.size()) return false;
+            for (int query = 0; query < 4; ++query) {
+                string probe = random_key();
+                for (int maxDistance = 0; maxDistance <= 3; ++maxDistance) {
+                    map<int, int> found, scanned;
+                    tree.forEachWithin(probe, maxDistance, [&](int value, int d) { found[value] = d; });
+                    for (const auto& entry : expected) {
+                        int d = distance(probe, entry.first);
+                        if (d <= maxDistance) scanned[entry.second] = d;
+                    }
+                    if (found != scanned) return false;
+                    // best-first walk, its radius shrinking to the third-best distance
+                    vector<int> nearest, closest;
+                    tree.forEachNearest(probe, maxDistance, [&](int, int d) {
+                        nearest.push_back(d);
+                        sort(nearest.begin(), nearest.end());
+                        return nearest.size() < 3 ? maxDistance : nearest[2];
+                    });
+                    for (const auto& entry : scanned) closest.push_back(entry.second);
+                    sort(closest.begin(), closest.end());
+                    nearest.resize(std::min<size_t>(nearest.size(), 3));
+                    closest.resize(std::min<size_t>(closest.size(), 3));
+                    if (nearest != closest) return false;
+                }
+            }
+        }
+        for (const auto& entry : expected) {
+            const int* found = tree.find(entry.first);
+            if (!found || *found != entry.second) return false;
+        }
+        // an unbounded radius visits every live key, at its true distance
+        size_t visited = 0;
+        bool exact = true;
+        tree.forEachWithin("abc", INT_MAX, [&](int value, int d) {
+            visited++;
+            for (const auto& entry : expected)
+                if (entry.second == value) exact = exact && d == distance("abc", entry.first);
+        });
+        if (visited != expected.size() || !exact) return false;
+        // dead nodes never outnumber live ones
+        return tree.nodeCount() <= 2 * tree.size() + 1;
+    }
+};
+
+int main() {
+    TestRunner runner;
+    runner.run_all_tests();
+    return 0;
+}
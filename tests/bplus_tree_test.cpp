@@ -0,0 +1,117 @@
+#include <iostream>
+#include <vector>
+#include <stdexcept>
+#include <string>
+#include <functional>
+#include <random>
+
+#include "bplus_tree.h"
+#include "avl_tree.h"
+
+using namespace std;
+
+/**
+ * @class TestRunner
+ * @brief Checks BPlusTree against AVLTree as a reference under random updates.
+ */
+class TestRunner {
+public:
+    TestRunner() : total_score(0), max_score(0) {}
+
+    void run_all_tests() {
+        cout << "=======================================================================" << endl;
+        cout << "                 B+ Tree Index Tester" << endl;
+        cout << "=======================================================================" << endl;
+
+        test_correctness();
+
+        cout << "\n-----------------------------------------------------------------------" << endl;
+        cout << "                           TESTING SUMMARY" << endl;
+        cout << "-----------------------------------------------------------------------" << endl;
+        cout << "  FINAL SCORE: " << total_score << " / " << max_score << endl;
+        if (total_score == max_score) {
+            cout << "  RESULT: All correctness tests passed!" << endl;
+        } else {
+            cout << "  RESULT: Some correctness tests failed." << endl;
+        }
+        cout << "=======================================================================" << endl;
+    }
+
+private:
+    int total_score;
+    int max_score;
+
+    void execute_correctness_test(const string& name, int points, const string& desc, const function<bool()>& test_func) {
+        max_score += points;
+        cout << "\n  - " << name << " [" << points << " pts]" << endl;
+        cout << "    " << desc << endl;
+        cout << "    Running test... ";
+        if (test_func()) {
+            cout << "PASSED" << endl;
+            total_score += points;
+        } else {
+            cout << "FAILED" << endl;
+        }
+    }
+
+    void test_correctness() {
+        cout << "\n--- B+ Tree against an AVLTree Reference ---" << endl;
+
+        execute_correctness_test("B+ Tree Index against AVLTree", 15, "Random updates mirrored on both trees; isValid, contents, ranges and ranks compared.", [this]() {
+            return run_bplus_scenario<int>([](int k) { return k; }) &&
+                   run_bplus_scenario<string>([](int k) { return "user" + to_string(k); });
+        });
+    }
+
+    // Mirrors a random insert/remove mix on a BPlusTree and an AVLTree reference,
+    // enough keys that leaves and inner nodes split, borrow and merge many times.
+    template<typename Key, typename MakeKey>
+    static bool run_bplus_scenario(MakeKey make_key) {
+        BPlusTree<Key, int> bpt;
+        AVLTree<Key, int> avl;
+        std::mt19937 rng(808);
+        for (int i = 0; i < 40000; ++i) {
+            int k = rng() % 6000;
+            Key key = make_key(k);
+            if (rng() % 5 < 2) {
+                if (bpt.remove(key) != avl.remove(key)) return false;
+            } else {
+                if (bpt.insert(key, k) != avl.insert(key, k)) return false;
+            }
+            if (i % 4000 == 0 && !bpt.isValid()) return false;
+        }
+        if (!bpt.isValid() || bpt.size() != avl.size() || bpt.inOrderTraversal() != avl.inOrderTraversal()) return false;
+
+        for (int q = 0; q < 200; ++q) {
+            Key lo = make_key(rng() % 6000), hi = make_key(rng() % 6000);
+            if (bpt.findRange(lo, hi) != avl.findRange(lo, hi) || bpt.countRange(lo, hi) != avl.countRange(lo, hi)) return false;
+            if (bpt.rank(lo) != avl.rank(lo)) return false;
+            auto b = bpt.lower_bound(lo);
+            auto a = avl.lower_bound(lo);
+            if ((b == bpt.end()) != (a == avl.end()) || (a != avl.end() && b->key != a->key)) return false;
+            const int* found = bpt.find(lo);
+            if ((found == nullptr) != (avl.find(lo) == nullptr)) return false;
+        }
+        size_t mid = bpt.size() / 2;
+        if (bpt.select(mid) != avl.select(mid) || bpt.sliceByRank(mid, 300) != avl.sliceByRank(mid, 300)) return false;
+        if (bpt.min() != avl.min() || bpt.max() != avl.max() || (--bpt.end())->key != bpt.max().first) return false;
+
+        // drain to empty so the tree shrinks back down level by level
+        vector<pair<Key, int>> items = bpt.inOrderTraversal();
+        for (size_t i = 0; i < items.size(); i += 2) bpt.remove(items[i].first);
+        if (!bpt.isValid()) return false;
+        for (size_t i = 1; i < items.size(); i += 2) bpt.remove(items[i].first);
+        if (!bpt.empty() || bpt.begin() != bpt.end() || !bpt.isValid()) return false;
+
+        bpt.buildFromSorted(items.begin(), items.end());
+        if (!bpt.isValid() || bpt.inOrderTraversal() != items) return false;
+        try { bpt.buildFromSorted(items.rbegin(), items.rend()); return false; } catch (const invalid_argument&) {}
+        return bpt.isValid() && bpt.inOrderTraversal() == items;  // rejected before the old contents were cleared
+    }
+};
+
+int main() {
+    TestRunner runner;
+    runner.run_all_tests();
+    return 0;
+}
@@ -142,6 +142,46 @@ public:
         return true;
     }
 
+    // Keys 0..n-1 inserted in order leave a single right-leaning chain. The chain
+    // is linked directly in O(n) (inserting it would cost O(n^2)), then every
+    // traversal and mutation path runs at full depth and must not recurse.
+    bool run_sequential_chain_test(int n) {
+        this->clear();
+        typename BST<K, V>::NodePtr tail;
+        for (int i = 0; i < n; ++i) {
+            auto node = this->createNode(K(i), V(i));
+            node->height = n - i;
+            node->subtreeSize = n - i;
+            if (tail) {
+                tail->right = node;
+                node->parent = tail;
+            } else {
+                this->root = node;
+            }
+            tail = node;
+        }
+        this->nodeCount = n;
+        tail = nullptr;
+
+        if (!this->find(K(n - 1)) || this->find(K(n)) || !this->isValidBST()) return false;
+        if (!this->insert(K(n), V(n)) || this->getTreeHeight() != n + 1) return false;
+        if (!this->remove(K(n / 2)) || !this->remove(K(n)) || this->remove(K(n)) || this->size() != (size_t)n - 1) return false;
+        if (this->max().first != K(n - 1) || this->rank(K(n - 1)) != (size_t)n - 2) return false;
+
+        vector<pair<K, V>> all = this->inOrderTraversal();
+        if (all.size() != (size_t)n - 1 || all.front().first != K(0) || all.back().first != K(n - 1)) return false;
+        for (size_t i = 1; i < all.size(); ++i) if (!this->comparator(all[i - 1].first, all[i].first)) return false;
+        all.clear();
+        all.shrink_to_fit();
+
+        if (this->findRange(K(n - 10), K(n + 5)).size() != 10) return false;
+        size_t visited = 0;
+        for (auto it = this->begin(); it != this->end(); ++it) visited++;
+        if (visited != (size_t)n - 1) return false;
+        this->clear();  // must free the chain without a nested destructor per node
+        return this->empty() && this->inOrderTraversal().empty();
+    }
+
 private:
     bool find_and_validate_path(const K& key) {
         auto current = this->root;
@@ -334,6 +374,22 @@ private:
         execute_test("Range: Invalid range (min > max)", 5, [this]() {
             return tester.run_findRange_test(80, 30, {});
         });
+        execute_test("Iterators, bounds and forEachInRange", 10, [this]() {
+            vector<int> forward, backward, visited;
+            for (auto it = tester.begin(); it != tester.end(); ++it) forward.push_back(it->key);
+            for (auto it = tester.end(); it != tester.begin();) backward.push_back((--it)->key);
+            vector<int> expected = {5,10,15,25,35,40,45,50,60,75,85,90,100};
+            if (forward != expected || vector<int>(backward.rbegin(), backward.rend()) != expected) return false;
+            if (tester.lower_bound(40)->key != 40 || tester.upper_bound(40)->key != 45) return false;
+            if (tester.lower_bound(41)->key != 45 || tester.lower_bound(101) != tester.end()) return false;
+            auto range = tester.equal_range(60);
+            if (range.first->key != 60 || range.second->key != 75) return false;
+            tester.forEachInRange(30, 80, [&](const int& key, const string&) {
+                visited.push_back(key);
+                return visited.size() < 3; // stop after three keys
+            });
+            return visited == vector<int>{35, 40, 45};
+        });
     }
 
     void test_edge_case_scenarios() {
@@ -366,6 +422,10 @@ private:
             for(int i=0; i<100; ++i) to_remove.push_back(initial_data[i].first);
             return tester.run_removal_test(initial_data, to_remove);
         });
+        execute_test("Degenerate tree: 10M sequential keys", 10, []() {
+            BSTTester<int, int> chain;
+            return chain.run_sequential_chain_test(10000000);
+        });
     }
 };
 
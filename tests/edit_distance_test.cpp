@@ -0,0 +1,113 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <random>
+
+#include "edit_distance.h"
+
+using namespace std;
+
+/**
+ * @class TestRunner
+ * @brief Checks the Myers edit distance kernels against classicEditDistance.
+ */
+class TestRunner {
+public:
+    TestRunner() : total_score(0), max_score(0) {}
+
+    void run_all_tests() {
+        cout << "=======================================================================" << endl;
+        cout << "                 Edit Distance Tester" << endl;
+        cout << "=======================================================================" << endl;
+
+        test_correctness();
+
+        cout << "\n-----------------------------------------------------------------------" << endl;
+        cout << "                           TESTING SUMMARY" << endl;
+        cout << "-----------------------------------------------------------------------" << endl;
+        cout << "  FINAL SCORE: " << total_score << " / " << max_score << endl;
+        if (total_score == max_score) {
+            cout << "  RESULT: All correctness tests passed!" << endl;
+        } else {
+            cout << "  RESULT: Some correctness tests failed." << endl;
+        }
+        cout << "=======================================================================" << endl;
+    }
+
+private:
+    int total_score;
+    int max_score;
+
+    void execute_correctness_test(const string& name, int points, const string& desc, const function<bool()>& test_func) {
+        max_score += points;
+        cout << "\n  - " << name << " [" << points << " pts]" << endl;
+        cout << "    " << desc << endl;
+        cout << "    Running test... ";
+        if (test_func()) {
+            cout << "PASSED" << endl;
+            total_score += points;
+        } else {
+            cout << "FAILED" << endl;
+        }
+    }
+
+    void test_correctness() {
+        cout << "\n--- Bit-Parallel Kernels against the Classic DP ---" << endl;
+
+        execute_correctness_test("Bit-Parallel Edit Distance", 10, "Myers kernels (one word, blocked past 64 bytes, banded, 8-wide batch) equal the classic DP.", []() {
+            return run_edit_distance_scenario();
+        });
+    }
+
+    // Random pairs over small alphabets, many of them a few edits apart, at
+    // lengths on both sides of the 32-byte lane and the 64-bit word
+    static bool run_edit_distance_scenario() {
+        mt19937 rng(47);
+        auto random_text = [&](size_t maxLength, int alphabet) {
+            string text(rng() % (maxLength + 1), 'a');
+            for (char& c : text) c = 'a' + rng() % alphabet;
+            return text;
+        };
+        LevenshteinDistance distance;
+        for (int round = 0; round < 4000; ++round) {
+            size_t maxLength = round % 4 == 0 ? 200 : (round % 2 ? 70 : 32);
+            int alphabet = 2 + round % 5;
+            string query = random_text(maxLength, alphabet);
+            MyersPattern pattern(query);
+            vector<string> texts;
+            for (int i = rng() % 20; i > 0; --i) {
+                string text = query;
+                if (rng() % 4 == 0) {
+                    text = random_text(maxLength, alphabet);
+                } else {
+                    for (int edits = rng() % 6; edits > 0; --edits) {
+                        size_t at = text.empty() ? 0 : rng() % text.size();
+                        if (rng() % 2 && !text.empty()) text.erase(at, 1);
+                        else text.insert(at, 1, 'a' + rng() % alphabet);
+                    }
+                }
+                texts.push_back(text);
+            }
+            vector<string_view> views(texts.begin(), texts.end());
+            vector<int> batch(texts.size());
+            pattern.distances(views.data(), views.size(), batch.data());
+            for (size_t i = 0; i < texts.size(); ++i) {
+                int expected = classicEditDistance(query, texts[i]);
+                int maxDistance = rng() % 8;
+                int banded = expected <= maxDistance ? expected : maxDistance + 1;
+                if (distance(query, texts[i]) != expected || distance(texts[i], query) != expected || pattern.distance(texts[i]) != expected ||
+                    batch[i] != expected || pattern.distance(texts[i], maxDistance) != banded || distance(query, texts[i], maxDistance) != banded)
+                    return false;
+            }
+        }
+        return true;
+    }
+};
+
+int main() {
+    TestRunner runner;
+    runner.run_all_tests();
+    return 0;
+}
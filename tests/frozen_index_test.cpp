@@ -0,0 +1,88 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <functional>
+
+#include "frozen_index.h"
+#include "avl_tree.h"
+
+using namespace std;
+
+/**
+ * @class TestRunner
+ * @brief Checks FrozenIndex lookups and ranges against the AVLTree it was built from.
+ */
+class TestRunner {
+public:
+    TestRunner() : total_score(0), max_score(0) {}
+
+    void run_all_tests() {
+        cout << "=======================================================================" << endl;
+        cout << "                 Frozen Eytzinger Index Tester" << endl;
+        cout << "=======================================================================" << endl;
+
+        test_correctness();
+
+        cout << "\n-----------------------------------------------------------------------" << endl;
+        cout << "                           TESTING SUMMARY" << endl;
+        cout << "-----------------------------------------------------------------------" << endl;
+        cout << "  FINAL SCORE: " << total_score << " / " << max_score << endl;
+        if (total_score == max_score) {
+            cout << "  RESULT: All correctness tests passed!" << endl;
+        } else {
+            cout << "  RESULT: Some correctness tests failed." << endl;
+        }
+        cout << "=======================================================================" << endl;
+    }
+
+private:
+    int total_score;
+    int max_score;
+
+    void execute_correctness_test(const string& name, int points, const string& desc, const function<bool()>& test_func) {
+        max_score += points;
+        cout << "\n  - " << name << " [" << points << " pts]" << endl;
+        cout << "    " << desc << endl;
+        cout << "    Running test... ";
+        if (test_func()) {
+            cout << "PASSED" << endl;
+            total_score += points;
+        } else {
+            cout << "FAILED" << endl;
+        }
+    }
+
+    void test_correctness() {
+        cout << "\n--- Lookups against the Source AVLTree ---" << endl;
+
+        execute_correctness_test("Frozen Eytzinger Index from inOrderTraversal", 10, "find / lower_bound / upper_bound / ranges on every size up to 300 match the AVLTree.", []() {
+            for (int n = 0; n <= 300; ++n) {
+                AVLTree<int, string> avl;
+                for (int i = 0; i < n; ++i) avl.insert(i * 3, to_string(i));
+                FrozenIndex<int, string> frozen(avl.inOrderTraversal());
+                if (frozen.size() != avl.size()) return false;
+                for (int key = -2; key <= n * 3 + 2; ++key) {
+                    const string* hit = frozen.find(key);
+                    if ((hit == nullptr) != (avl.find(key) == nullptr) || (hit && *hit != *avl.find(key))) return false;
+                    auto lb = frozen.lower_bound(key);
+                    auto expected = avl.lower_bound(key);
+                    if ((lb == frozen.end()) != (expected == avl.end()) || (lb != frozen.end() && lb->key != expected->key)) return false;
+                    auto ub = frozen.upper_bound(key);
+                    expected = avl.upper_bound(key);
+                    if ((ub == frozen.end()) != (expected == avl.end()) || (ub != frozen.end() && ub->key != expected->key)) return false;
+                }
+                if (frozen.findRange(n, 2 * n) != avl.findRange(n, 2 * n)) return false;
+            }
+            AVLTree<string, string> names;
+            for (int i = 0; i < 1000; ++i) names.insert("user" + to_string(i), to_string(i));
+            FrozenIndex<string, string> frozen_names(names.inOrderTraversal());
+            return frozen_names.findRange("user5", "user6") == names.findRange("user5", "user6") && !frozen_names.find("user1000");
+        });
+    }
+};
+
+int main() {
+    TestRunner runner;
+    runner.run_all_tests();
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <functional>
+#include <memory>
+#include <random>
+#include <thread>
+#include <atomic>
+
+#include "persistent_avl_tree.h"
+
+using namespace std;
+
+/**
+ * @class TestRunner
+ * @brief Checks PersistentAVLTree snapshots while a writer keeps updating the tree.
+ */
+class TestRunner {
+public:
+    TestRunner() : total_score(0), max_score(0) {}
+
+    void run_all_tests() {
+        cout << "=======================================================================" << endl;
+        cout << "                 Persistent AVL Tree Tester" << endl;
+        cout << "=======================================================================" << endl;
+
+        test_correctness();
+
+        cout << "\n-----------------------------------------------------------------------" << endl;
+        cout << "                           TESTING SUMMARY" << endl;
+        cout << "-----------------------------------------------------------------------" << endl;
+        cout << "  FINAL SCORE: " << total_score << " / " << max_score << endl;
+        if (total_score == max_score) {
+            cout << "  RESULT: All correctness tests passed!" << endl;
+        } else {
+            cout << "  RESULT: Some correctness tests failed." << endl;
+        }
+        cout << "=======================================================================" << endl;
+    }
+
+private:
+    int total_score;
+    int max_score;
+
+    void execute_correctness_test(const string& name, int points, const string& desc, const function<bool()>& test_func) {
+        max_score += points;
+        cout << "\n  - " << name << " [" << points << " pts]" << endl;
+        cout << "    " << desc << endl;
+        cout << "    Running test... ";
+        if (test_func()) {
+            cout << "PASSED" << endl;
+            total_score += points;
+        } else {
+            cout << "FAILED" << endl;
+        }
+    }
+
+    void test_correctness() {
+        cout << "\n--- Snapshots under Concurrent Writes ---" << endl;
+
+        execute_correctness_test("Persistent Snapshots under Concurrent Writes", 15, "Readers validate immutable snapshots while a writer slides a key window; old versions are reclaimed.", []() {
+            PersistentAVLTree<int, int> tree;
+            const int total = 20000, window = 500;
+            atomic<bool> done(false), failed(false);
+            atomic<long long> snapshots_read(0);
+
+            // Every version holds a contiguous key range with value == 2 * key
+            auto reader = [&](unsigned seed) {
+                std::mt19937 rng(seed);
+                while (!done.load()) {
+                    AVLSnapshot<int, int> snap = tree.snapshot();
+                    vector<pair<int, int>> before = snap.inOrderTraversal();
+                    if (!snap.isValidAVL() || before.size() != snap.size()) failed = true;
+                    if (!before.empty()) {
+                        int lo = before.front().first, hi = before.back().first;
+                        if (hi - lo + 1 != (int)before.size() || snap.countRange(lo, hi) != before.size()) failed = true;
+                        int probe = lo + rng() % (hi - lo + 1);
+                        const int* value = snap.find(probe);
+                        if (!value || *value != 2 * probe) failed = true;
+                    }
+                    std::this_thread::yield();
+                    if (snap.inOrderTraversal() != before) failed = true;  // writer must not touch old versions
+                    snapshots_read++;
+                }
+            };
+            vector<thread> readers;
+            for (unsigned r = 0; r < 4; ++r) readers.emplace_back(reader, r + 1);
+            for (int i = 0; i < total; ++i) {
+                tree.insert(i, 2 * i);
+                if (i >= window) tree.remove(i - window);
+            }
+            done = true;
+            for (auto& t : readers) t.join();
+            if (failed || snapshots_read == 0) return false;
+            if (tree.size() != (size_t)window || !tree.isValidAVL() || tree.select(0).first != total - window) return false;
+
+            // A removed entry lives on while some snapshot still reaches it
+            PersistentAVLTree<int, shared_ptr<int>> owners;
+            auto payload = make_shared<int>(42);
+            weak_ptr<int> watch = payload;
+            owners.insert(1, payload);
+            owners.insert(2, make_shared<int>(0));
+            payload.reset();
+            auto held = owners.snapshot();
+            owners.remove(1);
+            if (watch.expired() || owners.find(1) || !held.find(1)) return false;
+            held = owners.snapshot();
+            return watch.expired() && held.size() == 1;
+        });
+    }
+};
+
+int main() {
+    TestRunner runner;
+    runner.run_all_tests();
+    return 0;
+}
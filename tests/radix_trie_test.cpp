@@ -0,0 +1,110 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <functional>
+#include <random>
+#include <map>
+
+#include "radix_trie.h"
+
+using namespace std;
+
+/**
+ * @class TestRunner
+ * @brief Checks RadixTrie lookups, prefix counts and completions against a std::map.
+ */
+class TestRunner {
+public:
+    TestRunner() : total_score(0), max_score(0) {}
+
+    void run_all_tests() {
+        cout << "=======================================================================" << endl;
+        cout << "                 Radix Trie Tester" << endl;
+        cout << "=======================================================================" << endl;
+
+        test_correctness();
+
+        cout << "\n-----------------------------------------------------------------------" << endl;
+        cout << "                           TESTING SUMMARY" << endl;
+        cout << "-----------------------------------------------------------------------" << endl;
+        cout << "  FINAL SCORE: " << total_score << " / " << max_score << endl;
+        if (total_score == max_score) {
+            cout << "  RESULT: All correctness tests passed!" << endl;
+        } else {
+            cout << "  RESULT: Some correctness tests failed." << endl;
+        }
+        cout << "=======================================================================" << endl;
+    }
+
+private:
+    int total_score;
+    int max_score;
+
+    void execute_correctness_test(const string& name, int points, const string& desc, const function<bool()>& test_func) {
+        max_score += points;
+        cout << "\n  - " << name << " [" << points << " pts]" << endl;
+        cout << "    " << desc << endl;
+        cout << "    Running test... ";
+        if (test_func()) {
+            cout << "PASSED" << endl;
+            total_score += points;
+        } else {
+            cout << "FAILED" << endl;
+        }
+    }
+
+    void test_correctness() {
+        cout << "\n--- Prefix Index against a std::map ---" << endl;
+
+        execute_correctness_test("Radix Trie Prefix Index", 10, "insert/remove/find, prefix counts and paged completions match a std::map under random churn.", []() {
+            return run_trie_scenario();
+        });
+    }
+
+    // Short keys over a tiny alphabet share long prefixes and end inside each
+    // other's edges; a trailing byte out of 40 pushes some nodes into the
+    // table form and back. Every prefix query is checked against a std::map.
+    static bool run_trie_scenario() {
+        RadixTrie<int> trie;
+        map<string, int> expected;
+        mt19937 rng(37);
+        auto random_key = [&]() {
+            string key;
+            for (int i = rng() % 6; i > 0; --i) key += "abc\xff"[rng() % 4];
+            if (rng() % 3 == 0) key += (char)('0' + rng() % 40);
+            return key;
+        };
+        for (int step = 0; step < 40000; ++step) {
+            string key = random_key();
+            if (rng() % 3 < 2) {
+                if (trie.insert(key, step) != expected.emplace(key, step).second) return false;
+            } else if (trie.remove(key) != (expected.erase(key) == 1)) {
+                return false;
+            }
+            if (step % 500 != 0) continue;
+            if (!trie.isValid() || trie.size() != expected.size()) return false;
+            for (const string& prefix : {string(), string("a"), string("ab"), string("c\xff"), random_key()}) {
+                vector<int> matches;
+                for (auto it = expected.lower_bound(prefix); it != expected.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it)
+                    matches.push_back(it->second);
+                if (trie.countWithPrefix(prefix) != matches.size() || trie.withPrefix(prefix) != matches) return false;
+                size_t offset = rng() % (matches.size() + 2), limit = rng() % 5;
+                vector<int> page;
+                for (size_t i = offset; i < matches.size() && page.size() < limit; ++i) page.push_back(matches[i]);
+                if (trie.withPrefix(prefix, offset, limit) != page) return false;
+            }
+        }
+        for (const auto& entry : expected) {
+            const int* found = trie.find(entry.first);
+            if (!found || *found != entry.second) return false;
+        }
+        trie.clear();
+        return trie.empty() && trie.nodeCount() == 1 && trie.isValid() && !trie.find("") && trie.withPrefix("").empty();
+    }
+};
+
+int main() {
+    TestRunner runner;
+    runner.run_all_tests();
+    return 0;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <algorithm>
+#include <map>
+
+using namespace std;
+
+// Augmentation for the aggregateRange tests. first/last make combine
+// order-sensitive, so a summary assembled out of key order is caught.
+struct RangeStats {
+    struct Summary {
+        size_t count;
+        long long sum;
+        int maxValue;
+        int first, last;  // keys at either end
+        bool operator==(const Summary& o) const {
+            return count == o.count && sum == o.sum && (count == 0 || (maxValue == o.maxValue && first == o.first && last == o.last));
+        }
+    };
+    static Summary identity() { return {0, 0, 0, 0, 0}; }
+    static Summary fromEntry(const int& key, const int& value) { return {1, value, value, key, key}; }
+    static Summary combine(const Summary& a, const Summary& b) {
+        if (a.count == 0) return b;
+        if (b.count == 0) return a;
+        return {a.count + b.count, a.sum + b.sum, std::max(a.maxValue, b.maxValue), a.first, b.last};
+    }
+};
+
+// The summary of entries' keys in [lo, hi], combined one entry at a time
+inline RangeStats::Summary brute_force_stats(const map<int, int>& entries, int lo, int hi) {
+    RangeStats::Summary total = RangeStats::identity();
+    if (hi < lo) return total;
+    for (auto it = entries.lower_bound(lo); it != entries.end() && it->first <= hi; ++it)
+        total = RangeStats::combine(total, RangeStats::fromEntry(it->first, it->second));
+    return total;
+}
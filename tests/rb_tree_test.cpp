@@ -0,0 +1,122 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <functional>
+#include <random>
+#include <cmath>
+#include <map>
+#include <type_traits>
+
+// The rotation bounds are read from TreeStats, so this tester always counts
+#ifndef TREE_STATS
+#define TREE_STATS
+#endif
+#include "rb_tree.h"
+#include "range_stats.h"
+
+using namespace std;
+
+/**
+ * @class TestRunner
+ * @brief Checks RBTree's colouring, contents, summaries and rotation bounds under random churn.
+ */
+class TestRunner {
+public:
+    TestRunner() : total_score(0), max_score(0) {}
+
+    void run_all_tests() {
+        cout << "=======================================================================" << endl;
+        cout << "                 Red-Black Tree Tester" << endl;
+        cout << "=======================================================================" << endl;
+
+        test_correctness();
+
+        cout << "\n-----------------------------------------------------------------------" << endl;
+        cout << "                           TESTING SUMMARY" << endl;
+        cout << "-----------------------------------------------------------------------" << endl;
+        cout << "  FINAL SCORE: " << total_score << " / " << max_score << endl;
+        if (total_score == max_score) {
+            cout << "  RESULT: All correctness tests passed!" << endl;
+        } else {
+            cout << "  RESULT: Some correctness tests failed." << endl;
+        }
+        cout << "=======================================================================" << endl;
+    }
+
+private:
+    int total_score;
+    int max_score;
+
+    void execute_correctness_test(const string& name, int points, const string& desc, const function<bool()>& test_func) {
+        max_score += points;
+        cout << "\n  - " << name << " [" << points << " pts]" << endl;
+        cout << "    " << desc << endl;
+        cout << "    Running test... ";
+        if (test_func()) {
+            cout << "PASSED" << endl;
+            total_score += points;
+        } else {
+            cout << "FAILED" << endl;
+        }
+    }
+
+    void test_correctness() {
+        cout << "\n--- Random Churn on Both Storage Policies ---" << endl;
+
+        execute_correctness_test("Red-Black Tree under Random Churn", 10, "isValidRB, contents, summaries, rotation bound per update and height bound (shared and arena storage).", []() {
+            return run_rb_scenario<RBTree<int, int>>() &&
+                   run_rb_scenario<RBTree<int, int, less<int>, ArenaNodeStorage, RangeStats>>();
+        });
+    }
+
+    // At most 2 rotations per insert and 3 per remove, height <= 2 log2(n + 1),
+    // and the order-sensitive RangeStats summaries stay exact through them.
+    template<typename Tree>
+    static bool run_rb_scenario() {
+        std::mt19937 rng(1717);
+        Tree tree;
+        map<int, int> entries;
+        for (int round = 0; round < 30; ++round) {
+            for (int i = 0; i < 1000; ++i) {
+                int k = rng() % 3000, v = rng() % 1000;
+                size_t before = tree.getStats().rotations;
+                switch (rng() % 3) {
+                case 0:
+                    if (tree.insert(k, v) != entries.emplace(k, v).second) return false;
+                    if (tree.getStats().rotations - before > 2) return false;
+                    break;
+                case 1:
+                    if (tree.remove(k) != (entries.erase(k) == 1)) return false;
+                    if (tree.getStats().rotations - before > 3) return false;
+                    break;
+                default:
+                    if (tree.insert_or_assign(k, v) != (entries.count(k) == 0)) return false;
+                    entries[k] = v;
+                }
+            }
+            if (!tree.isValidRB() || tree.size() != entries.size()) return false;
+            if (tree.getTreeHeight() > 2 * std::log2(tree.size() + 1)) return false;
+            if (tree.inOrderTraversal() != vector<pair<int, int>>(entries.begin(), entries.end())) return false;
+            for (int q = 0; q < 20; ++q) {
+                int lo = rng() % 3000, hi = lo + rng() % 500;
+                if (tree.countRange(lo, hi) != brute_force_stats(entries, lo, hi).count) return false;
+                if constexpr (is_same<typename Tree::Summary, RangeStats::Summary>::value) {
+                    if (!(tree.aggregateRange(lo, hi) == brute_force_stats(entries, lo, hi))) return false;
+                }
+            }
+        }
+        while (!entries.empty()) {
+            int k = entries.begin()->first;
+            if (!tree.remove(k) || !tree.isValidRB()) return false;
+            entries.erase(k);
+            if (entries.size() % 97 == 0 && tree.size() != entries.size()) return false;
+        }
+        return tree.empty() && tree.getTreeHeight() == 0;
+    }
+};
+
+int main() {
+    TestRunner runner;
+    runner.run_all_tests();
+    return 0;
+}
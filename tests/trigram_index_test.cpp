@@ -0,0 +1,130 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <random>
+#include <set>
+#include <map>
+
+#include "trigram_index.h"
+
+using namespace std;
+
+/**
+ * @class TestRunner
+ * @brief Checks PostingList against a std::set and TrigramIndex candidates against a substring scan.
+ */
+class TestRunner {
+public:
+    TestRunner() : total_score(0), max_score(0) {}
+
+    void run_all_tests() {
+        cout << "=======================================================================" << endl;
+        cout << "                 Trigram Substring Index Tester" << endl;
+        cout << "=======================================================================" << endl;
+
+        test_correctness();
+
+        cout << "\n-----------------------------------------------------------------------" << endl;
+        cout << "                           TESTING SUMMARY" << endl;
+        cout << "-----------------------------------------------------------------------" << endl;
+        cout << "  FINAL SCORE: " << total_score << " / " << max_score << endl;
+        if (total_score == max_score) {
+            cout << "  RESULT: All correctness tests passed!" << endl;
+        } else {
+            cout << "  RESULT: Some correctness tests failed." << endl;
+        }
+        cout << "=======================================================================" << endl;
+    }
+
+private:
+    int total_score;
+    int max_score;
+
+    void execute_correctness_test(const string& name, int points, const string& desc, const function<bool()>& test_func) {
+        max_score += points;
+        cout << "\n  - " << name << " [" << points << " pts]" << endl;
+        cout << "    " << desc << endl;
+        cout << "    Running test... ";
+        if (test_func()) {
+            cout << "PASSED" << endl;
+            total_score += points;
+        } else {
+            cout << "FAILED" << endl;
+        }
+    }
+
+    void test_correctness() {
+        cout << "\n--- Posting Lists and Candidates against References ---" << endl;
+
+        execute_correctness_test("Trigram Substring Index", 10, "Compressed posting lists match a std::set under churn; candidates hold every substring match.", []() {
+            return run_trigram_scenario();
+        });
+    }
+
+    // Posting lists against a std::set (dense and sparse IDs, appends and
+    // random inserts, galloping seeks), then the index against a scan
+    static bool run_trigram_scenario() {
+        mt19937 rng(53);
+        for (int round = 0; round < 6; ++round) {
+            PostingList list;
+            set<int> expected;
+            int range = round % 2 ? 1000 : 2000000000;
+            for (int step = 0; step < 6000; ++step) {
+                int id = round % 3 == 0 && step < 2000 ? step * 7 : (int)(rng() % range) - range / 2;
+                if (rng() % 3) {
+                    if (list.insert(id) != expected.insert(id).second) return false;
+                } else if (list.remove(id) != (expected.erase(id) == 1)) {
+                    return false;
+                }
+                if (step % 500 != 0) continue;
+                if (!list.isValid() || list.ids() != vector<int>(expected.begin(), expected.end())) return false;
+                PostingList::Cursor cursor(list);
+                for (int probe = -range / 2; probe < range / 2; probe += range / 64 + (int)(rng() % (range / 16))) {
+                    auto next = expected.lower_bound(probe);
+                    if (cursor.seek(probe) != (next != expected.end()) || (next != expected.end() && cursor.value() != *next)) return false;
+                    if (list.contains(probe) != (expected.count(probe) == 1)) return false;
+                }
+            }
+        }
+
+        TrigramIndex index;
+        map<int, string> texts;
+        auto random_text = [&]() {
+            string text;
+            for (int i = rng() % 12; i > 0; --i) text += "abcd"[rng() % 4];
+            return text;
+        };
+        for (int step = 0; step < 8000; ++step) {
+            int id = rng() % 2000;
+            if (rng() % 3 && !texts.count(id)) {
+                texts[id] = random_text();
+                index.insert(id, texts[id]);
+            } else if (texts.count(id)) {
+                index.remove(id, texts[id]);
+                texts.erase(id);
+            }
+            if (step % 400 != 0) continue;
+            if (!index.isValid() || index.size() != texts.size()) return false;
+            for (int query = 0; query < 10; ++query) {
+                string pattern = random_text();
+                if (pattern.size() < TrigramIndex::GRAM) continue;
+                vector<int> candidates = index.candidates(pattern), confirmed, scanned;
+                if (!is_sorted(candidates.begin(), candidates.end())) return false;
+                for (int id : candidates)
+                    if (texts.at(id).find(pattern) != string::npos) confirmed.push_back(id);
+                for (const auto& entry : texts)
+                    if (entry.second.find(pattern) != string::npos) scanned.push_back(entry.first);
+                if (confirmed != scanned) return false;
+            }
+        }
+        return true;
+    }
+};
+
+int main() {
+    TestRunner runner;
+    runner.run_all_tests();
+    return 0;
+}
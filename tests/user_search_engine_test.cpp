@@ -9,6 +9,10 @@
 #include <set>
 #include <map>
 #include <random>
+#include <cstdio>
+#include <filesystem>
+#include <tuple>
+#include <climits>
 
 // Include the header for the code being tested
 #include "user_search_engine.h"
@@ -30,29 +34,74 @@ public:
             return false;
         }
 
-        // 2. Verify usersByID tree
         set<int> expected_ids;
         for (User* u : expected_users) expected_ids.insert(u->userID);
-        AVLTester<int, User*> id_tester;
-        shared_ptr<typename BST<int, User*>::BSTNode> id_root = this->usersByID.getRoot();
-        id_tester.setRoot(id_root);
+        set<string> expected_names;
+        for (User* u : expected_users) expected_names.insert(u->userName);
+
+#ifndef USER_SEARCH_BPLUS_INDEX
+        // 2. Verify usersByID tree
+        AVLTester<int, User*, less<int>, SharedNodeStorage, UserActivityAugment> id_tester;
+        id_tester.setRoot(this->usersByID.getRoot());
         if (!id_tester.isBSTValid(expected_ids) || !id_tester.isTreeBalanced()) {
             cout << "\n    [FAIL] usersByID tree is invalid, unbalanced, or has incorrect content.";
             return false;
         }
 
         // 3. Verify usersByName tree
-        set<string> expected_names;
-        for (User* u : expected_users) expected_names.insert(u->userName);
+#ifndef USER_SEARCH_INTERNED_NAMES
         AVLTester<string, User*> name_tester;
         name_tester.setRoot(this->usersByName.getRoot());
         if (!name_tester.isBSTValid(expected_names) || !name_tester.isTreeBalanced()) {
             cout << "\n    [FAIL] usersByName tree is invalid, unbalanced, or has incorrect content.";
             return false;
         }
+#else
+        // Interned keys only compare through the engine's arena, so the names are checked in iteration order
+        AVLTester<InternedString, User*, InternedStringCompare> name_tester;
+        name_tester.setRoot(this->usersByName.getRoot());
+        if (!name_tester.isTreeBalanced() || !names_in_order(expected_names)) {
+            cout << "\n    [FAIL] usersByName tree is invalid, unbalanced, or has incorrect content.";
+            return false;
+        }
+#endif
+#else
+        // 2-3. The B+ tree has no node shape to walk: check both indexes in
+        // iteration order, then the leaf / separator invariants
+        if (!ids_in_order(expected_ids) || !names_in_order(expected_names)) {
+            cout << "\n    [FAIL] usersByID / usersByName have incorrect content or order.";
+            return false;
+        }
+        if (!this->isConsistent()) {
+            cout << "\n    [FAIL] usersByID / usersByName are invalid or out of sync.";
+            return false;
+        }
+#endif
 
         return true;
     }
+
+private:
+    // Every expected ID in ascending order, each keyed to its user's ID
+    // (migrated users are the engine's copies, so compare keys)
+    bool ids_in_order(const set<int>& expected_ids) const {
+        vector<int> ids;
+        for (const auto& entry : this->usersByID) {
+            if (!entry.value || entry.key != entry.value->userID) return false;
+            ids.push_back(entry.key);
+        }
+        return ids == vector<int>(expected_ids.begin(), expected_ids.end());
+    }
+
+    // Every expected username, in name order
+    bool names_in_order(const set<string>& expected_names) const {
+        vector<string> names;
+        for (const auto& entry : this->usersByName) {
+            if (!entry.value) return false;
+            names.push_back(entry.value->userName);
+        }
+        return names == vector<string>(expected_names.begin(), expected_names.end());
+    }
 };
 
 
@@ -340,6 +389,274 @@ private:
         execute_test("ADV-3: Fuzzy Search (No Matches)", 5, "Searching for 'xyz' with max distance 1.", [&]() {
             return engine.fuzzyUsernameSearch("xyz", 1).empty();
         });
+
+        execute_test("ADV-4: Sorted Pages and ID Window Count", 5, "Page 2 (size 3) by ID and by name; count IDs in [3, 7].", [&]() {
+            auto by_id = engine.getUsersSortedPage(3, 3, true);
+            auto by_name = engine.getUsersSortedPage(3, 3, false);
+            if (by_id.size() != 3 || by_name.size() != 3) return false;
+            if (by_id[0]->userID != 3 || by_id[2]->userID != 5) return false;
+            if (by_name[0]->userName != "user3" || by_name[2]->userName != "user5") return false;
+            return engine.getUsersSortedPage(9, 5).size() == 1 && engine.countUsersInIDRange(3, 7) == 5
+                && engine.countUsersInIDRange(7, 3) == 0;
+        });
+
+        execute_test("ADV-5: Frozen ID Index with Delta", 5, "searchByID from a frozen snapshot while users are added, removed and re-added.", [&]() {
+            UserSearchEngineTester frozen_engine;
+            set<User*> expected_users;
+            for (int i = 0; i < 150; ++i) { frozen_engine.addUser(&user_pool[i]); expected_users.insert(&user_pool[i]); }
+            frozen_engine.freezeIDIndex();
+            frozen_engine.removeUser(10);
+            frozen_engine.removeUser("user11");
+            frozen_engine.addUser(&user_pool[160]);
+            frozen_engine.addUser(&user_pool[10]);
+            expected_users.erase(&user_pool[11]);
+            expected_users.insert(&user_pool[160]);
+            if (frozen_engine.searchByID(10) != &user_pool[10] || frozen_engine.searchByID(11) != nullptr) return false;
+            if (frozen_engine.searchByID(160) != &user_pool[160] || frozen_engine.searchByID(42) != &user_pool[42]) return false;
+            // enough churn to trigger an automatic refreeze
+            for (int i = 0; i < 100; ++i) { frozen_engine.removeUser(i); expected_users.erase(&user_pool[i]); }
+            for (int i = 0; i < 200; ++i) {
+                User* found = frozen_engine.searchByID(i);
+                if (found != (expected_users.count(&user_pool[i]) ? &user_pool[i] : nullptr)) return false;
+            }
+            return frozen_engine.verify_engine_consistency(expected_users);
+        });
+
+        execute_test("ADV-6: Activity Totals per ID Range", 5, "Post / following sums over ID ranges track adds, removes, refreshes and engine-side posts / follows.", [&]() {
+            vector<unique_ptr<User>> members;
+            UserSearchEngineTester activity_engine;
+            for (int i = 0; i < 60; ++i) {
+                members.push_back(make_unique<User>(i, "member" + to_string(i)));
+                for (int p = 0; p < i % 5; ++p) members[i]->addPost(i * 10 + p, "cat");
+                if (i > 0) members[i]->followUser(members[i - 1].get());
+                activity_engine.addUser(members[i].get());
+            }
+            auto brute_force = [&](int lo, int hi) {
+                UserActivity total{0, 0, 0};
+                for (auto& m : members) {
+                    if (m->userID < lo || m->userID > hi || activity_engine.searchByID(m->userID) != m.get()) continue;
+                    total.users++;
+                    total.posts += m->posts.size();
+                    total.following += m->following->size();
+                }
+                return total;
+            };
+            auto matches = [&](int lo, int hi) {
+                UserActivity got = activity_engine.getActivityInIDRange(lo, hi), want = brute_force(lo, hi);
+                return got.users == want.users && got.posts == want.posts && got.following == want.following;
+            };
+            if (!matches(0, 59) || !matches(10, 19) || !matches(-5, 3) || !matches(30, 20)) return false;
+            activity_engine.removeUser(15);
+            activity_engine.removeUser("member16");
+            members[12]->addPost(9999, "cat");
+            if (!activity_engine.refreshUserActivity(12) || activity_engine.refreshUserActivity(15)) return false;
+            if (!matches(10, 19) || !matches(0, 59) || activity_engine.getActivityInIDRange(15, 16).users != 0) return false;
+            // the engine's own mutators refresh the totals without a refreshUserActivity call
+            if (!activity_engine.addPost(20, 9998, "cat") || !activity_engine.followUser(25, 3) ||
+                !activity_engine.unfollowUser(30, 29) || activity_engine.unfollowUser(30, 29) ||
+                activity_engine.addPost(15, 9997, "cat") || activity_engine.followUser(25, 15) || activity_engine.followUser(25, 25))
+                return false;
+            return matches(20, 30) && matches(0, 59) && matches(25, 25);
+        });
+
+        execute_test("ADV-7: Batch Add and Remove", 5, "addUsers/removeUsers report per-user results like repeated addUser/removeUser calls.", [&]() {
+            UserSearchEngineTester batch_engine;
+            set<User*> expected_users;
+            for (int i = 0; i < 20; ++i) { batch_engine.addUser(&user_pool[i]); expected_users.insert(&user_pool[i]); }
+            User same_name(500, "user3");
+            vector<User*> batch = {&user_pool[25], &user_pool[5], nullptr, &same_name, &user_pool[25]};
+            for (int i = 30; i < 130; ++i) batch.push_back(&user_pool[i]);
+            vector<bool> added = batch_engine.addUsers(batch);
+            if (added.size() != batch.size() || !added[0] || added[1] || added[2] || added[3] || added[4]) return false;
+            for (size_t i = 5; i < batch.size(); ++i) { if (!added[i]) return false; expected_users.insert(batch[i]); }
+            expected_users.insert(&user_pool[25]);
+            if (!batch_engine.verify_engine_consistency(expected_users)) return false;
+
+            vector<int> ids = {3, 999, 3, 25};
+            for (int i = 30; i < 120; ++i) ids.push_back(i);
+            vector<bool> removed = batch_engine.removeUsers(ids);
+            if (removed.size() != ids.size() || !removed[0] || removed[1] || removed[2] || !removed[3]) return false;
+            for (int id : ids) if (id < (int)user_pool.size()) expected_users.erase(&user_pool[id]);
+            return batch_engine.searchByUsername("user3") == nullptr && batch_engine.verify_engine_consistency(expected_users);
+        });
+
+        execute_test("ADV-8: string_view Username Lookups", 5, "searchByUsername / searchByUsernamePrefix on slices of a larger buffer.", [&]() {
+            UserSearchEngineTester view_engine;
+            for (int i = 0; i < 30; ++i) view_engine.addUser(&user_pool[i]);
+            const string line = "user12,user2,user99";
+            string_view fields(line);
+            if (view_engine.searchByUsername(fields.substr(0, 6)) != &user_pool[12]) return false;
+            if (view_engine.searchByUsername(fields.substr(7, 5)) != &user_pool[2]) return false;
+            if (view_engine.searchByUsername(fields.substr(13, 6)) != nullptr) return false;
+            return view_engine.searchByUsernamePrefix(fields.substr(7, 5)).size() == 11;  // user2, user20..user29
+        });
+
+        execute_test("ADV-9: Index Snapshot Save and Restore", 5, "loadIndexes rebuilds every index from saveIndexes files and rejects a stale snapshot.", [&]() {
+            LinkedList<User> list;
+            for (int i = 0; i < 50; ++i) list.push_back(user_pool[i]);
+            UserSearchEngineTester source;
+            source.migrateFromLinkedList(list);
+            source.removeUser(7);
+            const string prefix = (std::filesystem::temp_directory_path() / "user_search_engine_test").string();
+            if (!source.saveIndexes(prefix)) return false;
+
+            UserSearchEngineTester restored;
+            bool loaded = restored.loadIndexes(prefix, list);
+            set<User*> expected_users;
+            for (auto node = list.head(); node; node = node->next)
+                if (node->data.userID != 7) expected_users.insert(&node->data);
+            bool matches = loaded && restored.verify_engine_consistency(expected_users) &&
+                           restored.searchByUsername("user12") == restored.searchByID(12) &&
+                           restored.getUsersInIDRange(5, 9).size() == 4 &&
+                           restored.getActivityInIDRange(0, 49).users == 49;
+            // the snapshot no longer describes a renamed user
+            list.head()->data.userName = "renamed0";
+            bool stale = restored.loadIndexes(prefix, list);
+            std::remove((prefix + ".ids").c_str());
+            std::remove((prefix + ".names").c_str());
+            return matches && !stale && restored.getTotalUsers() == 0 && !restored.searchByID(12);
+        });
+
+        execute_test("ADV-10: Parallel Consistency Check", 5, "isConsistent(threads) agrees with isConsistent() and notices a user renamed behind the engine's back.", [&]() {
+            vector<unique_ptr<User>> members;
+            UserSearchEngineTester checked_engine;
+            for (int i = 0; i < 5000; ++i) {
+                members.push_back(make_unique<User>(i * 3, "member" + to_string(i)));
+                checked_engine.addUser(members.back().get());
+            }
+            checked_engine.removeUser(300);
+            ThreadPool threads(4);
+            if (!checked_engine.isConsistent(threads) || !checked_engine.isConsistent()) return false;
+            members[4321]->userName = "renamed";
+            return !checked_engine.isConsistent(threads) && !checked_engine.isConsistent();
+        });
+
+        execute_test("ADV-11: Batched ID Lookups", 5, "searchByIDs / getUsersInIDRanges match one searchByID / getUsersInIDRange per entry, sorted or not.", [&]() {
+            vector<unique_ptr<User>> members;
+            UserSearchEngineTester batched_engine;
+            for (int i = 0; i < 500; ++i) {
+                members.push_back(make_unique<User>(i * 2, "batch" + to_string(i)));
+                batched_engine.addUser(members.back().get());
+            }
+            vector<int> ids;
+            for (int id = -5; id <= 1010; ++id) ids.push_back(id);
+            for (int id = 1010; id >= -5; id -= 7) ids.push_back(id);
+            for (int i = 0; i < 300; ++i) ids.push_back((i * 7919) % 1200 - 50);
+            vector<User*> found = batched_engine.searchByIDs(ids);
+            if (found.size() != ids.size()) return false;
+            for (size_t i = 0; i < ids.size(); ++i)
+                if (found[i] != batched_engine.searchByID(ids[i])) return false;
+
+            vector<pair<int, int>> ranges = {{1, 40}, {41, 41}, {30, 90}, {500, 480}, {900, 2000}, {-10, 5}, {100, 160}};
+            vector<vector<User*>> inRanges = batched_engine.getUsersInIDRanges(ranges);
+            if (inRanges.size() != ranges.size()) return false;
+            for (size_t i = 0; i < ranges.size(); ++i)
+                if (inRanges[i] != batched_engine.getUsersInIDRange(ranges[i].first, ranges[i].second)) return false;
+            return batched_engine.searchByIDs({}).empty() && inRanges[3].empty() && inRanges[0].size() == 20 && found[7] == members[1].get();
+        });
+
+        execute_test("ADV-12: Username Autocomplete", 5, "getUsernameCompletions pages and countUsersWithPrefix agree with searchByUsernamePrefix through adds and removes.", [&]() {
+            vector<unique_ptr<User>> members;
+            UserSearchEngineTester complete_engine;
+            for (int i = 0; i < 300; ++i) {
+                members.push_back(make_unique<User>(i, (i % 3 ? "jo" : "ja") + to_string(i)));
+                complete_engine.addUser(members.back().get());
+            }
+            complete_engine.removeUser(12);
+            complete_engine.removeUser(string("jo13"));
+            vector<User*> all = complete_engine.searchByUsernamePrefix("jo");
+            if (all.size() != 199 || complete_engine.countUsersWithPrefix("jo") != 199) return false;
+            for (size_t i = 1; i < all.size(); ++i)
+                if (!(all[i - 1]->userName < all[i]->userName)) return false;
+            vector<User*> page = complete_engine.getUsernameCompletions("jo", 10, 20);
+            if (page != vector<User*>(all.begin() + 20, all.begin() + 30)) return false;
+            if (complete_engine.getUsernameCompletions("jo1", 3) != vector<User*>{members[1].get(), members[10].get(), members[100].get()}) return false;
+            return complete_engine.countUsersWithPrefix("") == 298 && complete_engine.countUsersWithPrefix("ja12") == 4 &&  // ja120..ja129, ja12 itself is gone
+                   complete_engine.countUsersWithPrefix("ja1") == 35 && complete_engine.getUsernameCompletions("x").empty() &&
+                   complete_engine.isConsistent();
+        });
+
+        execute_test("ADV-13: Fuzzy Search Matches a Full Scan", 5, "fuzzyUsernameSearch at distances 0-3 returns exactly the users a Levenshtein scan over every name finds.", [&]() {
+            vector<unique_ptr<User>> members;
+            UserSearchEngineTester fuzzy_engine;
+            const vector<string> stems = {"anna", "ann", "hannah", "jo", "john", "jon", "joan", "smith", "smyth"};
+            for (int i = 0; i < 1500; ++i) {
+                members.push_back(make_unique<User>(i, stems[i % stems.size()] + to_string(i / 7)));
+                fuzzy_engine.addUser(members.back().get());
+            }
+            for (int id = 0; id < 1500; id += 5) fuzzy_engine.removeUser(id);
+            for (const string& query : {string("anna3"), string("jon12"), string("smith"), string("x"), string("")}) {
+                for (int maxDistance = 0; maxDistance <= 3; ++maxDistance) {
+                    set<int> found, scanned;
+                    for (User* user : fuzzy_engine.fuzzyUsernameSearch(query, maxDistance)) found.insert(user->userID);
+                    for (const auto& member : members)
+                        if (member->userID % 5 && classicEditDistance(query, member->userName) <= maxDistance) scanned.insert(member->userID);
+                    if (found != scanned) return false;
+                }
+            }
+            // an unbounded radius reaches every live user without overflowing the edge arithmetic
+            return fuzzy_engine.fuzzyUsernameSearch("anna3", -1).empty() && fuzzy_engine.fuzzyUsernameSearch("anna3", INT_MAX).size() == 1200 &&
+                   fuzzy_engine.isConsistent();
+        });
+
+        execute_test("ADV-14: Substring Search Matches a Full Scan", 5, "searchByUsernameSubstring returns the users whose names contain the pattern, in ID order, through single and batched adds and removes.", [&]() {
+            vector<unique_ptr<User>> members;
+            UserSearchEngineTester substring_engine;
+            const vector<string> stems = {"smith", "blacksmith", "smyth", "anna", "joanna", "jo_smith"};
+            vector<User*> batch;
+            for (int i = 0; i < 1200; ++i) {
+                members.push_back(make_unique<User>(1199 - i, stems[i % stems.size()] + to_string(i / 5)));
+                if (i < 600) substring_engine.addUser(members.back().get());
+                else batch.push_back(members.back().get());
+            }
+            substring_engine.addUsers(batch);
+            vector<int> dropped;
+            for (int id = 0; id < 1200; id += 7) dropped.push_back(id);
+            substring_engine.removeUsers(dropped);
+            for (int i = 3; i < 1200; i += 11) substring_engine.removeUser(members[i]->userName);
+            auto present = [&](const User* user) { return user->userID % 7 && (1199 - user->userID) % 11 != 3; };
+            for (const string& pattern : {string("smith"), string("nna1"), string("smith10"), string("mit"), string("h1"), string("_"),
+                                          string(""), string("zzz"), string("anna2")}) {
+                vector<int> found, scanned;
+                for (User* user : substring_engine.searchByUsernameSubstring(pattern)) found.push_back(user->userID);
+                for (const auto& member : members)
+                    if (present(member.get()) && member->userName.find(pattern) != string::npos) scanned.push_back(member->userID);
+                sort(scanned.begin(), scanned.end());
+                if (found != scanned) return false;
+            }
+            return substring_engine.isConsistent();
+        });
+
+        execute_test("ADV-15: Ranked Fuzzy Top-k", 5, "fuzzyTopK returns the first k fuzzy matches ranked by distance, shared prefix, then post count.", [&]() {
+            vector<unique_ptr<User>> members;
+            UserSearchEngineTester ranked_engine;
+            const vector<string> stems = {"jon", "john", "joan", "jo", "ojn", "jonas", "bjorn"};
+            for (int i = 0; i < 700; ++i) {
+                members.push_back(make_unique<User>(i, stems[i % stems.size()] + (i < 7 ? "" : to_string(i / 7))));
+                for (int post = 0; post < (i * 37) % 5; ++post) members.back()->addPost(i * 10 + post, "general");
+                ranked_engine.addUser(members.back().get());
+            }
+            for (const string& query : {string("jon"), string("john1"), string("jo"), string("bjorn4"), string("zz")}) {
+                for (int maxDistance = 0; maxDistance <= 3; ++maxDistance) {
+                    vector<User*> all = ranked_engine.fuzzyUsernameSearch(query, maxDistance);
+                    auto key = [&](User* user) {
+                        size_t shared = 0;
+                        while (shared < query.size() && shared < user->userName.size() && query[shared] == user->userName[shared]) shared++;
+                        return make_tuple(classicEditDistance(query, user->userName), -(long)shared, -(long)user->posts.size(), user->userID);
+                    };
+                    vector<pair<tuple<int, long, long, int>, User*>> keyed;
+                    for (User* user : all) keyed.emplace_back(key(user), user);
+                    sort(keyed.begin(), keyed.end());
+                    for (size_t k : {(size_t)0, (size_t)1, (size_t)5, (size_t)40, keyed.size() + 3}) {
+                        vector<User*> top = ranked_engine.fuzzyTopK(query, k, maxDistance);
+                        if (top.size() != std::min(k, keyed.size())) return false;
+                        for (size_t i = 0; i < top.size(); ++i)
+                            if (top[i] != keyed[i].second) return false;
+                    }
+                }
+            }
+            return true;
+        });
     }
 
     void test_dynamic_stress() {